@@ -25,6 +25,7 @@
 #include <iomanip>
 
 #include "pow/external_pow.h"
+#include "http/metrics_server.h"
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -182,8 +183,16 @@ int main_impl(int argc, char* argv[])
 #define LOG_FILES_DIR "logs"
 #define LOG_FILES_PREFIX "node_"
 
-		const auto path = boost::filesystem::system_complete(LOG_FILES_DIR);
-		auto logger = beam::Logger::create(logLevel, logLevel, fileLogLevel, LOG_FILES_PREFIX, path.string());
+		LoggerConfig logCfg;
+		logCfg.flushLevel = logLevel;
+		logCfg.consoleLevel = logLevel;
+		logCfg.fileLevel = fileLogLevel;
+		logCfg.filePrefix = LOG_FILES_PREFIX;
+		logCfg.filePath = boost::filesystem::system_complete(LOG_FILES_DIR).string();
+		logCfg.async = vm[cli::LOG_ASYNC].as<bool>();
+		logCfg.asyncOverflow = (vm[cli::LOG_ASYNC_OVERFLOW].as<string>() == "block") ? LoggerConfig::block : LoggerConfig::drop;
+
+		auto logger = beam::Logger::create(logCfg);
 
 		try
 		{
@@ -224,6 +233,12 @@ int main_impl(int argc, char* argv[])
 					stratumServer = IExternalPOW::create(powOptions, *reactor, io::Address().port(stratumPort), noncePrefixDigits);
 				}
 
+				std::unique_ptr<MetricsServer> metricsServer;
+				auto metricsPort = vm[cli::METRICS_PORT].as<uint16_t>();
+
+				if (metricsPort > 0)
+					metricsServer = std::make_unique<MetricsServer>(*reactor, io::Address().port(metricsPort));
+
 				{
 					beam::Node node;
 
@@ -322,6 +337,15 @@ int main_impl(int argc, char* argv[])
 					if (vm.count(cli::VACUUM))
 						node.m_Cfg.m_ProcessorParams.m_Vacuum = vm[cli::VACUUM].as<bool>();
 
+					if (vm.count(cli::DB_PROFILE))
+						node.m_Cfg.m_ProcessorParams.m_DbProfile = vm[cli::DB_PROFILE].as<bool>();
+
+					if (vm.count(cli::DB_SLOW_QUERY))
+						node.m_Cfg.m_ProcessorParams.m_DbSlowQuery_ms = vm[cli::DB_SLOW_QUERY].as<uint32_t>();
+
+					if (vm.count(cli::TX_POOL_SIZE))
+						node.m_Cfg.m_MaxPoolSize = uint64_t(vm[cli::TX_POOL_SIZE].as<uint32_t>()) * 1024 * 1024;
+
 					if (vm.count(cli::RESET_ID))
 						node.m_Cfg.m_ProcessorParams.m_ResetSelfID = vm[cli::RESET_ID].as<bool>();
 
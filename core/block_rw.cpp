@@ -501,7 +501,7 @@ namespace beam
 				return false;
 		}
 
-		return true;
+		return m_Parser.OnUtxosEnd();
 	}
 
 	bool RecoveryInfo::IParser::Context::ProceedShielded()
@@ -587,11 +587,68 @@ namespace beam
 
 	bool RecoveryInfo::IRecognizer::OnUtxo(Height h, const Output& outp)
 	{
-		if (m_pOwner)
+		if (!m_pOwner)
+			return true;
+
+		if (!m_pExecutor)
 		{
 			CoinID cid;
 			if (outp.Recover(h, *m_pOwner, cid))
 				return OnUtxoRecognized(h, outp, cid);
+
+			return true;
+		}
+
+		PendingUtxo& x = m_vPending.emplace_back();
+		x.m_Height = h;
+		x.m_pOutput = std::make_unique<Output>();
+		*x.m_pOutput = outp;
+
+		return (m_vPending.size() < s_BatchSize) || FlushUtxos();
+	}
+
+	bool RecoveryInfo::IRecognizer::OnUtxosEnd()
+	{
+		return FlushUtxos();
+	}
+
+	bool RecoveryInfo::IRecognizer::FlushUtxos()
+	{
+		if (m_vPending.empty())
+			return true;
+
+		struct MyTask
+			:public Executor::TaskSync
+		{
+			IRecognizer* m_pThis;
+
+			virtual void Exec(Executor::Context& ctx) override
+			{
+				std::vector<PendingUtxo>& v = m_pThis->m_vPending; // alias
+
+				uint32_t i0, nCount;
+				ctx.get_Portion(i0, nCount, static_cast<uint32_t>(v.size()));
+
+				for (nCount += i0; i0 < nCount; i0++)
+				{
+					PendingUtxo& x = v[i0];
+					x.m_Recognized = x.m_pOutput->Recover(x.m_Height, *m_pThis->m_pOwner, x.m_Cid);
+				}
+			}
+		};
+
+		MyTask t;
+		t.m_pThis = this;
+		m_pExecutor->ExecAll(t);
+
+		std::vector<PendingUtxo> v;
+		v.swap(m_vPending);
+
+		for (size_t i = 0; i < v.size(); i++)
+		{
+			PendingUtxo& x = v[i];
+			if (x.m_Recognized && !OnUtxoRecognized(x.m_Height, *x.m_pOutput, x.m_Cid))
+				return false;
 		}
 
 		return true;
@@ -15,6 +15,7 @@
 #pragma once
 #include "block_crypt.h"
 #include "radixtree.h"
+#include "../utility/executor.h"
 
 namespace beam
 {
@@ -55,6 +56,7 @@ namespace beam
 			virtual bool OnProgress(uint64_t nPos, uint64_t nTotal) { return true; }
 			virtual bool OnStates(std::vector<Block::SystemState::Full>&) { return true; }
 			virtual bool OnUtxo(Height, const Output&) { return true; }
+			virtual bool OnUtxosEnd() { return true; }
 			virtual bool OnShieldedOut(const ShieldedTxo::DescriptionOutp& , const ShieldedTxo&, const ECC::Hash::Value& hvMsg) { return true; }
 			virtual bool OnShieldedIn(const ShieldedTxo::DescriptionInp&) { return true; }
 			virtual bool OnAsset(Asset::Full&) { return true; }
@@ -70,13 +72,32 @@ namespace beam
 			Key::IPKdf::Ptr m_pOwner;
 			const ShieldedTxo::Viewer* m_pViewer = nullptr;
 
+			// Optional. If set - UTXOs are recognized in parallel, in batches.
+			// OnUtxoRecognized is still called in the original order, on the caller thread
+			Executor* m_pExecutor = nullptr;
+
 			virtual bool OnUtxo(Height, const Output&) override;
+			virtual bool OnUtxosEnd() override;
 			virtual bool OnShieldedOut(const ShieldedTxo::DescriptionOutp&, const ShieldedTxo&, const ECC::Hash::Value& hvMsg) override;
 			virtual bool OnAsset(Asset::Full&) override;
 
 			virtual bool OnUtxoRecognized(Height, const Output&, CoinID&) { return true; }
 			virtual bool OnShieldedOutRecognized(const ShieldedTxo::DescriptionOutp&, const ShieldedTxo::DataParams&) { return true; }
 			virtual bool OnAssetRecognized(Asset::Full&) { return true; }
+
+		private:
+			struct PendingUtxo
+			{
+				Height m_Height;
+				Output::Ptr m_pOutput;
+				CoinID m_Cid;
+				bool m_Recognized;
+			};
+
+			static const uint32_t s_BatchSize = 4096;
+			std::vector<PendingUtxo> m_vPending;
+
+			bool FlushUtxos();
 		};
 	};
 
@@ -23,6 +23,10 @@
 #	include <unistd.h>
 #endif // WIN32
 
+#ifdef __linux__
+#	define BEAM_MAPPED_FILE_JOURNAL
+#endif // __linux__
+
 namespace beam
 {
 	void test_SysRet(bool bFail, const char* str)
@@ -65,9 +69,11 @@ namespace beam
 		m_hFile = INVALID_HANDLE_VALUE;
 #else // WIN32
 		m_hFile = -1;
+		m_hJournal = -1;
 #endif // WIN32
 
 		m_nBanks = 0;
+		m_vJournal.clear();
 	}
 
 	void MappedFile::ResetVarsMapping()
@@ -110,6 +116,8 @@ namespace beam
 #else // WIN32
 		if (-1 != m_hFile)
             BEAM_VERIFY(!close(m_hFile));
+		if (-1 != m_hJournal)
+            BEAM_VERIFY(!close(m_hJournal));
 #endif // WIN32
 
 		ResetVarsFile();
@@ -139,7 +147,8 @@ namespace beam
 
 		if (m_nMapping)
 		{
-			uint8_t* pPtr = (uint8_t*) mmap(NULL, m_nMapping, PROT_READ | PROT_WRITE, MAP_SHARED, m_hFile, 0);
+			int nFlags = IsJournaled() ? MAP_PRIVATE : MAP_SHARED;
+			uint8_t* pPtr = (uint8_t*) mmap(NULL, m_nMapping, PROT_READ | PROT_WRITE, nFlags, m_hFile, 0);
 			test_SysRet(MAP_FAILED == pPtr, "mmap");
 
 			m_pMapping = pPtr;
@@ -202,7 +211,34 @@ namespace beam
 #endif // WIN32
 	}
 
+	void MappedFile::Grow(Offset n)
+	{
+#ifdef BEAM_MAPPED_FILE_JOURNAL
+		if (IsJournaled())
+		{
+			// unmapping would discard the private pages
+			Resize(n);
+
+			uint8_t* pPtr = (uint8_t*) mremap(m_pMapping, m_nMapping, n, MREMAP_MAYMOVE);
+			test_SysRet(MAP_FAILED == pPtr, "mremap");
+
+			m_pMapping = pPtr;
+			m_nMapping = n;
+			return;
+		}
+#endif // BEAM_MAPPED_FILE_JOURNAL
+
+		CloseMapping();
+		Resize(n);
+		OpenMapping();
+	}
+
 	void MappedFile::Open(const char* sz, const Defs& d, bool bReset /* = false */)
+	{
+		Open(sz, d, bReset, nullptr, Blob(nullptr, 0));
+	}
+
+	void MappedFile::Open(const char* sz, const Defs& d, bool bReset, const char* szJournal, const Blob& tag)
 	{
 		Close();
 
@@ -225,6 +261,9 @@ namespace beam
 		test_SysRet(-1 == m_hFile, "open");
 #endif // WIN32
 
+		if (szJournal)
+			OpenJournal(szJournal, tag);
+
 		OpenMapping();
 
 		uint32_t nSizeMin = d.get_SizeMin();
@@ -274,9 +313,7 @@ namespace beam
 
 			nSize = AlignUp(nSize, sizeof(Offset));
 
-			CloseMapping();
-			Resize(n1);
-			OpenMapping();
+			Grow(n1);
 
 			Bank& b = get_Bank(iBank);
 			Offset* p = &b.m_Tail;
@@ -326,4 +363,239 @@ namespace beam
 		b.m_Free++;
 	}
 
+	void MappedFile::Flush()
+	{
+		if (!m_pMapping)
+			return;
+
+#ifdef WIN32
+		test_SysRet(!FlushViewOfFile(m_pMapping, 0), "FlushViewOfFile");
+		test_SysRet(!FlushFileBuffers(m_hFile), "FlushFileBuffers");
+#else // WIN32
+		test_SysRet(msync(m_pMapping, m_nMapping, MS_SYNC) != 0, "msync");
+#endif // WIN32
+	}
+
+	////////////////////////////////////////
+	// Journal
+	//
+	// Layout: JournalHdr, followed by the Ranges, each followed by its data.
+	// The header is written (and synced) last, hence the journal is valid only if it was completely written
+
+	struct MappedFile::JournalHdr
+	{
+		static const uint64_t s_Magic = 0x4c4e524a4d414542ULL;
+		static const uint32_t s_TagMax = 0x40;
+
+		uint64_t m_Magic;
+		Offset m_Ranges;
+		uint32_t m_nTag;
+		uint8_t m_pTag[s_TagMax];
+
+		bool IsValid(const Blob& tag) const
+		{
+			return
+				(s_Magic == m_Magic) &&
+				(m_nTag == tag.n) &&
+				!memcmp(m_pTag, tag.p, tag.n);
+		}
+	};
+
+	bool MappedFile::IsJournaled() const
+	{
+#ifdef BEAM_MAPPED_FILE_JOURNAL
+		return -1 != m_hJournal;
+#else // BEAM_MAPPED_FILE_JOURNAL
+		return false;
+#endif // BEAM_MAPPED_FILE_JOURNAL
+	}
+
+#ifdef BEAM_MAPPED_FILE_JOURNAL
+
+	static void WriteAll(int h, const void* p, uint64_t n, uint64_t nPos)
+	{
+		while (n)
+		{
+			ssize_t nDone = pwrite(h, p, n, nPos);
+			test_SysRet(nDone <= 0, "pwrite");
+
+			p = ((const uint8_t*) p) + nDone;
+			n -= nDone;
+			nPos += nDone;
+		}
+	}
+
+	static void ReadAll(int h, void* p, uint64_t n, uint64_t nPos)
+	{
+		while (n)
+		{
+			ssize_t nDone = pread(h, p, n, nPos);
+			test_SysRet(nDone <= 0, "pread");
+
+			p = ((uint8_t*) p) + nDone;
+			n -= nDone;
+			nPos += nDone;
+		}
+	}
+
+	void MappedFile::OpenJournal(const char* szJournal, const Blob& tag)
+	{
+		assert(tag.n <= JournalHdr::s_TagMax);
+
+		// dirty pages are detected via pagemap. If it's not accessible - stay in the regular mode
+		int hPagemap = open("/proc/self/pagemap", O_RDONLY);
+		if (-1 == hPagemap)
+			return;
+		BEAM_VERIFY(!close(hPagemap));
+
+		m_hJournal = open(szJournal, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP);
+		test_SysRet(-1 == m_hJournal, "open");
+
+		JournalHdr hdr;
+		if ((pread(m_hJournal, &hdr, sizeof(hdr), 0) == sizeof(hdr)) && hdr.IsValid(tag))
+			ReplayJournal(hdr);
+
+		ResetJournal();
+	}
+
+	void MappedFile::ReplayJournal(const JournalHdr& hdr)
+	{
+		std::vector<uint8_t> vBuf;
+		Offset nPos = sizeof(hdr);
+
+		for (Offset i = 0; i < hdr.m_Ranges; i++)
+		{
+			Range r;
+			ReadAll(m_hJournal, &r, sizeof(r), nPos);
+			nPos += sizeof(r);
+
+			vBuf.resize(static_cast<size_t>(r.m_Size));
+			ReadAll(m_hJournal, vBuf.data(), r.m_Size, nPos);
+			nPos += r.m_Size;
+
+			WriteAll(m_hFile, vBuf.data(), r.m_Size, r.m_Pos);
+		}
+
+		test_SysRet(fdatasync(m_hFile) != 0, "fdatasync");
+	}
+
+	void MappedFile::ResetJournal()
+	{
+		test_SysRet(ftruncate(m_hJournal, 0) != 0, "ftruncate");
+		test_SysRet(fsync(m_hJournal) != 0, "fsync");
+
+		m_vJournal.clear();
+	}
+
+	void MappedFile::get_DirtyRanges(std::vector<Range>& v) const
+	{
+		v.clear();
+		if (!m_pMapping)
+			return;
+
+		int h = open("/proc/self/pagemap", O_RDONLY);
+		test_SysRet(-1 == h, "open");
+
+		// 64-bit entry per virtual page. The private copy of a page is either present and not file-backed, or swapped
+		const uint64_t nPresent = 1ULL << 63;
+		const uint64_t nSwapped = 1ULL << 62;
+		const uint64_t nFilePage = 1ULL << 61;
+
+		uint64_t iPage0 = reinterpret_cast<uintptr_t>(m_pMapping) / s_PageSize;
+		uint64_t nPages = (m_nMapping + s_PageSize - 1) / s_PageSize;
+
+		uint64_t pBuf[0x400];
+		bool bFail = false;
+
+		for (uint64_t i = 0; i < nPages; )
+		{
+			uint64_t n = std::min<uint64_t>(nPages - i, _countof(pBuf));
+
+			bFail = (pread(h, pBuf, n * sizeof(*pBuf), (iPage0 + i) * sizeof(*pBuf)) != static_cast<ssize_t>(n * sizeof(*pBuf)));
+			if (bFail)
+				break;
+
+			for (uint64_t j = 0; j < n; j++)
+			{
+				uint64_t x = pBuf[j];
+				if (!((nSwapped & x) || ((nPresent & x) && !(nFilePage & x))))
+					continue;
+
+				Offset nPos = (i + j) * s_PageSize;
+				if (!v.empty() && (v.back().m_Pos + v.back().m_Size == nPos))
+					v.back().m_Size += s_PageSize;
+				else
+					v.push_back({ nPos, s_PageSize });
+			}
+
+			i += n;
+		}
+
+		BEAM_VERIFY(!close(h));
+		test_SysRet(bFail, "pread");
+
+		if (!v.empty())
+		{
+			// the last page may be partial
+			Range& r = v.back();
+			std::setmin(r.m_Size, m_nMapping - r.m_Pos);
+		}
+	}
+
+	void MappedFile::PrepareCommit(const Blob& tag)
+	{
+		assert(IsJournaled() && (tag.n <= JournalHdr::s_TagMax));
+
+		get_DirtyRanges(m_vJournal);
+
+		Offset nPos = sizeof(JournalHdr);
+		for (const Range& r : m_vJournal)
+		{
+			WriteAll(m_hJournal, &r, sizeof(r), nPos);
+			nPos += sizeof(r);
+
+			WriteAll(m_hJournal, m_pMapping + r.m_Pos, r.m_Size, nPos);
+			nPos += r.m_Size;
+		}
+
+		test_SysRet(fdatasync(m_hJournal) != 0, "fdatasync");
+
+		JournalHdr hdr;
+		ZeroObject(hdr);
+		hdr.m_Magic = JournalHdr::s_Magic;
+		hdr.m_Ranges = m_vJournal.size();
+		hdr.m_nTag = tag.n;
+		memcpy(hdr.m_pTag, tag.p, tag.n);
+
+		WriteAll(m_hJournal, &hdr, sizeof(hdr), 0);
+		test_SysRet(fdatasync(m_hJournal) != 0, "fdatasync");
+	}
+
+	void MappedFile::Commit()
+	{
+		assert(IsJournaled());
+
+		for (const Range& r : m_vJournal)
+			WriteAll(m_hFile, m_pMapping + r.m_Pos, r.m_Size, r.m_Pos);
+
+		test_SysRet(fdatasync(m_hFile) != 0, "fdatasync");
+
+		// drop the private copies, the file has the same data now
+		for (const Range& r : m_vJournal)
+			test_SysRet(madvise(m_pMapping + r.m_Pos, r.m_Size, MADV_DONTNEED) != 0, "madvise");
+
+		ResetJournal();
+	}
+
+#else // BEAM_MAPPED_FILE_JOURNAL
+
+	void MappedFile::OpenJournal(const char*, const Blob&) {}
+	void MappedFile::ReplayJournal(const JournalHdr&) {}
+	void MappedFile::ResetJournal() {}
+	void MappedFile::get_DirtyRanges(std::vector<Range>&) const {}
+	void MappedFile::PrepareCommit(const Blob&) { assert(false); }
+	void MappedFile::Commit() { assert(false); }
+
+#endif // BEAM_MAPPED_FILE_JOURNAL
+
 } // namespace beam
@@ -37,6 +37,7 @@ namespace beam
 		HANDLE m_hMapping;
 #else // WIN32
 		int m_hFile;
+		int m_hJournal; // journaled mode, the mapping is private
 #endif // WIN32
 
 		Offset m_nMapping;
@@ -51,8 +52,23 @@ namespace beam
 		//void Write(const void*, uint32_t);
 		//void WriteZero(uint32_t);
 		void Resize(Offset);
+		void Grow(Offset);
 		Bank& get_Bank(uint32_t iBank);
 
+		// journaled mode
+		struct JournalHdr;
+		struct Range
+		{
+			Offset m_Pos;
+			Offset m_Size;
+		};
+		std::vector<Range> m_vJournal; // saved to the journal, yet to be written to the file
+
+		void OpenJournal(const char* szJournal, const Blob& tag);
+		void ReplayJournal(const JournalHdr&);
+		void ResetJournal();
+		void get_DirtyRanges(std::vector<Range>&) const;
+
 	public:
 
 		MappedFile();
@@ -72,6 +88,19 @@ namespace beam
 		void Open(const char* sz, const Defs&, bool bReset = false);
 		void Close();
 
+		// Journaled (crash-consistent) mode, linux only. Elsewhere it's the same as the regular Open.
+		// The modifications are kept in private (copy-on-write) pages, and reach the file only via PrepareCommit + Commit.
+		// PrepareCommit saves the dirty pages to the journal, which is replayed on the next Open if interrupted,
+		// but only if it's tagged with the expected value (i.e. the commit was confirmed by the caller).
+		void Open(const char* sz, const Defs&, bool bReset, const char* szJournal, const Blob& tag);
+		bool IsJournaled() const;
+
+		void PrepareCommit(const Blob& tag);
+		void Commit();
+
+		// regular mode: make sure all the modifications are written to the file
+		void Flush();
+
 		void* get_FixedHdr() const;
 
 		template <typename T> T& get_At(Offset n) const
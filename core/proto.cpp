@@ -150,6 +150,16 @@ void InitCipherIV(AES::StreamCipher& c, const ECC::Hash::Value& hvSecret, const
     c.m_nBuf = 0;
 }
 
+void InitViaSharedSecret(const ECC::Point::Native& ptSecret, AES::Encoder& enc, ECC::Hash::Mac& hmac, ECC::Hash::Value& hvSecret)
+{
+    ECC::Hash::Processor() << ptSecret >> hvSecret;
+
+    static_assert(AES::s_KeyBytes == ECC::Hash::Value::nBytes, "");
+    enc.Init(hvSecret.m_pData);
+
+    hmac.Reset(hvSecret.m_pData, hvSecret.nBytes);
+}
+
 bool InitViaDiffieHellman(const ECC::Scalar::Native& myPrivate, const PeerID& remotePublic, AES::Encoder& enc, ECC::Hash::Mac& hmac, AES::StreamCipher* pCipherOut, AES::StreamCipher* pCipherIn)
 {
     // Diffie-Hellman
@@ -160,12 +170,7 @@ bool InitViaDiffieHellman(const ECC::Scalar::Native& myPrivate, const PeerID& re
     ECC::Point::Native ptSecret = p * myPrivate;
 
     ECC::NoLeak<ECC::Hash::Value> hvSecret;
-    ECC::Hash::Processor() << ptSecret >> hvSecret.V;
-
-    static_assert(AES::s_KeyBytes == ECC::Hash::Value::nBytes, "");
-    enc.Init(hvSecret.V.m_pData);
-
-    hmac.Reset(hvSecret.V.m_pData, hvSecret.V.nBytes);
+    InitViaSharedSecret(ptSecret, enc, hmac, hvSecret.V);
 
     if (pCipherOut)
         InitCipherIV(*pCipherOut, hvSecret.V, remotePublic);
@@ -245,6 +250,75 @@ bool Bbs::Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAd
     return (hvMac == hvMac2);
 }
 
+Bbs::Decryptor::Decryptor(const uint8_t* p, uint32_t n)
+    :m_pMsg(p)
+    ,m_nMsg(n)
+{
+    m_Valid = false;
+
+    PeerID remotePublic;
+    if (n < remotePublic.nBytes + ECC::Hash::Value::nBytes)
+        return;
+
+    memcpy(remotePublic.m_pData, p, remotePublic.nBytes);
+    m_Valid = remotePublic.ExportNnz(m_ptRemote);
+}
+
+Bbs::Decryptor::~Decryptor()
+{
+}
+
+bool Bbs::Decryptor::Decrypt(ByteBuffer& res, const ECC::Scalar::Native& privateAddr, const PeerID& publicAddr)
+{
+    if (!m_Valid)
+        return false;
+
+    ECC::Point::Native ptSecret;
+
+    if (!m_pPrepared && (++m_Attempts > s_AttemptsBeforePrepare))
+    {
+        // the same point is multiplied by many keys, worth to precalculate
+        ECC::Hash::Value hvSeed;
+        ECC::GenRandom(hvSeed);
+
+        ECC::Oracle oracle;
+        oracle << hvSeed;
+
+        ECC::Point::Compact::Converter cpc;
+        m_pPrepared = std::make_unique<ECC::Generator::Obscured>();
+        m_pPrepared->Initialize(m_ptRemote, oracle, cpc);
+        cpc.Flush();
+    }
+
+    if (m_pPrepared)
+        ptSecret = *m_pPrepared * privateAddr;
+    else
+        ptSecret = m_ptRemote * privateAddr;
+
+    AES::Encoder enc;
+    AES::StreamCipher cIn;
+    ECC::Hash::Mac hmac;
+    ECC::NoLeak<ECC::Hash::Value> hvSecret;
+    InitViaSharedSecret(ptSecret, enc, hmac, hvSecret.V);
+    InitCipherIV(cIn, hvSecret.V, publicAddr);
+
+    // mac followed by the plaintext
+    res.assign(m_pMsg + PeerID::nBytes, m_pMsg + m_nMsg);
+    cIn.XCrypt(enc, &res.front(), static_cast<uint32_t>(res.size()));
+
+    ECC::Hash::Value hvMac, hvMac2;
+    memcpy(hvMac.m_pData, &res.front(), hvMac.nBytes);
+
+    hmac.Write(&res.front() + hvMac.nBytes, static_cast<uint32_t>(res.size() - hvMac.nBytes));
+    hmac >> hvMac2;
+
+    if (hvMac != hvMac2)
+        return false;
+
+    res.erase(res.begin(), res.begin() + hvMac.nBytes);
+    return true;
+}
+
 void Bbs::get_HashPartial(ECC::Hash::Processor& hp, const BbsMsg& msg)
 {
 	hp
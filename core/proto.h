@@ -545,6 +545,27 @@ namespace proto {
 
 		bool Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void*, uint32_t); // will fail iff addr is invalid
 		bool Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr);
+
+		// Decrypts the same message with many candidate keys (own addresses on the channel).
+		// After several failed attempts the sender point is prepared for multiplication, then each attempt is several times faster.
+		class Decryptor
+		{
+			const uint8_t* m_pMsg;
+			uint32_t m_nMsg;
+			bool m_Valid;
+			uint32_t m_Attempts = 0;
+			ECC::Point::Native m_ptRemote;
+			std::unique_ptr<ECC::Generator::Obscured> m_pPrepared;
+
+		public:
+			static const uint32_t s_AttemptsBeforePrepare = 12; // preparation costs roughly as much as 10 attempts
+
+			Decryptor(const uint8_t* p, uint32_t n);
+			~Decryptor();
+
+			// publicAddr must correspond to privateAddr. On success res contains the plaintext
+			bool Decrypt(ByteBuffer& res, const ECC::Scalar::Native& privateAddr, const PeerID& publicAddr);
+		};
 	};
 
 	struct TxStatus
@@ -14,6 +14,7 @@
 
 #include "radixtree.h"
 #include "ecc_native.h"
+#include <atomic>
 
 namespace beam {
 
@@ -507,6 +508,74 @@ const Merkle::Hash& RadixHashTree::get_Hash(Node& n, Merkle::Hash& hv)
 	return x.m_Hash;
 }
 
+void RadixHashTree::EvaluateHashes(Executor& ex)
+{
+	Node* pRoot = get_Root();
+	if (!pRoot || (Node::s_Clean & pRoot->m_Bits))
+		return;
+
+	OnDirty(); // once, before the threads
+
+	// split into the disjoint subtrees, several per thread for better balance.
+	// Leaves and clean nodes on the way are left for the final pass
+	std::vector<Node*> v, v2;
+	v.push_back(pRoot);
+
+	size_t nMin = static_cast<size_t>(ex.get_Threads()) * 0x10;
+
+	while (v.size() < nMin)
+	{
+		v2.clear();
+
+		for (Node* p : v)
+		{
+			if ((Node::s_Clean | Node::s_Leaf) & p->m_Bits)
+				continue;
+
+			Joint& x = Cast::Up<Joint>(*p);
+			for (size_t i = 0; i < _countof(x.m_ppC); i++)
+				v2.push_back(x.m_ppC[i].get_Strict());
+		}
+
+		if (v2.empty())
+			break;
+
+		v.swap(v2);
+	}
+
+	struct MyTask
+		:public Executor::TaskSync
+	{
+		RadixHashTree* m_pThis;
+		const std::vector<Node*>* m_pV;
+		std::atomic<size_t> m_iNext;
+
+		virtual void Exec(Executor::Context&) override
+		{
+			while (true)
+			{
+				size_t i = m_iNext++;
+				if (i >= m_pV->size())
+					break;
+
+				Merkle::Hash hv;
+				m_pThis->get_Hash(*m_pV->at(i), hv);
+			}
+		}
+	};
+
+	MyTask t;
+	t.m_pThis = this;
+	t.m_pV = &v;
+	t.m_iNext = 0;
+
+	ex.ExecAll(t);
+
+	// the top levels
+	Merkle::Hash hv;
+	get_Hash(hv);
+}
+
 void RadixHashTree::get_Proof(Merkle::Proof& proof, const CursorBase& cu)
 {
 	uint16_t n = cu.get_Depth();
@@ -864,7 +933,10 @@ bool UtxoTreeMapped::Open(const char* sz, const Stamp& s)
 	d.m_nBanks = Type::count;
 	d.m_nFixedHdr = sizeof(Hdr);
 
-	m_Mapping.Open(sz, d);
+	// the journal of an interrupted checkpoint is replayed only if it has the expected stamp
+	std::string sJournal = std::string(sz) + ".journal";
+
+	m_Mapping.Open(sz, d, false, sJournal.c_str(), s);
 
 	Hdr& h = get_Hdr();
 	if (!h.m_Dirty && (h.m_Stamp == s))
@@ -873,7 +945,7 @@ bool UtxoTreeMapped::Open(const char* sz, const Stamp& s)
 		return true;
 	}
 
-	m_Mapping.Open(sz, d, true); // reset
+	m_Mapping.Open(sz, d, true, sJournal.c_str(), s); // reset
 	return false;
 }
 
@@ -888,18 +960,39 @@ UtxoTreeMapped::Hdr& UtxoTreeMapped::get_Hdr()
 	return *static_cast<Hdr*>(m_Mapping.get_FixedHdr());
 }
 
-void UtxoTreeMapped::FlushStrict(const Stamp& s)
+void UtxoTreeMapped::SetClean(const Stamp& s)
 {
 	Hdr& h = get_Hdr();
 	assert(h.m_Dirty);
 
 	h.m_Dirty = 0;
 	h.m_Root = m_RootOffset;
-	// TODO: flush
-
 	h.m_Stamp = s;
 }
 
+void UtxoTreeMapped::PrepareFlush(const Stamp& s)
+{
+	if (m_Mapping.IsJournaled())
+	{
+		// the clean header goes to the journal along with the data
+		SetClean(s);
+		m_Mapping.PrepareCommit(s);
+	}
+	else
+		m_Mapping.Flush(); // the header on disk is still dirty
+}
+
+void UtxoTreeMapped::FlushStrict(const Stamp& s)
+{
+	if (m_Mapping.IsJournaled())
+		m_Mapping.Commit();
+	else
+	{
+		SetClean(s);
+		m_Mapping.Flush();
+	}
+}
+
 void UtxoTreeMapped::EnsureReserve()
 {
 	try
@@ -920,7 +1013,14 @@ void UtxoTreeMapped::EnsureReserve()
 
 void UtxoTreeMapped::OnDirty()
 {
-	get_Hdr().m_Dirty = 1;
+	Hdr& h = get_Hdr();
+	if (h.m_Dirty)
+		return;
+
+	h.m_Dirty = 1;
+
+	if (!m_Mapping.IsJournaled())
+		m_Mapping.Flush(); // should reach the disk before the modifications
 }
 
 intptr_t UtxoTreeMapped::get_Base() const
@@ -16,6 +16,7 @@
 
 #include "block_crypt.h"
 #include "mapped_file.h"
+#include "../utility/executor.h"
 
 namespace beam
 {
@@ -190,6 +191,9 @@ public:
 	void get_Hash(Merkle::Hash&);
 	void get_Proof(Merkle::Proof&, const CursorBase&);
 
+	// Evaluates the dirty subtrees in parallel, the subsequent get_Hash is then immediate
+	void EvaluateHashes(Executor&);
+
 protected:
 	// RadixTree
 	virtual Joint* CreateJoint() override { return new MyJoint; }
@@ -403,6 +407,8 @@ protected:
 	virtual MyLeaf::IDNode* CreateIDNode() override;
 	virtual void DeleteIDNode(MyLeaf::IDNode*) override;
 
+	void SetClean(const Merkle::Hash&);
+
 public:
 
 	virtual void OnDirty() override;
@@ -413,8 +419,14 @@ public:
 
 	bool Open(const char* sz, const Stamp&);
 	bool IsOpen() const { return m_Mapping.get_Base() != nullptr; }
+	bool IsJournaled() const { return m_Mapping.IsJournaled(); }
 
 	void Close();
+
+	// Checkpoint. PrepareFlush should be called before the stamp is committed to the DB, FlushStrict - after.
+	// Where the journaled mapping is supported the image on disk always corresponds to some checkpoint,
+	// otherwise it's just msync'ed, and remains dirty on disk in-between.
+	void PrepareFlush(const Stamp&);
 	void FlushStrict(const Stamp&);
 
 	void EnsureReserve();
@@ -1560,6 +1560,33 @@ void TestBbs()
 	n = (uint32_t) buf.size();
 
 	verify_test(!beam::proto::Bbs::Decrypt(p, n, privateAddr));
+
+	// many candidate keys, the matching one is tried after the remote point is prepared
+	Scalar::Native privateAddr2;
+	SetRandom(privateAddr2);
+	publicAddr.FromSk(privateAddr2);
+
+	SetRandom(nonce);
+	verify_test(beam::proto::Bbs::Encrypt(buf, publicAddr, nonce, szMsg, sizeof(szMsg)));
+
+	beam::proto::Bbs::Decryptor dec(&buf.front(), (uint32_t) buf.size());
+	beam::ByteBuffer bufRes;
+
+	for (uint32_t i = 0; i < beam::proto::Bbs::Decryptor::s_AttemptsBeforePrepare * 2; i++)
+	{
+		beam::PeerID pid;
+		SetRandom(privateAddr);
+		pid.FromSk(privateAddr);
+		verify_test(!dec.Decrypt(bufRes, privateAddr, pid));
+	}
+
+	verify_test(dec.Decrypt(bufRes, privateAddr2, publicAddr));
+	verify_test(bufRes.size() == sizeof(szMsg));
+	verify_test(!memcmp(&bufRes.front(), szMsg, sizeof(szMsg)));
+
+	beam::proto::Bbs::Decryptor dec2(&buf.front(), (uint32_t) buf.size());
+	verify_test(dec2.Decrypt(bufRes, privateAddr2, publicAddr));
+	verify_test(!memcmp(&bufRes.front(), szMsg, sizeof(szMsg)));
 }
 
 void TestRatio(const beam::Difficulty& d0, const beam::Difficulty& d1, double k)
@@ -2651,6 +2678,68 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	for (uint32_t nAddrs = 1; nAddrs <= 1000; nAddrs *= 10)
+	{
+		// bbs message, decrypted by a wallet with nAddrs addresses on the channel. None matches (worst case)
+		std::vector<Scalar::Native> vSk(nAddrs);
+		std::vector<beam::PeerID> vPk(nAddrs);
+		for (uint32_t i = 0; i < nAddrs; i++)
+		{
+			SetRandom(vSk[i]);
+			vPk[i].FromSk(vSk[i]);
+		}
+
+		Scalar::Native nonce;
+		SetRandom(nonce);
+		beam::PeerID pid;
+		pid.FromSk(k1);
+
+		uint8_t pMsg[0x100];
+		GenRandom(pMsg, sizeof(pMsg));
+
+		beam::ByteBuffer buf, buf2;
+		verify_test(beam::proto::Bbs::Encrypt(buf, pid, nonce, pMsg, sizeof(pMsg)));
+
+		char szName[0x40];
+		snprintf(szName, sizeof(szName), "Bbs.Decrypt x%u", nAddrs);
+
+		{
+			BenchmarkMeter bm(szName);
+			bm.N = 1;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+				{
+					for (uint32_t j = 0; j < nAddrs; j++)
+					{
+						buf2 = buf;
+						uint8_t* p = &buf2.front();
+						uint32_t n = (uint32_t) buf2.size();
+						verify_test(!beam::proto::Bbs::Decrypt(p, n, vSk[j]));
+					}
+				}
+
+			} while (bm.ShouldContinue());
+		}
+
+		snprintf(szName, sizeof(szName), "Bbs.Decryptor x%u", nAddrs);
+
+		{
+			BenchmarkMeter bm(szName);
+			bm.N = 1;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+				{
+					beam::proto::Bbs::Decryptor dec(&buf.front(), (uint32_t) buf.size());
+					for (uint32_t j = 0; j < nAddrs; j++)
+						verify_test(!dec.Decrypt(buf2, vSk[j], vPk[j]));
+				}
+
+			} while (bm.ShouldContinue());
+		}
+	}
+
 }
 
 
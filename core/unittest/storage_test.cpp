@@ -239,6 +239,100 @@ namespace beam
 			SetLeafID(x.m_ID, i, bTest);
 	}
 
+	void TestUtxoTreeMapped()
+	{
+#ifdef WIN32
+		const char* sz = "mytest-utxo.bin";
+#else // WIN32
+		const char* sz = "/tmp/mytest-utxo.bin";
+#endif // WIN32
+
+		std::string sJournal = std::string(sz) + ".journal";
+
+		DeleteFile(sz);
+		DeleteFile(sJournal.c_str());
+
+		UtxoTreeMapped::Stamp s0, s1, s2;
+		s0 = 1U;
+		s1 = 2U;
+		s2 = 3U;
+
+		UtxoTreeMapped t;
+		Merkle::Hash hv0, hv1, hv;
+
+		auto fnAdd = [&t](uint32_t n)
+		{
+			for (uint32_t i = 0; i < n; i++)
+			{
+				UtxoTree::Key::Data d;
+				SetRandomUtxoKey(d);
+
+				UtxoTree::Key key;
+				key = d;
+
+				t.EnsureReserve(); // the mapping may move
+
+				UtxoTree::Cursor cu;
+				bool bCreate = true;
+				UtxoTree::MyLeaf* p = t.Find(cu, key, bCreate);
+
+				verify_test(p && bCreate);
+				p->m_ID = i;
+			}
+		};
+
+		auto fnReopen = [&t, &hv, sz](const UtxoTreeMapped::Stamp& s)
+		{
+			t.Close();
+			if (!t.Open(sz, s))
+				return false;
+
+			t.get_Hash(hv);
+			return true;
+		};
+
+		verify_test(!t.Open(sz, s0));
+		fnAdd(5000);
+		t.get_Hash(hv0);
+
+		t.PrepareFlush(s0);
+		t.FlushStrict(s0);
+
+		verify_test(fnReopen(s0) && (hv == hv0));
+
+		if (t.IsJournaled())
+		{
+			// modifications after the checkpoint are discarded
+			fnAdd(3000);
+			t.get_Hash(hv1);
+			verify_test(fnReopen(s0) && (hv == hv0));
+
+			// interrupted before the new stamp was committed
+			fnAdd(3000);
+			t.get_Hash(hv1);
+			t.PrepareFlush(s1);
+			verify_test(fnReopen(s0) && (hv == hv0));
+
+			// interrupted after the new stamp was committed, the journal is replayed
+			fnAdd(3000);
+			t.get_Hash(hv1);
+			t.PrepareFlush(s1);
+			verify_test(fnReopen(s1) && (hv == hv1));
+		}
+		else
+		{
+			hv1 = hv0;
+			s1 = s0;
+		}
+
+		verify_test(fnReopen(s1) && (hv == hv1));
+		verify_test(!fnReopen(s2));
+
+		t.Close();
+		DeleteFile(sz);
+		DeleteFile(sJournal.c_str());
+	}
+
 	void TestUtxoTree()
 	{
 		std::vector<UtxoTree::Key> vKeys;
@@ -354,6 +448,12 @@ namespace beam
 
 		t.load(der);
 
+		{
+			ExecutorMT_Std ex;
+			ex.m_Threads = 4;
+			t.EvaluateHashes(ex);
+		}
+
 		t.get_Hash(hv2);
 		verify_test(hv2 == hv1);
 
@@ -675,6 +775,7 @@ int main()
 {
 	beam::TestNavigator();
 	beam::TestUtxoTree();
+	beam::TestUtxoTreeMapped();
 	beam::TestMmr();
 
 	return g_TestsFailed ? -1 : 0;
@@ -13,13 +13,21 @@
 // limitations under the License.
 
 #include "adapter.h"
+#include "block_cache.h"
+#include "indexer.h"
 #include "node/node.h"
 #include "core/serialization_adapters.h"
 #include "http/http_msg_creator.h"
 #include "http/http_json_serializer.h"
-#include "nlohmann/json.hpp"
+#include "utility/io/json_writer.h"
+#include "utility/io/asyncevent.h"
+#include "utility/io/timer.h"
 #include "utility/helpers.h"
 #include "utility/logger.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 namespace beam { namespace explorer {
 
@@ -27,6 +35,13 @@ namespace {
 
 static const size_t PACKER_FRAGMENTS_SIZE = 4096;
 static const size_t CACHE_DEPTH = 100000;
+static const unsigned MAX_WORKERS = 4;
+static const unsigned PREFETCH_DELAY_MSEC = 200; // after the node commits the new blocks
+static const Height MAX_PREFETCH = 100;
+static const unsigned INDEX_SYNC_DELAY_MSEC = 10; // between the batches, not to block the node
+static const Height INDEX_SYNC_BATCH = 200;
+static const uint64_t DEFAULT_PAGE_SIZE = 100;
+static const uint64_t MAX_PAGE_SIZE = 1000;
 
 const char* hash_to_hex(char* buf, const Merkle::Hash& hash) {
     return to_hex(buf, hash.m_pData, hash.nBytes);
@@ -48,8 +63,13 @@ const char* difficulty_to_hex(char* buf, const Difficulty& d) {
 }
 
 struct ResponseCache {
+    struct Block {
+        Merkle::Hash hash; // the cached block is valid only as long as it's the active one
+        io::SharedBuffer body;
+    };
+
     io::SharedBuffer status;
-    std::map<Height, io::SharedBuffer> blocks;
+    std::map<Height, Block> blocks;
     Height currentHeight=0;
 
     explicit ResponseCache(size_t depth) : _depth(depth)
@@ -71,49 +91,93 @@ struct ResponseCache {
         blocks.erase(b, it);
     }
 
-    bool get_block(io::SerializedMsg& out, Height h) {
+    bool get_block(io::SerializedMsg& out, Height h, const Merkle::Hash& hash) {
         const auto& it = blocks.find(h);
-        if (it == blocks.end()) return false;
-        out.push_back(it->second);
+        if (it == blocks.end() || it->second.hash != hash) return false;
+        out.push_back(it->second.body);
         return true;
     }
 
-    void put_block(Height h, const io::SharedBuffer& body) {
-        if (currentHeight - h > _depth) return;
+    void put_block(Height h, const Merkle::Hash& hash, const io::SharedBuffer& body) {
+        // a worker may extract a block the status isn't updated to yet
+        if (h > currentHeight || currentHeight - h > _depth) return;
         compact();
-        blocks[h] = body;
+        auto& b = blocks[h];
+        b.hash = hash;
+        b.body = body;
     }
 
 private:
     size_t _depth;
 };
 
-using nlohmann::json;
-
 } //namespace
 
-/// Explorer server backend, gets callback on status update and returns json messages for server
+/// Explorer server backend, gets callback on status update and returns json messages for server.
+/// Blocks are extracted by the worker threads, each over its own read-only connection to the node DB,
+/// the node thread only publishes the state changes
 class Adapter : public Node::IObserver, public IAdapter {
 public:
-    Adapter(Node& node) :
+    Adapter(Node& node, uint64_t blockCacheSize, bool indexes) :
         _packer(PACKER_FRAGMENTS_SIZE),
 		_node(node),
         _nodeBackend(node.get_Processor()),
         _statusDirty(true),
         _nodeIsSyncing(true),
-        _cache(CACHE_DEPTH)
+        _cache(CACHE_DEPTH),
+        _blockCacheSize(blockCacheSize),
+        _prefetchedTop(0),
+        _stop(false)
     {
         init_helper_fragments();
         _hook = &node.m_Cfg.m_Observer;
         _nextHook = *_hook;
         *_hook = this;
+
+        // workers read the DB concurrently with the node
+        node.m_Cfg.m_ProcessorParams.m_SharedDB = true;
+
+        const std::string& path = node.m_Cfg.m_sPathLocal;
+        if (indexes && !path.empty() && _indexer.open(path + "-index.db")) {
+            // catches up with the node DB once it's initialized
+            schedule_index_sync();
+        }
     }
 
     virtual ~Adapter() {
         if (_nextHook) *_hook = _nextHook;
+
+        {
+            std::scoped_lock<std::mutex> scope(_mutex);
+            _stop = true;
+        }
+        _cond.notify_all();
+
+        for (auto& t : _workers) {
+            if (t.joinable()) t.join();
+        }
     }
 
 private:
+    /// Worker thread context
+    struct Context {
+        NodeDB db;
+        bool dbOpen = false;
+        NodeProcessor::BlockReader reader;
+        HttpMsgCreator packer;
+        io::SerializedMsg sm;
+
+        Context() : reader(db), packer(PACKER_FRAGMENTS_SIZE) {}
+    };
+
+    struct Task {
+        using Ptr = std::unique_ptr<Task>;
+        std::function<bool(Context&, io::SerializedMsg&)> func;
+        Handler handler;
+        io::SerializedMsg out;
+        bool ok = false;
+    };
+
     void init_helper_fragments() {
         static const char* s = "[,]\"";
         io::SharedBuffer buf(s, 4);
@@ -143,41 +207,160 @@ private:
 
     void OnStateChanged() override {
         const auto& cursor = _nodeBackend.m_Cursor;
-        _cache.currentHeight = cursor.m_Sid.m_Height;
+        {
+            std::scoped_lock<std::mutex> scope(_cacheMutex);
+            _cache.currentHeight = cursor.m_Sid.m_Height;
+        }
         _statusDirty = true;
+
+        // the new blocks are rendered into the persistent cache in background, not during the initial sync
+        if (_blockCacheSize && !_nodeIsSyncing) {
+            if (!_prefetchTimer) _prefetchTimer = io::Timer::create(io::Reactor::get_Current());
+            _prefetchTimer->start(PREFETCH_DELAY_MSEC, false, [this]() { prefetch(); });
+        }
+
+        if (_indexer.is_open()) {
+            _indexer.commit();
+
+            Height h = 0;
+            Merkle::Hash hash;
+            if (!_indexer.get_top(h, hash) || (h != cursor.m_Sid.m_Height) || (hash != cursor.m_ID.m_Hash)) {
+                schedule_index_sync();
+            }
+        }
+
         if (_nextHook) _nextHook->OnStateChanged();
     }
 
     void OnRolledBack(const Block::SystemState::ID& id) override {
+        {
+            // not strictly necessary, the cached blocks are verified against the snapshot anyway
+            std::scoped_lock<std::mutex> scope(_cacheMutex);
+            auto& blocks = _cache.blocks;
+            blocks.erase(blocks.lower_bound(id.m_Height), blocks.end());
+            _prefetchedTop = std::min(_prefetchedTop, id.m_Height);
+        }
+        if (_blockCache.is_open()) {
+            // disk I/O, off the node thread. Until it's done a stale entry is just a miss, it doesn't match the hash
+            Height h = id.m_Height + 1;
+            post([this, h](Context&, io::SerializedMsg&) {
+                _blockCache.truncate(h);
+                return true;
+            }, Handler());
+        }
 
-        auto& blocks = _cache.blocks;
-
-        blocks.erase(blocks.lower_bound(id.m_Height), blocks.end());
+        _indexer.truncate(id.m_Height + 1);
+        _indexer.commit();
 
         if (_nextHook) _nextHook->OnRolledBack(id);
     }
 
+    void OnBlockInterpreted(const Block::SystemState::Full& s, const Block::Body& block) override {
+        if (_indexer.is_open()) {
+            if (_indexer.add_block(s, block.m_vKernels)) {
+                // the node DB is at this block, the new assets are there
+                NodeDB& db = _nodeBackend.get_DB();
+                _indexer.resolve_assets([&db](const PeerID& owner) { return db.AssetFindByOwner(owner); });
+            } else {
+                schedule_index_sync();
+            }
+        }
+
+        if (_nextHook) _nextHook->OnBlockInterpreted(s, block);
+    }
+
+    void schedule_index_sync() {
+        if (!_indexTimer) _indexTimer = io::Timer::create(io::Reactor::get_Current());
+        _indexTimer->start(INDEX_SYNC_DELAY_MSEC, false, [this]() { sync_index(); });
+    }
+
+    /// Brings the index to the node's active branch, on the node thread, a batch at a time
+    void sync_index() {
+        NodeDB& db = _nodeBackend.get_DB();
+        Height cursor = _nodeBackend.m_Cursor.m_Sid.m_Height;
+
+        try {
+            // drop what's not on the active branch (rolled back while we were down)
+            Height h = 0;
+            Merkle::Hash hash, hv;
+            while (_indexer.get_top(h, hash)) {
+                if (h <= cursor) {
+                    db.get_StateHash(db.FindActiveStateStrict(h), hv);
+                    if (hv == hash) break;
+                }
+                if (!_indexer.truncate((h > cursor) ? cursor + 1 : h)) {
+                    _indexer.commit();
+                    return;
+                }
+            }
+
+            if (!_indexer.get_top(h, hash)) h = Rules::HeightGenesis - 1;
+
+            Height end = std::min(cursor, h + INDEX_SYNC_BATCH);
+            for (h++; h <= end; h++) {
+                uint64_t row = db.FindActiveStateStrict(h);
+
+                Block::SystemState::Full s;
+                db.get_State(row, s);
+
+                // the kernels are eternal, available below the horizon too
+                TxVectors::Eternal txve;
+                ByteBuffer bbE;
+                db.GetStateBlock(row, nullptr, &bbE, nullptr);
+                if (!bbE.empty()) {
+                    Deserializer der;
+                    der.reset(bbE);
+                    der & txve;
+                }
+
+                if (!_indexer.add_block(s, txve.m_vKernels)) {
+                    LOG_ERROR() << "Explorer index: cannot add block " << h;
+                    _indexer.commit();
+                    return;
+                }
+            }
+
+            if (end < cursor) {
+                _indexer.commit();
+                schedule_index_sync();
+                return;
+            }
+
+            _indexer.resolve_assets([&db](const PeerID& owner) { return db.AssetFindByOwner(owner); });
+        } catch (const CorruptionException& e) {
+            LOG_ERROR() << "Explorer index: " << e.m_sErr;
+        } catch (const std::exception& e) {
+            LOG_ERROR() << "Explorer index: " << e.what();
+        }
+
+        _indexer.commit();
+    }
+
     bool get_status(io::SerializedMsg& out) override {
         if (_statusDirty) {
             const auto& cursor = _nodeBackend.m_Cursor;
 
-            _cache.currentHeight = cursor.m_Sid.m_Height;
+            Height currentHeight = cursor.m_Sid.m_Height;
+            {
+                std::scoped_lock<std::mutex> scope(_cacheMutex);
+                _cache.currentHeight = currentHeight;
+            }
 
             char buf[80];
 
             _sm.clear();
-            if (!serialize_json_msg(
-                _sm,
-                _packer,
-                json{
-                    { "timestamp", cursor.m_Full.m_TimeStamp },
-                    { "height", _cache.currentHeight },
-                    { "low_horizon", _nodeBackend.m_Extra.m_TxoHi },
-                    { "hash", hash_to_hex(buf, cursor.m_ID.m_Hash) },
-                    { "chainwork",  uint256_to_hex(buf, cursor.m_Full.m_ChainWork) },
-                    { "peers_count", _node.get_AcessiblePeerCount() }
-                }
-            )) {
+            if (!write_json_msg(_sm, _packer, [&](JsonWriter& w) {
+                w.begin_object();
+                w.member("chainwork", uint256_to_hex(buf, cursor.m_Full.m_ChainWork));
+                w.key("hash").hex(cursor.m_ID.m_Hash);
+                w.member("height", currentHeight);
+                w.member("kernel_filter_fp_rate", _nodeBackend.get_DB().get_KrnFilter().m_Stats.get_FpRate());
+                w.member("low_horizon", _nodeBackend.m_Extra.m_TxoHi);
+                w.member("peers_count", _node.get_AcessiblePeerCount());
+                w.member("timestamp", cursor.m_Full.m_TimeStamp);
+                w.member("unique_filter_fp_rate", _nodeBackend.get_DB().get_UniqueFilter().m_Stats.get_FpRate());
+                w.end_object();
+            })) {
                 return false;
             }
 
@@ -189,8 +372,106 @@ private:
         return true;
     }
 
-    bool extract_row(Height height, uint64_t& row, uint64_t* prevRow) {
-        NodeDB& db = _nodeBackend.get_DB();
+    void prefetch() {
+        post([this](Context& ctx, io::SerializedMsg& out) {
+            Height top = ctx.reader.m_Cursor.m_Height;
+            Height h;
+            {
+                std::scoped_lock<std::mutex> scope(_cacheMutex);
+                h = std::max(_prefetchedTop, (top > MAX_PREFETCH) ? top - MAX_PREFETCH : 0);
+                if (h >= top) return true;
+                _prefetchedTop = top;
+            }
+
+            uint64_t row = 0;
+            uint64_t prevRow = 0;
+            for (Height i = top; i > h; i--, row = prevRow) {
+                out.clear();
+                if (!get_block_impl(ctx, out, i, row, &prevRow) || !prevRow) break;
+            }
+            return true;
+        }, Handler());
+    }
+
+    void post(std::function<bool(Context&, io::SerializedMsg&)>&& func, Handler&& handler) {
+        if (_workers.empty()) {
+            _dbPath = _node.m_Cfg.m_sPathLocal;
+            if (_blockCacheSize && !_dbPath.empty()) {
+                _blockCache.open(_dbPath + "-blocks.db", _blockCacheSize);
+            }
+
+            _doneEvent = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { on_done(); });
+
+            unsigned n = std::min(std::max(std::thread::hardware_concurrency(), 1U), MAX_WORKERS);
+            for (unsigned i = 0; i < n; i++) {
+                _workers.emplace_back(&Adapter::run_worker, this);
+            }
+        }
+
+        Task::Ptr t = std::make_unique<Task>();
+        t->func = std::move(func);
+        t->handler = std::move(handler);
+
+        {
+            std::scoped_lock<std::mutex> scope(_mutex);
+            _tasks.push_back(std::move(t));
+        }
+        _cond.notify_one();
+    }
+
+    void run_worker() {
+        Context ctx;
+
+        while (true) {
+            Task::Ptr t;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                if (_stop) break;
+
+                t = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+
+            try {
+                if (!ctx.dbOpen) {
+                    ctx.db.OpenReadOnly(_dbPath.c_str());
+                    ctx.dbOpen = true;
+                }
+
+                NodeDB::Transaction tx(ctx.db); // consistent snapshot for the whole request
+                ctx.reader.Init();
+
+                t->ok = t->func(ctx, t->out);
+            } catch (const CorruptionException& e) {
+                LOG_ERROR() << "Explorer worker: " << e.m_sErr;
+                t->ok = false;
+            } catch (const std::exception& e) {
+                LOG_ERROR() << "Explorer worker: " << e.what();
+                t->ok = false;
+            }
+
+            {
+                std::scoped_lock<std::mutex> scope(_mutex);
+                _done.push_back(std::move(t));
+            }
+            _doneEvent->post();
+        }
+    }
+
+    void on_done() {
+        std::deque<Task::Ptr> done;
+        {
+            std::scoped_lock<std::mutex> scope(_mutex);
+            done.swap(_done);
+        }
+
+        for (auto& t : done) {
+            if (t->handler) t->handler(t->ok, t->out);
+        }
+    }
+
+    bool extract_row(NodeDB& db, Height height, uint64_t& row) {
         NodeDB::WalkerState ws;
         db.EnumStatesAt(ws, height);
         while (true) {
@@ -202,63 +483,48 @@ private:
                 break;
             }
         }
-        if (prevRow) {
-            *prevRow = row;
-            if (!db.get_Prev(*prevRow)) {
-                *prevRow = 0;
-            }
-        }
         return true;
     }
 
-    bool extract_block_from_row(json& out, uint64_t row, Height height) {
-        NodeDB& db = _nodeBackend.get_DB();
-
+    bool extract_block_from_row(Context& ctx, io::SerializedMsg& out, uint64_t row, Height height) {
         Block::SystemState::Full blockState;
 		Block::SystemState::ID id;
 		Block::Body block;
-		bool ok = true;
 
         try {
-            db.get_State(row, blockState);
+            ctx.db.get_State(row, blockState);
 			blockState.get_ID(id);
 
 			NodeDB::StateID sid;
 			sid.m_Row = row;
 			sid.m_Height = id.m_Height;
-			_nodeBackend.ExtractBlockWithExtra(block, sid);
+			ctx.reader.ExtractBlockWithExtra(block, sid);
 
 		} catch (...) {
-            ok = false;
+            return false;
         }
 
-
-        if (ok) {
+        // members in the alphabetical order, as the DOM used to emit them
+        return write_json_msg(out, ctx.packer, [&](JsonWriter& w) {
             char buf[80];
 
-            json inputs = json::array();
-            for (const auto &v : block.m_vInputs) {
-                inputs.push_back(
-                json{
-                    {"commitment", uint256_to_hex(buf, v->m_Commitment.m_X)},
-                    {"maturity",   v->m_Internal.m_Maturity}
-                }
-                );
-            }
+            w.begin_object();
+            w.member("chainwork", uint256_to_hex(buf, blockState.m_ChainWork));
+            w.member("difficulty", blockState.m_PoW.m_Difficulty.ToFloat());
+            w.member("found", true);
+            w.key("hash").hex(id.m_Hash);
+            w.member("height", blockState.m_Height);
 
-            json outputs = json::array();
-            for (const auto &v : block.m_vOutputs) {
-                outputs.push_back(
-                json{
-                    {"commitment", uint256_to_hex(buf, v->m_Commitment.m_X)},
-                    {"maturity",   v->get_MinMaturity(height)},
-                    {"coinbase",   v->m_Coinbase},
-                    {"incubation", v->m_Incubation}
-                }
-                );
+            w.key("inputs").begin_array();
+            for (const auto &v : block.m_vInputs) {
+                w.begin_object();
+                w.member("commitment", uint256_to_hex(buf, v->m_Commitment.m_X));
+                w.member("maturity", v->m_Internal.m_Maturity);
+                w.end_object();
             }
+            w.end_array();
 
-            json kernels = json::array();
+            w.key("kernels").begin_array();
             for (const auto &v : block.m_vKernels) {
 
 				TxStats s;
@@ -269,131 +535,141 @@ private:
 
 				ECC::Point comm(exc);
 
-                kernels.push_back(
-                    json{
-                        {"id", hash_to_hex(buf, v->m_Internal.m_ID)},
-                        {"excess", uint256_to_hex(buf, comm.m_X)},
-                        {"minHeight", v->m_Height.m_Min},
-                        {"maxHeight", v->m_Height.m_Max},
-                        {"fee", AmountBig::get_Lo(s.m_Fee)}
-                    }
-                );
+                w.begin_object();
+                w.member("excess", uint256_to_hex(buf, comm.m_X));
+                w.member("fee", AmountBig::get_Lo(s.m_Fee));
+                w.key("id").hex(v->m_Internal.m_ID);
+                w.member("maxHeight", v->m_Height.m_Max);
+                w.member("minHeight", v->m_Height.m_Min);
+                w.end_object();
             }
+            w.end_array();
 
-            out = json{
-                {"found",      true},
-                {"timestamp",  blockState.m_TimeStamp},
-                {"height",     blockState.m_Height},
-                {"hash",       hash_to_hex(buf, id.m_Hash)},
-                {"prev",       hash_to_hex(buf, blockState.m_Prev)},
-                {"difficulty", blockState.m_PoW.m_Difficulty.ToFloat()},
-                {"chainwork",  uint256_to_hex(buf, blockState.m_ChainWork)},
-                {"subsidy",    Rules::get_Emission(blockState.m_Height)},
-                {"inputs",     inputs},
-                {"outputs",    outputs},
-                {"kernels",    kernels}
-            };
-
-            LOG_DEBUG() << out;
-        }
-        return ok;
-    }
-
-    bool extract_block(json& out, Height height, uint64_t& row, uint64_t* prevRow) {
-        bool ok = true;
-        if (row == 0) {
-            ok = extract_row(height, row, prevRow);
-        } else if (prevRow != 0) {
-            *prevRow = row;
-            if (!_nodeBackend.get_DB().get_Prev(*prevRow)) {
-                *prevRow = 0;
+            w.key("outputs").begin_array();
+            for (const auto &v : block.m_vOutputs) {
+                w.begin_object();
+                w.member("coinbase", v->m_Coinbase);
+                w.member("commitment", uint256_to_hex(buf, v->m_Commitment.m_X));
+                w.member("incubation", v->m_Incubation);
+                w.member("maturity", v->get_MinMaturity(height));
+                w.end_object();
             }
-        }
-        return ok && extract_block_from_row(out, row, height);
+            w.end_array();
+
+            w.key("prev").hex(blockState.m_Prev);
+            w.member("subsidy", Rules::get_Emission(blockState.m_Height));
+            w.member("timestamp", blockState.m_TimeStamp);
+            w.end_object();
+        });
     }
 
-    bool get_block_impl(io::SerializedMsg& out, uint64_t height, uint64_t& row, uint64_t* prevRow) {
-        if (_cache.get_block(out, height)) {
-            if (prevRow && row > 0) {
-                extract_row(height, row, prevRow);
+    bool get_block_impl(Context& ctx, io::SerializedMsg& out, uint64_t height, uint64_t& row, uint64_t* prevRow) {
+        NodeDB& db = ctx.db;
+
+        if ((height <= ctx.reader.m_Cursor.m_Height) && (row || extract_row(db, height, row))) {
+            if (prevRow) {
+                *prevRow = row;
+                if (!db.get_Prev(*prevRow)) {
+                    *prevRow = 0;
+                }
             }
-            return true;
-        }
 
-        if (_statusDirty) {
-            const auto &cursor = _nodeBackend.m_Cursor;
-            _cache.currentHeight = cursor.m_Sid.m_Height;
-        }
+            Merkle::Hash hash;
+            db.get_StateHash(row, hash);
 
-        io::SharedBuffer body;
-        bool blockAvailable = (height <= _cache.currentHeight);
-        if (blockAvailable) {
-            json j;
-            if (!extract_block(j, height, row, prevRow)) {
-                blockAvailable = false;
-            } else {
-                _sm.clear();
-                if (serialize_json_msg(_sm, _packer, j)) {
-                    body = io::normalize(_sm, false);
-                    _cache.put_block(height, body);
-                } else {
-                    return false;
+            {
+                std::scoped_lock<std::mutex> scope(_cacheMutex);
+                if (_cache.get_block(out, height, hash)) {
+                    return true;
                 }
-                _sm.clear();
             }
-        }
 
-        if (blockAvailable) {
-            out.push_back(body);
-            return true;
+            io::SharedBuffer body;
+            if (_blockCache.get(height, hash, body)) {
+                std::scoped_lock<std::mutex> scope(_cacheMutex);
+                _cache.put_block(height, hash, body);
+                out.push_back(body);
+                return true;
+            }
+
+            ctx.sm.clear();
+            if (extract_block_from_row(ctx, ctx.sm, row, height)) {
+                body = io::normalize(ctx.sm, false);
+                ctx.sm.clear();
+
+                {
+                    std::scoped_lock<std::mutex> scope(_cacheMutex);
+                    _cache.put_block(height, hash, body);
+                }
+                _blockCache.put(height, hash, body);
+
+                out.push_back(body);
+                return true;
+            }
         }
 
-        return serialize_json_msg(out, _packer, json{ { "found", false}, {"height", height } });
+        return write_json_msg(out, ctx.packer, [height](JsonWriter& w) {
+            w.begin_object();
+            w.member("found", false);
+            w.member("height", height);
+            w.end_object();
+        });
     }
 
-    bool get_block(io::SerializedMsg& out, uint64_t height) override {
-        uint64_t row=0;
-        return get_block_impl(out, height, row, 0);
+    void get_block(uint64_t height, Handler&& h) override {
+        post([this, height](Context& ctx, io::SerializedMsg& out) {
+            uint64_t row = 0;
+            return get_block_impl(ctx, out, height, row, 0);
+        }, std::move(h));
     }
 
-    bool get_block_by_hash(io::SerializedMsg& out, const ByteBuffer& hash) override {
-        NodeDB& db = _nodeBackend.get_DB();
-
-        Height height = db.FindBlock(hash);
-        uint64_t row = 0;
-
-        return get_block_impl(out, height, row, 0);
+    void get_block_by_hash(const ByteBuffer& hash, Handler&& h) override {
+        post([this, hash](Context& ctx, io::SerializedMsg& out) {
+            Height height = ctx.db.FindBlock(hash);
+            uint64_t row = 0;
+            return get_block_impl(ctx, out, height, row, 0);
+        }, std::move(h));
     }
 
-    bool get_block_by_kernel(io::SerializedMsg& out, const ByteBuffer& key) override {
-        NodeDB& db = _nodeBackend.get_DB();
+    void get_block_by_kernel(const ByteBuffer& key, Handler&& h) override {
+        post([this, key](Context& ctx, io::SerializedMsg& out) {
+            Height height = ctx.db.FindKernel(key);
+            uint64_t row = 0;
+            return get_block_impl(ctx, out, height, row, 0);
+        }, std::move(h));
+    }
 
-        Height height = db.FindKernel(key);
-        uint64_t row = 0;
+    void get_blocks(uint64_t startHeight, uint64_t n, Handler&& h) override {
+        get_blocks_impl(startHeight, n, true, std::move(h));
+    }
 
-        return get_block_impl(out, height, row, 0);
+    void get_blocks_part(uint64_t startHeight, uint64_t n, Handler&& h) override {
+        get_blocks_impl(startHeight, n, false, std::move(h));
     }
 
-    bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) override {
+    void get_blocks_impl(uint64_t startHeight, uint64_t n, bool brackets, Handler&& h) {
         static const uint64_t maxElements = 1500;
         if (n > maxElements) n = maxElements;
         else if (n==0) n=1;
-        Height endHeight = startHeight + n - 1;
-        out.push_back(_leftBrace);
-        uint64_t row = 0;
-        uint64_t prevRow = 0;
-        for (;;) {
-            bool ok = get_block_impl(out, endHeight, row, &prevRow);
-            if (!ok) return false;
-            if (endHeight == startHeight) {
-                break;
+
+        post([this, startHeight, n, brackets](Context& ctx, io::SerializedMsg& out) {
+            Height endHeight = startHeight + n - 1;
+            if (brackets) out.push_back(_leftBrace);
+            uint64_t row = 0;
+            uint64_t prevRow = 0;
+            for (;;) {
+                bool ok = get_block_impl(ctx, out, endHeight, row, &prevRow);
+                if (!ok) return false;
+                if (endHeight == startHeight) {
+                    break;
+                }
+                out.push_back(_comma);
+                row = prevRow;
+                --endHeight;
             }
-            out.push_back(_comma);
-            row = prevRow;
-            --endHeight;
-        }
-        out.push_back(_rightBrace);
-        return true;
+            if (brackets) out.push_back(_rightBrace);
+            return true;
+        }, std::move(h));
     }
 
     bool get_peers(io::SerializedMsg& out) override
@@ -424,6 +700,83 @@ private:
         return true;
     }
 
+    bool has_indexes() const override {
+        return _indexer.is_open();
+    }
+
+    static uint32_t page_size(uint64_t n) {
+        return static_cast<uint32_t>(n ? std::min(n, MAX_PAGE_SIZE) : DEFAULT_PAGE_SIZE);
+    }
+
+    template <typename T, typename F>
+    static bool write_page(Context& ctx, io::SerializedMsg& out, const std::vector<T>& items, uint64_t next, F&& writeItem) {
+        return write_json_msg(out, ctx.packer, [&](JsonWriter& w) {
+            w.begin_object();
+            w.key("items").begin_array();
+            for (const auto& x : items) {
+                w.begin_object();
+                writeItem(w, x);
+                w.end_object();
+            }
+            w.end_array();
+            w.key("next");
+            if (next) w.value(next); else w.null();
+            w.end_object();
+        });
+    }
+
+    static void write_kernel(JsonWriter& w, const Indexer::Kernel& k) {
+        w.member("fee", k.fee);
+        w.member("height", k.height);
+        w.key("id").hex(k.id);
+        w.member("maxHeight", k.maxHeight);
+        w.member("minHeight", k.minHeight);
+    }
+
+    void get_kernels_by_fee(uint64_t fee, uint64_t cursor, uint64_t n, Handler&& h) override {
+        post([this, fee, cursor, n](Context& ctx, io::SerializedMsg& out) {
+            std::vector<Indexer::Kernel> v;
+            uint64_t next = _indexer.get_kernels_by_fee(fee, cursor, page_size(n), v);
+            return write_page(ctx, out, v, next, write_kernel);
+        }, std::move(h));
+    }
+
+    void get_kernels_by_lock_height(uint64_t height, uint64_t cursor, uint64_t n, Handler&& h) override {
+        post([this, height, cursor, n](Context& ctx, io::SerializedMsg& out) {
+            std::vector<Indexer::Kernel> v;
+            uint64_t next = _indexer.get_kernels_by_lock_height(height, cursor, page_size(n), v);
+            return write_page(ctx, out, v, next, write_kernel);
+        }, std::move(h));
+    }
+
+    void get_asset_history(uint64_t assetId, uint64_t cursor, uint64_t n, Handler&& h) override {
+        post([this, assetId, cursor, n](Context& ctx, io::SerializedMsg& out) {
+            static const char* kinds[] = { "create", "emit", "destroy" };
+
+            std::vector<Indexer::AssetEvent> v;
+            uint64_t next = _indexer.get_asset_history(static_cast<Asset::ID>(assetId), cursor, page_size(n), v);
+            return write_page(ctx, out, v, next, [](JsonWriter& w, const Indexer::AssetEvent& e) {
+                w.member("assetId", e.assetId);
+                w.member("height", e.height);
+                w.key("kernel").hex(e.kernel);
+                w.member("kind", kinds[e.kind]);
+                w.member("value", e.value);
+            });
+        }, std::move(h));
+    }
+
+    void get_blocks_by_time(uint64_t fromTime, uint64_t toTime, uint64_t cursor, uint64_t n, Handler&& h) override {
+        post([this, fromTime, toTime, cursor, n](Context& ctx, io::SerializedMsg& out) {
+            std::vector<Indexer::BlockInfo> v;
+            uint64_t next = _indexer.get_blocks_by_time(fromTime, toTime, cursor, page_size(n), v);
+            return write_page(ctx, out, v, next, [](JsonWriter& w, const Indexer::BlockInfo& b) {
+                w.key("hash").hex(b.hash);
+                w.member("height", b.height);
+                w.member("timestamp", b.timestamp);
+            });
+        }, std::move(h));
+    }
+
     HttpMsgCreator _packer;
 
     // node db interface
@@ -444,12 +797,33 @@ private:
     Node::IObserver* _nextHook;
 
     ResponseCache _cache;
+    std::mutex _cacheMutex; // blocks are shared with the workers
+
+    // rendered blocks on disk, next to the node DB
+    BlockCache _blockCache;
+    uint64_t _blockCacheSize;
+    Height _prefetchedTop; // guarded by _cacheMutex
+    io::Timer::Ptr _prefetchTimer;
+
+    // secondary indexes, written on the node thread
+    Indexer _indexer;
+    io::Timer::Ptr _indexTimer;
 
     io::SerializedMsg _sm;
+
+    // workers
+    std::string _dbPath;
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<Task::Ptr> _tasks;
+    std::deque<Task::Ptr> _done;
+    io::AsyncEvent::Ptr _doneEvent;
+    bool _stop;
 };
 
-IAdapter::Ptr create_adapter(Node& node) {
-    return IAdapter::Ptr(new Adapter(node));
+IAdapter::Ptr create_adapter(Node& node, uint64_t blockCacheSize, bool indexes) {
+    return IAdapter::Ptr(new Adapter(node, blockCacheSize, indexes));
 }
 
 }} //namespaces
@@ -14,6 +14,7 @@
 
 #include "utility/io/buffer.h"
 #include "utility/common.h"
+#include <functional>
 
 namespace beam {
 
@@ -30,17 +31,38 @@ struct IAdapter {
     /// Returns body for /status request
     virtual bool get_status(io::SerializedMsg& out) = 0;
 
-    virtual bool get_block(io::SerializedMsg& out, uint64_t height) = 0;
+    /// Block requests are served by worker threads over a read-only DB snapshot.
+    /// The handler is invoked later on the reactor thread, with the body if ok
+    using Handler = std::function<void(bool ok, io::SerializedMsg& out)>;
 
-    virtual bool get_block_by_hash(io::SerializedMsg& out, const ByteBuffer& hash) = 0;
+    virtual void get_block(uint64_t height, Handler&& h) = 0;
 
-    virtual bool get_block_by_kernel(io::SerializedMsg& out, const ByteBuffer& key) = 0;
+    virtual void get_block_by_hash(const ByteBuffer& hash, Handler&& h) = 0;
 
-    virtual bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) = 0;
+    virtual void get_block_by_kernel(const ByteBuffer& key, Handler&& h) = 0;
+
+    virtual void get_blocks(uint64_t startHeight, uint64_t n, Handler&& h) = 0;
+
+    /// The same w/o the enclosing brackets, the server streams a long range in such parts
+    virtual void get_blocks_part(uint64_t startHeight, uint64_t n, Handler&& h) = 0;
 
     virtual bool get_peers(io::SerializedMsg& out) = 0;
+
+    /// Secondary indexes, if enabled. The result is a page: {"items":[...],"next":cursor}, next is null on the last one.
+    /// cursor - from the previous page, 0 for the first one
+    virtual bool has_indexes() const = 0;
+
+    virtual void get_kernels_by_fee(uint64_t fee, uint64_t cursor, uint64_t n, Handler&& h) = 0;
+
+    virtual void get_kernels_by_lock_height(uint64_t height, uint64_t cursor, uint64_t n, Handler&& h) = 0;
+
+    virtual void get_asset_history(uint64_t assetId, uint64_t cursor, uint64_t n, Handler&& h) = 0;
+
+    virtual void get_blocks_by_time(uint64_t fromTime, uint64_t toTime, uint64_t cursor, uint64_t n, Handler&& h) = 0;
 };
 
-IAdapter::Ptr create_adapter(Node& node);
+/// blockCacheSize: limit of the persistent cache of the rendered blocks (next to the node DB), 0 - disabled
+/// indexes: maintain the secondary indexes (next to the node DB)
+IAdapter::Ptr create_adapter(Node& node, uint64_t blockCacheSize = 0, bool indexes = false);
 
 }} //namespaces
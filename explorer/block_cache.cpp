@@ -0,0 +1,212 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "block_cache.h"
+#include "sqlite_statement.h"
+
+#ifdef BEAM_EXPLORER_ZLIB
+#include <zlib.h>
+#endif
+
+namespace beam { namespace explorer {
+
+namespace {
+
+// bump on any change of the rendered json or of the packing
+static const int FORMAT_VERSION = 2;
+
+// packed body: a tag byte, then either the json as is,
+// or its size (4 bytes, little-endian) followed by the zlib stream
+static const uint8_t TAG_RAW = 0;
+static const uint8_t TAG_ZLIB = 1;
+static const size_t ZLIB_HEADER_SIZE = 5;
+
+} //namespace
+
+BlockCache::~BlockCache() {
+    close();
+}
+
+bool BlockCache::open(const std::string& path, uint64_t maxSize) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+
+    _db = sqlite_open(path, FORMAT_VERSION,
+        "DROP TABLE IF EXISTS Blocks",
+        "CREATE TABLE IF NOT EXISTS Blocks (Height INTEGER PRIMARY KEY, Hash BLOB NOT NULL, Body BLOB NOT NULL)");
+    if (!_db) return false;
+
+    {
+        SqliteStatement st(_db, "SELECT SUM(length(Body)) FROM Blocks");
+        _size = (st && st.step()) ? st.get(0) : 0;
+    }
+    _maxSize = maxSize;
+
+    LOG_INFO() << "Block cache: " << path << ", " << _size << " bytes";
+    return true;
+}
+
+void BlockCache::close() {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (_db) {
+        sqlite3_close(_db);
+        _db = nullptr;
+    }
+}
+
+bool BlockCache::get(Height h, const Merkle::Hash& hash, io::SharedBuffer& body) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return false;
+
+    SqliteStatement st(_db, "SELECT Hash, Body FROM Blocks WHERE Height=?");
+    if (!st) return false;
+    st.bind(1, h);
+    if (!st.step()) return false;
+
+    Merkle::Hash hv;
+    if (!st.get_blob(0, hv) || (hv != hash))
+        return false; // the block was replaced
+
+    return unpack(body, sqlite3_column_blob(st.s, 1), sqlite3_column_bytes(st.s, 1));
+}
+
+void BlockCache::put(Height h, const Merkle::Hash& hash, const io::SharedBuffer& body) {
+    ByteBuffer packed;
+    pack(packed, body.data, body.size); // outside of the lock
+
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return;
+
+    {
+        SqliteStatement st(_db, "SELECT length(Body) FROM Blocks WHERE Height=?");
+        if (!st) return;
+        st.bind(1, h);
+        if (st.step()) _size -= st.get(0);
+    }
+
+    SqliteStatement st(_db, "INSERT OR REPLACE INTO Blocks (Height, Hash, Body) VALUES(?,?,?)");
+    if (!st) return;
+    st.bind(1, h);
+    st.bind_blob(2, hash);
+    st.bind(3, packed.data(), packed.size());
+
+    if (!st.exec()) {
+        LOG_ERROR() << "Block cache: " << sqlite3_errmsg(_db);
+        return;
+    }
+
+    _size += packed.size();
+    if (_size > _maxSize) evict();
+}
+
+void BlockCache::evict() {
+    // down to 90% of the limit, not to evict on every put
+    uint64_t target = _maxSize - _maxSize / 10;
+    Height h = 0;
+    uint64_t size = _size;
+
+    {
+        SqliteStatement st(_db, "SELECT Height, length(Body) FROM Blocks ORDER BY Height");
+        if (!st) return;
+        while ((size > target) && st.step()) {
+            h = st.get(0);
+            size -= st.get(1);
+        }
+    }
+
+    SqliteStatement st(_db, "DELETE FROM Blocks WHERE Height<=?");
+    if (!st) return;
+    st.bind(1, h);
+    if (st.exec()) _size = size;
+}
+
+void BlockCache::truncate(Height h) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return;
+
+    {
+        SqliteStatement st(_db, "SELECT SUM(length(Body)) FROM Blocks WHERE Height>=?");
+        if (!st) return;
+        st.bind(1, h);
+        if (st.step()) _size -= st.get(0);
+    }
+
+    SqliteStatement st(_db, "DELETE FROM Blocks WHERE Height>=?");
+    if (!st) return;
+    st.bind(1, h);
+    st.exec();
+}
+
+Height BlockCache::get_top() {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return 0;
+
+    SqliteStatement st(_db, "SELECT MAX(Height) FROM Blocks");
+    return (st && st.step()) ? st.get(0) : 0;
+}
+
+void BlockCache::pack(ByteBuffer& out, const void* p, size_t size) {
+    out.clear();
+
+#ifdef BEAM_EXPLORER_ZLIB
+    if (size <= std::numeric_limits<uint32_t>::max()) {
+        uLongf n = compressBound(static_cast<uLong>(size));
+        out.resize(ZLIB_HEADER_SIZE + n);
+
+        int res = compress2(out.data() + ZLIB_HEADER_SIZE, &n, static_cast<const Bytef*>(p), static_cast<uLong>(size), Z_DEFAULT_COMPRESSION);
+        if ((Z_OK == res) && (ZLIB_HEADER_SIZE + n <= size)) {
+            out[0] = TAG_ZLIB;
+            for (size_t i = 0; i < 4; i++)
+                out[1 + i] = static_cast<uint8_t>(size >> (i * 8));
+
+            out.resize(ZLIB_HEADER_SIZE + n);
+            return;
+        }
+    }
+#endif // BEAM_EXPLORER_ZLIB
+
+    // not worth it, or no zlib
+    out.resize(size + 1);
+    out[0] = TAG_RAW;
+    if (size) memcpy(out.data() + 1, p, size);
+}
+
+bool BlockCache::unpack(io::SharedBuffer& out, const void* p, size_t size) {
+    const uint8_t* src = static_cast<const uint8_t*>(p);
+    if (!size) return false;
+
+    if (TAG_RAW == src[0]) {
+        out.assign(src + 1, size - 1);
+        return true;
+    }
+
+#ifdef BEAM_EXPLORER_ZLIB
+    if ((TAG_ZLIB == src[0]) && (size >= ZLIB_HEADER_SIZE)) {
+        uint32_t n = 0;
+        for (size_t i = 0; i < 4; i++)
+            n |= static_cast<uint32_t>(src[1 + i]) << (i * 8);
+
+        auto buf = io::alloc_heap(n);
+        uLongf nOut = n;
+        if ((Z_OK != uncompress(buf.first, &nOut, src + ZLIB_HEADER_SIZE, static_cast<uLong>(size - ZLIB_HEADER_SIZE))) || (nOut != n))
+            return false;
+
+        out.assign(buf.first, n, std::move(buf.second));
+        return true;
+    }
+#endif // BEAM_EXPLORER_ZLIB
+
+    return false; // corrupted, or packed by the build with zlib
+}
+
+}} //namespaces
@@ -0,0 +1,61 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "core/block_crypt.h"
+#include "utility/io/buffer.h"
+#include <mutex>
+
+struct sqlite3;
+
+namespace beam { namespace explorer {
+
+/// Persistent cache of the rendered block json, in a separate sqlite file next to the node DB.
+/// Bodies are stored deflated (if built with zlib), and verified against the block hash on read, so a stale entry is a miss.
+/// Size-bounded: the lowest heights are evicted first. Thread-safe
+class BlockCache {
+public:
+    BlockCache() = default;
+    ~BlockCache();
+
+    /// maxSize is for the packed bodies. Returns false (and the cache stays disabled) on error
+    bool open(const std::string& path, uint64_t maxSize);
+    void close();
+
+    bool is_open() const { return _db != nullptr; }
+
+    bool get(Height h, const Merkle::Hash& hash, io::SharedBuffer& body);
+    void put(Height h, const Merkle::Hash& hash, const io::SharedBuffer& body);
+
+    /// Drops h and above, on rollback
+    void truncate(Height h);
+
+    /// Highest cached height, 0 if empty
+    Height get_top();
+
+    /// Deflated if available and smaller, as is otherwise
+    static void pack(ByteBuffer& out, const void* p, size_t size);
+    static bool unpack(io::SharedBuffer& out, const void* p, size_t size);
+
+private:
+    void evict();
+
+    std::mutex _mutex;
+    sqlite3* _db = nullptr;
+    uint64_t _size = 0;
+    uint64_t _maxSize = 0;
+};
+
+}} //namespaces
@@ -22,6 +22,8 @@ using namespace std;
 #define LOG_FILES_DIR "logs"
 #define FILES_PREFIX "explorer-node"
 #define API_PORT_PARAMETER "api_port"
+#define BLOCK_CACHE_PARAMETER "block_cache_size"
+#define INDEXES_PARAMETER "indexes"
 
 struct Options {
     std::string nodeDbFilename;
@@ -34,6 +36,8 @@ struct Options {
     static const unsigned logRotationPeriod = 3*60*60*1000; // 3 hours
     std::vector<uint32_t> whitelist;
     uint32_t logCleanupPeriod;
+    uint64_t blockCacheSize;
+    bool indexes;
 };
 
 static bool parse_cmdline(int argc, char* argv[], Options& o);
@@ -61,7 +65,7 @@ int main(int argc, char* argv[]) {
 
         Node node;
         setup_node(node, options);
-        explorer::IAdapter::Ptr adapter = explorer::create_adapter(node);
+        explorer::IAdapter::Ptr adapter = explorer::create_adapter(node, options.blockCacheSize, options.indexes);
         node.Initialize();
         explorer::Server server(*adapter, *reactor, options.explorerListenTo, options.accessControlFile, options.whitelist);
         LOG_INFO() << "Node listens to " << options.nodeListenTo << ", explorer listens to " << options.explorerListenTo;
@@ -93,6 +97,8 @@ bool parse_cmdline(int argc, char* argv[], Options& o) {
         (cli::PASS, po::value<string>()->default_value(""), "password for owner key")
         (cli::IP_WHITELIST, po::value<std::string>()->default_value(""), "IP whitelist")
         (cli::LOG_CLEANUP_DAYS, po::value<uint32_t>()->default_value(5), "old logfiles cleanup period(days)")
+        (BLOCK_CACHE_PARAMETER, po::value<uint32_t>()->default_value(1024), "size limit of the rendered blocks cache on disk (MB), 0 to disable")
+        (INDEXES_PARAMETER, po::value<bool>()->default_value(false), "maintain the kernel, asset and timestamp indexes for the /kernels, /asset and /blocks_by_time requests")
     ;
 
     cliOptions.add(createRulesOptionsDescription());
@@ -130,6 +136,8 @@ bool parse_cmdline(int argc, char* argv[], Options& o) {
         vm.notify();
 
         o.logCleanupPeriod = vm[cli::LOG_CLEANUP_DAYS].as<uint32_t>() * 24 * 3600;
+        o.blockCacheSize = uint64_t(vm[BLOCK_CACHE_PARAMETER].as<uint32_t>()) << 20;
+        o.indexes = vm[INDEXES_PARAMETER].as<bool>();
         o.nodeDbFilename = FILES_PREFIX ".db";
         //o.accessControlFile = "api.keys";
 
@@ -0,0 +1,348 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "indexer.h"
+#include "sqlite_statement.h"
+
+namespace beam { namespace explorer {
+
+namespace {
+
+// bump on any change of the schema or of what's indexed
+static const int FORMAT_VERSION = 1;
+
+static const char* DROP_SQL =
+    "DROP TABLE IF EXISTS Blocks;"
+    "DROP TABLE IF EXISTS Kernels;"
+    "DROP TABLE IF EXISTS Assets;";
+
+// Kernels and Assets are in the chain order by ID, which is also the pagination cursor
+static const char* CREATE_SQL =
+    "CREATE TABLE IF NOT EXISTS Blocks (Height INTEGER PRIMARY KEY, Hash BLOB NOT NULL, Timestamp INTEGER NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS BlocksTimestamp ON Blocks(Timestamp);"
+    "CREATE TABLE IF NOT EXISTS Kernels (ID INTEGER PRIMARY KEY, Height INTEGER NOT NULL, KernelID BLOB NOT NULL,"
+        " Fee INTEGER NOT NULL, MinHeight INTEGER NOT NULL, MaxHeight INTEGER NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS KernelsHeight ON Kernels(Height);"
+    "CREATE INDEX IF NOT EXISTS KernelsFee ON Kernels(Fee);"
+    "CREATE INDEX IF NOT EXISTS KernelsMinHeight ON Kernels(MinHeight);"
+    "CREATE TABLE IF NOT EXISTS Assets (ID INTEGER PRIMARY KEY, Height INTEGER NOT NULL, AssetID INTEGER NOT NULL,"
+        " Kind INTEGER NOT NULL, Value INTEGER NOT NULL, KernelID BLOB NOT NULL, Owner BLOB NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS AssetsHeight ON Assets(Height);"
+    "CREATE INDEX IF NOT EXISTS AssetsAssetID ON Assets(AssetID);";
+
+} //namespace
+
+Indexer::~Indexer() {
+    close();
+}
+
+bool Indexer::open(const std::string& path) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+
+    _db = sqlite_open(path, FORMAT_VERSION, DROP_SQL, CREATE_SQL);
+    if (!_db) return false;
+
+    SqliteStatement st(_db, "SELECT Height, Hash FROM Blocks ORDER BY Height DESC LIMIT 1");
+    if (st && st.step()) {
+        _top = st.get(0);
+        st.get_blob(1, _topHash);
+    }
+
+    LOG_INFO() << "Explorer index: " << path << ", top " << _top;
+    return true;
+}
+
+void Indexer::close() {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (_db) {
+        if (_inTx) sqlite_exec(_db, "COMMIT");
+        _inTx = false;
+        sqlite3_close(_db);
+        _db = nullptr;
+    }
+}
+
+bool Indexer::begin() {
+    if (!_inTx) _inTx = sqlite_exec(_db, "BEGIN");
+    return _inTx;
+}
+
+void Indexer::commit() {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (_db && _inTx) {
+        sqlite_exec(_db, "COMMIT");
+        _inTx = false;
+    }
+}
+
+bool Indexer::add_block(const Block::SystemState::Full& s, const std::vector<TxKernel::Ptr>& kernels) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return false;
+
+    bool next = _top ?
+        ((s.m_Height == _top + 1) && (s.m_Prev == _topHash)) :
+        (s.m_Height == Rules::HeightGenesis);
+
+    if (!next || !begin()) return false;
+
+    Merkle::Hash hash;
+    s.get_Hash(hash);
+
+    SqliteStatement st(_db, "INSERT INTO Blocks (Height, Hash, Timestamp) VALUES(?,?,?)");
+    if (!st) return false;
+    st.bind(1, s.m_Height);
+    st.bind_blob(2, hash);
+    st.bind(3, s.m_TimeStamp);
+    if (!st.exec()) {
+        LOG_ERROR() << "Explorer index: " << sqlite3_errmsg(_db);
+        return false;
+    }
+
+    add_kernels(s.m_Height, kernels);
+
+    _top = s.m_Height;
+    _topHash = hash;
+    return true;
+}
+
+void Indexer::add_kernels(Height h, const std::vector<TxKernel::Ptr>& kernels) {
+    struct Walker : public TxKernel::IWalker {
+        Indexer& m_This;
+        Height m_Height;
+        SqliteStatement m_Insert;
+
+        Walker(Indexer& x, Height h)
+            : m_This(x)
+            , m_Height(h)
+            , m_Insert(x._db, "INSERT INTO Kernels (Height, KernelID, Fee, MinHeight, MaxHeight) VALUES(?,?,?,?,?)")
+        {}
+
+        bool OnKrn(const TxKernel& krn) override {
+            if (!m_Insert) return false;
+
+            sqlite3_reset(m_Insert.s);
+            m_Insert.bind(1, m_Height);
+            m_Insert.bind_blob(2, krn.m_Internal.m_ID);
+            m_Insert.bind(3, krn.m_Fee);
+            m_Insert.bind(4, krn.m_Height.m_Min);
+            m_Insert.bind(5, krn.m_Height.m_Max);
+            m_Insert.exec();
+
+            switch (krn.get_Subtype()) {
+            case TxKernel::Subtype::AssetCreate:
+                m_This.add_asset(m_Height, krn, 0, AssetEvent::Create, 0);
+                break;
+
+            case TxKernel::Subtype::AssetEmit:
+                {
+                    const auto& x = Cast::Up<TxKernelAssetEmit>(krn);
+                    m_This.bind_owner(x.m_AssetID, x.m_Owner);
+                    m_This.add_asset(m_Height, krn, x.m_AssetID, AssetEvent::Emit, x.m_Value);
+                }
+                break;
+
+            case TxKernel::Subtype::AssetDestroy:
+                {
+                    const auto& x = Cast::Up<TxKernelAssetDestroy>(krn);
+                    m_This.bind_owner(x.m_AssetID, x.m_Owner);
+                    m_This.add_asset(m_Height, krn, x.m_AssetID, AssetEvent::Destroy, 0);
+                }
+                break;
+
+            default:
+                break;
+            }
+            return true;
+        }
+    } wlk(*this, h);
+
+    wlk.Process(kernels);
+}
+
+void Indexer::add_asset(Height h, const TxKernel& krn, Asset::ID id, AssetEvent::Kind kind, AmountSigned value) {
+    const auto& owner = Cast::Up<TxKernelAssetControl>(krn).m_Owner;
+
+    SqliteStatement st(_db, "INSERT INTO Assets (Height, AssetID, Kind, Value, KernelID, Owner) VALUES(?,?,?,?,?,?)");
+    if (!st) return;
+    st.bind(1, h);
+    st.bind(2, id);
+    st.bind(3, kind);
+    st.bind(4, static_cast<uint64_t>(value));
+    st.bind_blob(5, krn.m_Internal.m_ID);
+    st.bind_blob(6, owner);
+    st.exec();
+}
+
+void Indexer::bind_owner(Asset::ID id, const PeerID& owner) {
+    // the latest create by this owner, if not resolved yet
+    SqliteStatement st(_db,
+        "UPDATE Assets SET AssetID=? WHERE ID=(SELECT ID FROM Assets WHERE AssetID=0 AND Owner=? ORDER BY ID DESC LIMIT 1)");
+    if (!st) return;
+    st.bind(1, id);
+    st.bind_blob(2, owner);
+    st.exec();
+}
+
+void Indexer::resolve_assets(const std::function<Asset::ID(const PeerID&)>& findByOwner) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return;
+
+    std::vector<std::pair<uint64_t, Asset::ID> > resolved;
+    {
+        SqliteStatement st(_db, "SELECT ID, Owner FROM Assets WHERE AssetID=0");
+        if (!st) return;
+
+        PeerID owner;
+        while (st.step()) {
+            if (!st.get_blob(1, owner)) continue;
+            Asset::ID id = findByOwner(owner);
+            if (id) resolved.emplace_back(st.get(0), id);
+        }
+    }
+
+    if (resolved.empty() || !begin()) return;
+
+    SqliteStatement st(_db, "UPDATE Assets SET AssetID=? WHERE ID=?");
+    if (!st) return;
+    for (const auto& x : resolved) {
+        sqlite3_reset(st.s);
+        st.bind(1, x.second);
+        st.bind(2, x.first);
+        st.exec();
+    }
+}
+
+bool Indexer::truncate(Height h) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return false;
+    if (h > _top) return true;
+    if (!begin()) return false;
+
+    for (const char* sql : {
+        "DELETE FROM Blocks WHERE Height>=?",
+        "DELETE FROM Kernels WHERE Height>=?",
+        "DELETE FROM Assets WHERE Height>=?" }) {
+        SqliteStatement st(_db, sql);
+        if (!st) return false;
+        st.bind(1, h);
+        if (!st.exec()) {
+            LOG_ERROR() << "Explorer index: " << sqlite3_errmsg(_db);
+            return false;
+        }
+    }
+
+    _top = 0;
+    SqliteStatement st(_db, "SELECT Height, Hash FROM Blocks ORDER BY Height DESC LIMIT 1");
+    if (st && st.step()) {
+        _top = st.get(0);
+        st.get_blob(1, _topHash);
+    }
+    return true;
+}
+
+bool Indexer::get_top(Height& h, Merkle::Hash& hash) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db || !_top) return false;
+    h = _top;
+    hash = _topHash;
+    return true;
+}
+
+uint64_t Indexer::get_kernels(const char* sql, uint64_t key, uint64_t cursor, uint32_t n, std::vector<Kernel>& out) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return 0;
+
+    SqliteStatement st(_db, sql);
+    if (!st) return 0;
+    st.bind(1, key);
+    st.bind(2, cursor);
+    st.bind(3, n + 1); // one more, to know if there's the next page
+
+    uint64_t id = 0;
+    for (uint32_t i = 0; st.step(); i++, id = st.get(0)) {
+        if (i == n) return id;
+
+        Kernel& k = out.emplace_back();
+        k.height = st.get(1);
+        st.get_blob(2, k.id);
+        k.fee = st.get(3);
+        k.minHeight = st.get(4);
+        k.maxHeight = st.get(5);
+    }
+    return 0;
+}
+
+uint64_t Indexer::get_kernels_by_fee(Amount fee, uint64_t cursor, uint32_t n, std::vector<Kernel>& out) {
+    return get_kernels(
+        "SELECT ID, Height, KernelID, Fee, MinHeight, MaxHeight FROM Kernels WHERE Fee=? AND ID>? ORDER BY ID LIMIT ?",
+        fee, cursor, n, out);
+}
+
+uint64_t Indexer::get_kernels_by_lock_height(Height h, uint64_t cursor, uint32_t n, std::vector<Kernel>& out) {
+    return get_kernels(
+        "SELECT ID, Height, KernelID, Fee, MinHeight, MaxHeight FROM Kernels WHERE MinHeight=? AND ID>? ORDER BY ID LIMIT ?",
+        h, cursor, n, out);
+}
+
+uint64_t Indexer::get_asset_history(Asset::ID assetId, uint64_t cursor, uint32_t n, std::vector<AssetEvent>& out) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return 0;
+
+    SqliteStatement st(_db,
+        "SELECT ID, Height, AssetID, Kind, Value, KernelID FROM Assets WHERE AssetID=? AND ID>? ORDER BY ID LIMIT ?");
+    if (!st) return 0;
+    st.bind(1, assetId);
+    st.bind(2, cursor);
+    st.bind(3, n + 1);
+
+    uint64_t id = 0;
+    for (uint32_t i = 0; st.step(); i++, id = st.get(0)) {
+        if (i == n) return id;
+
+        AssetEvent& e = out.emplace_back();
+        e.height = st.get(1);
+        e.assetId = static_cast<Asset::ID>(st.get(2));
+        e.kind = static_cast<AssetEvent::Kind>(st.get(3));
+        e.value = static_cast<AmountSigned>(st.get(4));
+        st.get_blob(5, e.kernel);
+    }
+    return 0;
+}
+
+uint64_t Indexer::get_blocks_by_time(Timestamp from, Timestamp to, uint64_t cursor, uint32_t n, std::vector<BlockInfo>& out) {
+    std::scoped_lock<std::mutex> scope(_mutex);
+    if (!_db) return 0;
+
+    // the timestamps aren't strictly monotonic, hence the order is by height
+    SqliteStatement st(_db,
+        "SELECT Height, Hash, Timestamp FROM Blocks WHERE Timestamp>=? AND Timestamp<=? AND Height>? ORDER BY Height LIMIT ?");
+    if (!st) return 0;
+    st.bind(1, from);
+    st.bind(2, to);
+    st.bind(3, cursor);
+    st.bind(4, n + 1);
+
+    Height h = 0;
+    for (uint32_t i = 0; st.step(); i++, h = out.back().height) {
+        if (i == n) return h;
+
+        BlockInfo& b = out.emplace_back();
+        b.height = st.get(0);
+        st.get_blob(1, b.hash);
+        b.timestamp = st.get(2);
+    }
+    return 0;
+}
+
+}} //namespaces
@@ -0,0 +1,99 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "core/block_crypt.h"
+#include <functional>
+#include <mutex>
+
+struct sqlite3;
+
+namespace beam { namespace explorer {
+
+/// Secondary indexes for the explorer: kernels by fee and lock height, asset history, blocks by time.
+/// A separate sqlite file next to the node DB. It's appended block by block as the node interprets them,
+/// and re-synced from the node DB after a restart or a gap. Thread-safe
+class Indexer {
+public:
+    struct Kernel {
+        Height height;
+        Merkle::Hash id;
+        Amount fee;
+        Height minHeight;
+        Height maxHeight;
+    };
+
+    struct AssetEvent {
+        enum Kind { Create, Emit, Destroy };
+
+        Height height;
+        Asset::ID assetId; // 0 for a create that's not resolved yet
+        Kind kind;
+        AmountSigned value;
+        Merkle::Hash kernel;
+    };
+
+    struct BlockInfo {
+        Height height;
+        Merkle::Hash hash;
+        Timestamp timestamp;
+    };
+
+    Indexer() = default;
+    ~Indexer();
+
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return _db != nullptr; }
+
+    /// Appends the block if it's the next one on top. Returns false on a gap or a fork, then the caller should re-sync
+    bool add_block(const Block::SystemState::Full& s, const std::vector<TxKernel::Ptr>& kernels);
+
+    /// Drops h and above
+    bool truncate(Height h);
+
+    /// false if empty
+    bool get_top(Height& h, Merkle::Hash& hash);
+
+    /// The created asset id isn't in the kernel. The following emit or destroy by the same owner resolves it,
+    /// the rest are looked up by the owner
+    void resolve_assets(const std::function<Asset::ID(const PeerID&)>& findByOwner);
+
+    /// Writes are batched in a transaction until the commit
+    void commit();
+
+    /// Range queries, in the chain order. cursor - exclusive, 0 from the start.
+    /// Append up to n items to out, return the cursor for the next page, 0 if there's no more
+    uint64_t get_kernels_by_fee(Amount fee, uint64_t cursor, uint32_t n, std::vector<Kernel>& out);
+    uint64_t get_kernels_by_lock_height(Height h, uint64_t cursor, uint32_t n, std::vector<Kernel>& out);
+    uint64_t get_asset_history(Asset::ID id, uint64_t cursor, uint32_t n, std::vector<AssetEvent>& out);
+    uint64_t get_blocks_by_time(Timestamp from, Timestamp to, uint64_t cursor, uint32_t n, std::vector<BlockInfo>& out);
+
+private:
+    bool begin();
+    void add_kernels(Height h, const std::vector<TxKernel::Ptr>& kernels);
+    void add_asset(Height h, const TxKernel& krn, Asset::ID id, AssetEvent::Kind kind, AmountSigned value);
+    void bind_owner(Asset::ID id, const PeerID& owner);
+    uint64_t get_kernels(const char* sql, uint64_t key, uint64_t cursor, uint32_t n, std::vector<Kernel>& out);
+
+    std::mutex _mutex;
+    sqlite3* _db = nullptr;
+    bool _inTx = false;
+    Height _top = 0;
+    Merkle::Hash _topHash;
+};
+
+}} //namespaces
@@ -15,9 +15,13 @@
 #include "server.h"
 #include "adapter.h"
 #include "utility/logger.h"
+#include "utility/metrics.h"
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <fstream>
+#include <limits>
+#include <cstring>
+#include <ctype.h>
 
 namespace beam { namespace explorer {
 
@@ -30,8 +34,37 @@ static const uint64_t ACL_REFRESH_TIMER = 2;
 static const unsigned SERVER_RESTART_INTERVAL = 1000;
 static const unsigned ACL_REFRESH_INTERVAL = 5555;
 
+// per connection timers are keyed by peer address, which never collides with the above
+static const unsigned DRAIN_POLL_INTERVAL = 100;
+
+// reading is paused at this many queued responses, resumed at the half
+static const size_t MAX_PIPELINED = 32;
+
+// the next part of a streamed response is produced only when the send buffer is below this
+static const size_t MAX_UNSENT = 1024 * 1024;
+
+// blocks per part of a streamed /blocks response, smaller ranges are sent as is
+static const uint64_t BLOCKS_PART = 50;
+static const uint64_t MAX_BLOCKS = 1500;
+
+// not worth compressing below
+static const size_t MIN_COMPRESSED_SIZE = 512;
+
+// b is lowercase
+static bool header_value_is(const std::string& a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i]; i++) {
+        if (tolower((unsigned char)a[i]) != b[i]) return false;
+    }
+    return i == a.size() && !b[i];
+}
+
+static io::SharedBuffer static_buffer(const char* s) {
+    return io::SharedBuffer(s, strlen(s));
+}
+
 enum Dirs {
-    DIR_STATUS, DIR_BLOCK, DIR_BLOCKS, DIR_PEERS
+    DIR_STATUS, DIR_BLOCK, DIR_BLOCKS, DIR_PEERS, DIR_KERNELS, DIR_ASSET, DIR_BLOCKS_BY_TIME, DIR_METRICS
     // etc
 };
 
@@ -105,19 +138,21 @@ bool Server::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
 
     if (msg.what != HttpMsgReader::http_message || !msg.msg) {
         LOG_DEBUG() << STS << "-peer " << io::Address::from_u64(id) << " : " << msg.error_str();
-        _connections.erase(id);
+        close_connection(id);
         return false;
     }
 
     const std::string& path = msg.msg->get_path();
 
     static const std::map<std::string_view, int> dirs {
-        { "status", DIR_STATUS }, { "block", DIR_BLOCK }, { "blocks", DIR_BLOCKS }, { "peers", DIR_PEERS}
+        { "status", DIR_STATUS }, { "block", DIR_BLOCK }, { "blocks", DIR_BLOCKS }, { "peers", DIR_PEERS},
+        { "kernels", DIR_KERNELS }, { "asset", DIR_ASSET }, { "blocks_by_time", DIR_BLOCKS_BY_TIME },
+        { "metrics", DIR_METRICS }
     };
 
     const HttpConnection::Ptr& conn = it->second;
 
-    bool (Server::*func)(const HttpConnection::Ptr&) = 0;
+    void (Server::*func)(uint64_t, const Response::Ptr&) = 0;
 
     if (_currentUrl.parse(path, dirs)) {
         switch (_currentUrl.dir) {
@@ -133,109 +168,372 @@ bool Server::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
             case DIR_PEERS:
                 func = &Server::send_peers;
                 break;
+            case DIR_KERNELS:
+                func = &Server::send_kernels;
+                break;
+            case DIR_ASSET:
+                func = &Server::send_asset;
+                break;
+            case DIR_BLOCKS_BY_TIME:
+                func = &Server::send_blocks_by_time;
+                break;
+            case DIR_METRICS:
+                func = &Server::send_metrics;
+                break;
             default:
                 break;
         }
     }
 
-    bool keepalive = false;
+    auto resp = std::make_shared<Response>();
+    auto& queue = _responses[id];
+    queue.push_back(resp);
+
+    // HTTP/1.0 is closed after the response unless asked otherwise
+    _currentMinorVersion = msg.msg->get_minor_version();
+    const std::string& connection = msg.msg->get_header("connection");
+    resp->keepAlive = (_currentMinorVersion >= 1) ? !header_value_is(connection, "close") : header_value_is(connection, "keep-alive");
+    resp->encoding = HttpCompressor::select(msg.msg->get_header("accept-encoding"));
+
+    if (queue.size() >= MAX_PIPELINED && !_paused.count(id)) {
+        // cannot stop reading from within the read callback
+        _timers.set_timer(id, 0, [this, id] { service(id); });
+    }
 
     if (func) {
         //bool validKey = _acl.check(_currentUrl.args["m"], _currentUrl.args["n"], _currentUrl.args["h"]);
         bool validKey = _acl.check(conn->peer_address());
         if (!validKey) {
-            send(conn, 403, "Forbidden");
+            resp->code = 403;
+            resp->message = "Forbidden";
         } else {
-            keepalive = (this->*func)(conn);
+            (this->*func)(id, resp);
         }
     } else {
-        send(conn, 404, "Not Found");
+        resp->code = 404;
+        resp->message = "Not Found";
     }
 
-    if (!keepalive) {
-        conn->shutdown();
-        _connections.erase(it);
-    }
-    return keepalive;
+    return flush(id);
 }
 
-bool Server::send_status(const HttpConnection::Ptr& conn) {
-    _body.clear();
-    if (!_backend.get_status(_body)) {
-        return send(conn, 500, "Internal error #1");
+void Server::send_status(uint64_t id, const Response::Ptr& resp) {
+    if (!_backend.get_status(resp->body)) {
+        resp->code = 500;
+        resp->message = "Internal error #1";
+        return;
     }
-    return send(conn, 200, "OK");
+    resp->code = 200;
+    resp->message = "OK";
+}
+
+std::function<void(bool, io::SerializedMsg&)> Server::on_completed(uint64_t id, const Response::Ptr& resp, const char* error) {
+    return [this, id, resp, error](bool ok, io::SerializedMsg& body) {
+        if (ok) {
+            resp->body.swap(body);
+            resp->code = 200;
+            resp->message = "OK";
+        } else {
+            resp->code = 500;
+            resp->message = error;
+        }
+        flush(id);
+    };
 }
 
-bool Server::send_block(const HttpConnection::Ptr &conn) {
+void Server::send_block(uint64_t id, const Response::Ptr& resp) {
 
     if (_currentUrl.has_arg("hash"))
     {
         ByteBuffer hash;
 
-        if (!_currentUrl.get_hex_arg("hash", hash) || !_backend.get_block_by_hash(_body, hash)) {
-            return send(conn, 500, "Internal error #2");
+        if (_currentUrl.get_hex_arg("hash", hash)) {
+            _backend.get_block_by_hash(hash, on_completed(id, resp, "Internal error #2"));
+            return;
         }
     }
     else if (_currentUrl.has_arg("kernel"))
     {
         ByteBuffer kernel;
 
-        if (!_currentUrl.get_hex_arg("kernel", kernel) || !_backend.get_block_by_kernel(_body, kernel)) {
-            return send(conn, 500, "Internal error #2");
+        if (_currentUrl.get_hex_arg("kernel", kernel)) {
+            _backend.get_block_by_kernel(kernel, on_completed(id, resp, "Internal error #2"));
+            return;
         }
     }
     else 
     {
         auto height = _currentUrl.get_int_arg("height", 0);
-        if (!_backend.get_block(_body, height)) {
-            return send(conn, 500, "Internal error #2");
-        }
+        _backend.get_block(height, on_completed(id, resp, "Internal error #2"));
+        return;
     }
 
-    return send(conn, 200, "OK");
+    resp->code = 500;
+    resp->message = "Internal error #2";
 }
 
-bool Server::send_blocks(const HttpConnection::Ptr& conn) {
+void Server::send_blocks(uint64_t id, const Response::Ptr& resp) {
     auto start = _currentUrl.get_int_arg("height", 0);
     auto n = _currentUrl.get_int_arg("n", 0);
     if (start <= 0 || n < 0) {
-        return send(conn, 400, "Bad request");
+        resp->code = 400;
+        resp->message = "Bad request";
+        return;
+    }
+    if (n == 0) n = 1;
+    else if (uint64_t(n) > MAX_BLOCKS) n = MAX_BLOCKS;
+
+    if (_currentMinorVersion >= 1 && uint64_t(n) > BLOCKS_PART) {
+        stream_blocks(id, resp, start, n);
+        return;
+    }
+    _backend.get_blocks(start, n, on_completed(id, resp, "Internal error #3"));
+}
+
+void Server::stream_blocks(uint64_t id, const Response::Ptr& resp, Height start, uint64_t n) {
+    static const io::SharedBuffer leftBracket = static_buffer("[");
+    static const io::SharedBuffer comma = static_buffer(",");
+    static const io::SharedBuffer rightBracket = static_buffer("]");
+
+    // descending from the top, as get_blocks does
+    Height bottom = start;
+    Height end = start + n - 1;
+    Height top = end;
+
+    resp->nextPart = [this, id, end, top, bottom](const Response::Ptr& r) mutable {
+        uint64_t k = std::min(BLOCKS_PART, top - bottom + 1);
+        bool first = (top == end);
+        bool last = (top - k + 1 == bottom);
+        _backend.get_blocks_part(top - k + 1, k, [this, id, r, first, last](bool ok, io::SerializedMsg& part) {
+            r->partPending = false;
+            if (!ok) {
+                r->code = 500;
+                r->message = "Internal error #3";
+            } else {
+                r->body.push_back(first ? leftBracket : comma);
+                for (auto& f : part) r->body.push_back(std::move(f));
+                if (last) r->body.push_back(rightBracket);
+                r->lastPart = last;
+            }
+            flush(id);
+        });
+        top -= k;
+    };
+}
+
+void Server::send_peers(uint64_t id, const Response::Ptr& resp) {
+    if (!_backend.get_peers(resp->body)) {
+        resp->code = 500;
+        resp->message = "Internal error #3";
+        return;
+    }
+    resp->code = 200;
+    resp->message = "OK";
+}
+
+void Server::send_metrics(uint64_t id, const Response::Ptr& resp) {
+    std::string text;
+    metrics::Registry::get().Write(text);
+
+    resp->body.push_back(io::SharedBuffer(text.data(), text.size()));
+    resp->contentType = "text/plain; version=0.0.4";
+    resp->code = 200;
+    resp->message = "OK";
+}
+
+bool Server::check_indexes(const Response::Ptr& resp) {
+    if (_backend.has_indexes()) return true;
+    resp->code = 404;
+    resp->message = "Not Found";
+    return false;
+}
+
+void Server::send_kernels(uint64_t id, const Response::Ptr& resp) {
+    if (!check_indexes(resp)) return;
+
+    auto cursor = _currentUrl.get_int_arg("cursor", 0);
+    auto n = _currentUrl.get_int_arg("n", 0);
+    if (cursor < 0 || n < 0) {
+        resp->code = 400;
+        resp->message = "Bad request";
+        return;
     }
-    if (!_backend.get_blocks(_body, start, n)) {
-        return send(conn, 500, "Internal error #3");
+
+    if (_currentUrl.has_arg("fee")) {
+        auto fee = _currentUrl.get_int_arg("fee", -1);
+        if (fee >= 0) {
+            _backend.get_kernels_by_fee(fee, cursor, n, on_completed(id, resp, "Internal error #4"));
+            return;
+        }
+    } else if (_currentUrl.has_arg("lock_height")) {
+        auto height = _currentUrl.get_int_arg("lock_height", -1);
+        if (height >= 0) {
+            _backend.get_kernels_by_lock_height(height, cursor, n, on_completed(id, resp, "Internal error #4"));
+            return;
+        }
     }
-    return send(conn, 200, "OK");
+
+    resp->code = 400;
+    resp->message = "Bad request";
 }
 
-bool Server::send_peers(const HttpConnection::Ptr& conn) {
-    if (!_backend.get_peers(_body)) {
-        return send(conn, 500, "Internal error #3");
+void Server::send_asset(uint64_t id, const Response::Ptr& resp) {
+    if (!check_indexes(resp)) return;
+
+    auto assetId = _currentUrl.get_int_arg("id", 0);
+    auto cursor = _currentUrl.get_int_arg("cursor", 0);
+    auto n = _currentUrl.get_int_arg("n", 0);
+    if (assetId <= 0 || cursor < 0 || n < 0) {
+        resp->code = 400;
+        resp->message = "Bad request";
+        return;
     }
-    return send(conn, 200, "OK");
+    _backend.get_asset_history(assetId, cursor, n, on_completed(id, resp, "Internal error #5"));
 }
 
-bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message) {
+void Server::send_blocks_by_time(uint64_t id, const Response::Ptr& resp) {
+    if (!check_indexes(resp)) return;
+
+    auto from = _currentUrl.get_int_arg("from_time", 0);
+    auto to = _currentUrl.get_int_arg("to_time", std::numeric_limits<int64_t>::max());
+    auto cursor = _currentUrl.get_int_arg("cursor", 0);
+    auto n = _currentUrl.get_int_arg("n", 0);
+    if (from < 0 || to < from || cursor < 0 || n < 0) {
+        resp->code = 400;
+        resp->message = "Bad request";
+        return;
+    }
+    _backend.get_blocks_by_time(from, to, cursor, n, on_completed(id, resp, "Internal error #6"));
+}
+
+bool Server::flush(uint64_t id) {
+    auto it = _connections.find(id);
+    if (it == _connections.end()) return false; // closed meanwhile
+
+    const HttpConnection::Ptr& conn = it->second;
+    auto& queue = _responses[id];
+
+    while (!queue.empty()) {
+        Response& resp = *queue.front();
+
+        if (resp.nextPart && !resp.code) {
+            if (resp.partPending) break;
+
+            if (resp.body.empty() && !resp.lastPart) {
+                if (conn->get_Unsent() > MAX_UNSENT) {
+                    // no drain notification from the stream, poll
+                    _timers.set_timer(id, DRAIN_POLL_INTERVAL, [this, id] { service(id); });
+                    break;
+                }
+                resp.partPending = true;
+                resp.nextPart(queue.front());
+                break;
+            }
+
+            if (!send_part(conn, resp)) {
+                close_connection(id);
+                return false;
+            }
+            if (!resp.lastPart) continue;
+        } else {
+            if (!resp.code) break;
+
+            // a streamed response failed midway, the peer sees it truncated
+            if (resp.headersSent || !send(conn, resp)) {
+                close_connection(id);
+                return false;
+            }
+        }
+
+        bool keepAlive = resp.keepAlive;
+        queue.pop_front();
+
+        if (!keepAlive) {
+            close_connection(id);
+            return false;
+        }
+    }
+
+    if (_paused.count(id) && queue.size() <= MAX_PIPELINED / 2) {
+        _paused.erase(id);
+        if (!conn->resume_reading()) {
+            close_connection(id);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Server::service(uint64_t id) {
+    auto it = _connections.find(id);
+    if (it == _connections.end()) return;
+
+    if (!_paused.count(id) && _responses[id].size() >= MAX_PIPELINED) {
+        it->second->pause_reading();
+        _paused.insert(id);
+    }
+    flush(id);
+}
+
+void Server::close_connection(uint64_t id) {
+    auto it = _connections.find(id);
+    if (it != _connections.end()) {
+        it->second->shutdown();
+        _connections.erase(it);
+    }
+    _responses.erase(id);
+    _paused.erase(id);
+    _timers.cancel(id);
+}
+
+bool Server::compress(Response& resp, bool finish) {
+    if (!resp.compressor) resp.compressor = std::make_unique<HttpCompressor>(resp.encoding);
+
+    io::SerializedMsg out;
+    if (!resp.compressor->compress(resp.body, out, finish)) {
+        LOG_ERROR() << STS << "cannot compress response";
+        return false;
+    }
+    resp.body.swap(out);
+    return true;
+}
+
+bool Server::send(const HttpConnection::Ptr& conn, Response& resp) {
     assert(conn);
 
+    if (resp.code != 200) resp.body.clear();
+
     size_t bodySize = 0;
-    for (const auto& f : _body) { bodySize += f.size; }
+    for (const auto& f : resp.body) { bodySize += f.size; }
+
+    HeaderPair headers[3];
+    size_t numHeaders = 0;
+
+    if (resp.encoding != HttpCompressor::identity && bodySize >= MIN_COMPRESSED_SIZE && compress(resp, true)) {
+        bodySize = 0;
+        for (const auto& f : resp.body) { bodySize += f.size; }
+        headers[numHeaders++] = HeaderPair("Content-Encoding", HttpCompressor::name(resp.encoding));
+        headers[numHeaders++] = HeaderPair("Vary", "Accept-Encoding");
+    }
+    if (!resp.keepAlive) {
+        headers[numHeaders++] = HeaderPair("Connection", "close");
+    }
 
     bool ok = _msgCreator.create_response(
         _headers,
-        code,
-        message,
-        0, //headers,
-        0, //sizeof(headers) / sizeof(HeaderPair),
+        resp.code,
+        resp.message,
+        headers,
+        numHeaders,
         1,
-        "application/json",
+        resp.contentType,
         bodySize
     );
 
     if (ok) {
         auto result = conn->write_msg(_headers);
         if (result && bodySize > 0) {
-            result = conn->write_msg(_body);
+            result = conn->write_msg(resp.body);
         }
         if (!result) ok = false;
     } else {
@@ -243,8 +541,43 @@ bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message
     }
 
     _headers.clear();
-    _body.clear();
-    return (ok && code == 200);
+    return (ok && resp.code == 200);
+}
+
+bool Server::send_part(const HttpConnection::Ptr& conn, Response& resp) {
+    assert(conn);
+
+    bool compressed = (resp.encoding != HttpCompressor::identity);
+    if (compressed && !compress(resp, resp.lastPart)) return false;
+
+    bool ok = true;
+    if (!resp.headersSent) {
+        // along with the first part, so that it can still fail with a status
+        HeaderPair headers[5];
+        size_t numHeaders = 0;
+        headers[numHeaders++] = HeaderPair("Transfer-Encoding", "chunked");
+        headers[numHeaders++] = HeaderPair("Content-Type", "application/json");
+        if (compressed) {
+            headers[numHeaders++] = HeaderPair("Content-Encoding", HttpCompressor::name(resp.encoding));
+            headers[numHeaders++] = HeaderPair("Vary", "Accept-Encoding");
+        }
+        if (!resp.keepAlive) {
+            headers[numHeaders++] = HeaderPair("Connection", "close");
+        }
+        ok = _msgCreator.create_response(_headers, 200, "OK", headers, numHeaders, 1);
+        if (!ok) LOG_ERROR() << STS << "cannot create response";
+        resp.headersSent = true;
+    }
+
+    if (ok) {
+        append_chunk(_headers, resp.body);
+        if (resp.lastPart) append_last_chunk(_headers);
+        if (!conn->write_msg(_headers)) ok = false;
+    }
+
+    resp.body.clear();
+    _headers.clear();
+    return ok;
 }
 
 Server::IPAccessControl::IPAccessControl(const std::string &ipsFileName) :
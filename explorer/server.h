@@ -14,11 +14,13 @@
 
 #include "http/http_connection.h"
 #include "http/http_msg_creator.h"
+#include "http/http_compressor.h"
 #include "utility/io/tcpserver.h"
 #include "utility/io/coarsetimer.h"
 #include "utility/helpers.h"
 #include <string_view>
 #include <set>
+#include <deque>
 
 namespace beam { namespace explorer {
 
@@ -48,12 +50,42 @@ private:
 
     void on_stream_accepted(io::TcpStream::Ptr&& newStream, io::ErrorCode errorCode);
 
+    struct Response {
+        using Ptr = std::shared_ptr<Response>;
+        int code = 0; // not ready yet
+        const char* message = nullptr;
+        io::SerializedMsg body;
+        const char* contentType = "application/json";
+        bool keepAlive = true;
+        HttpCompressor::Encoding encoding = HttpCompressor::identity;
+
+        // chunked response: the body is produced part by part as the connection drains,
+        // the code is set only on error
+        std::function<void(const Ptr&)> nextPart;
+        std::unique_ptr<HttpCompressor> compressor;
+        bool partPending = false;
+        bool lastPart = false;
+        bool headersSent = false;
+    };
+
     bool on_request(uint64_t id, const HttpMsgReader::Message& msg);
-    bool send_status(const HttpConnection::Ptr& conn);
-    bool send_block(const HttpConnection::Ptr& conn);
-    bool send_blocks(const HttpConnection::Ptr& conn);
-    bool send_peers(const HttpConnection::Ptr& conn);
-    bool send(const HttpConnection::Ptr& conn, int code, const char* message);
+    void send_status(uint64_t id, const Response::Ptr& resp);
+    void send_block(uint64_t id, const Response::Ptr& resp);
+    void send_blocks(uint64_t id, const Response::Ptr& resp);
+    void send_peers(uint64_t id, const Response::Ptr& resp);
+    void send_kernels(uint64_t id, const Response::Ptr& resp);
+    void send_asset(uint64_t id, const Response::Ptr& resp);
+    void send_blocks_by_time(uint64_t id, const Response::Ptr& resp);
+    void send_metrics(uint64_t id, const Response::Ptr& resp);
+    bool check_indexes(const Response::Ptr& resp);
+    std::function<void(bool, io::SerializedMsg&)> on_completed(uint64_t id, const Response::Ptr& resp, const char* error);
+    void stream_blocks(uint64_t id, const Response::Ptr& resp, Height start, uint64_t n);
+    bool flush(uint64_t id);
+    void service(uint64_t id);
+    void close_connection(uint64_t id);
+    bool send(const HttpConnection::Ptr& conn, Response& resp);
+    bool send_part(const HttpConnection::Ptr& conn, Response& resp);
+    bool compress(Response& resp, bool finish);
 
     HttpMsgCreator _msgCreator;
     IAdapter& _backend;
@@ -62,9 +94,13 @@ private:
     io::Address _bindAddress;
     io::TcpServer::Ptr _server;
     std::map<uint64_t, HttpConnection::Ptr> _connections;
+    // responses are sent in the order of requests, whereas blocks are completed asynchronously
+    std::map<uint64_t, std::deque<Response::Ptr>> _responses;
+    // connections not read until the pipelined responses are sent
+    std::set<uint64_t> _paused;
     HttpUrl _currentUrl;
+    int _currentMinorVersion = 1;
     io::SerializedMsg _headers;
-    io::SerializedMsg _body;
     //AccessControl _acl;
     IPAccessControl _acl;
     std::vector<uint32_t> _whitelist;
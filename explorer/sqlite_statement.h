@@ -0,0 +1,102 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "sqlite/sqlite3.h"
+#include "utility/logger.h"
+#include <string>
+
+namespace beam { namespace explorer {
+
+/// Prepared statement for the explorer's own sqlite files, errors are logged
+struct SqliteStatement {
+    sqlite3_stmt* s = nullptr;
+
+    SqliteStatement(sqlite3* db, const char* sql) {
+        if (sqlite3_prepare_v2(db, sql, -1, &s, nullptr) != SQLITE_OK) {
+            LOG_ERROR() << "Explorer DB: " << sqlite3_errmsg(db);
+            s = nullptr;
+        }
+    }
+
+    ~SqliteStatement() {
+        if (s) sqlite3_finalize(s);
+    }
+
+    SqliteStatement(const SqliteStatement&) = delete;
+    SqliteStatement& operator=(const SqliteStatement&) = delete;
+
+    explicit operator bool() const { return s != nullptr; }
+
+    bool step() { return sqlite3_step(s) == SQLITE_ROW; }
+    bool exec() { return sqlite3_step(s) == SQLITE_DONE; }
+
+    void bind(int i, uint64_t x) { sqlite3_bind_int64(s, i, static_cast<sqlite3_int64>(x)); }
+    void bind(int i, const void* p, size_t n) { sqlite3_bind_blob(s, i, p, static_cast<int>(n), SQLITE_STATIC); }
+
+    template <typename T>
+    void bind_blob(int i, const T& x) { bind(i, x.m_pData, x.nBytes); }
+
+    uint64_t get(int i) { return static_cast<uint64_t>(sqlite3_column_int64(s, i)); }
+
+    /// false if the size doesn't match
+    template <typename T>
+    bool get_blob(int i, T& x) {
+        if (sqlite3_column_bytes(s, i) != static_cast<int>(x.nBytes)) return false;
+        memcpy(x.m_pData, sqlite3_column_blob(s, i), x.nBytes);
+        return true;
+    }
+};
+
+inline bool sqlite_exec(sqlite3* db, const char* sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) == SQLITE_OK) return true;
+
+    LOG_ERROR() << "Explorer DB: " << (err ? err : sql);
+    sqlite3_free(err);
+    return false;
+}
+
+/// Opens (creates) the file in WAL mode. If the format version differs the tables are dropped by dropSql,
+/// then createSql is run. Returns nullptr on error
+inline sqlite3* sqlite_open(const std::string& path, int version, const char* dropSql, const char* createSql) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        LOG_ERROR() << "Explorer DB: cannot open " << path;
+        sqlite3_close(db);
+        return nullptr;
+    }
+
+    int v = 0;
+    {
+        SqliteStatement st(db, "PRAGMA user_version");
+        if (st && st.step()) v = static_cast<int>(st.get(0));
+    }
+
+    bool ok =
+        sqlite_exec(db, "PRAGMA journal_mode = WAL") &&
+        sqlite_exec(db, "PRAGMA synchronous = NORMAL") && // derived data, can be rebuilt
+        ((v == version) || sqlite_exec(db, dropSql)) &&
+        sqlite_exec(db, createSql) &&
+        sqlite_exec(db, ("PRAGMA user_version = " + std::to_string(version)).c_str());
+
+    if (!ok) {
+        sqlite3_close(db);
+        return nullptr;
+    }
+    return db;
+}
+
+}} //namespaces
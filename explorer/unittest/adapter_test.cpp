@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "explorer/adapter.h"
+#include "explorer/block_cache.h"
+#include "explorer/indexer.h"
 #include "node/node.h"
 #include "utility/logger.h"
 #include <future>
@@ -35,6 +37,12 @@ struct NodeParams {
 
 static const uint16_t NODE_PORT=20000;
 
+#define FILENAME "_xx"
+
+static int g_failures = 0;
+static int g_blocksReceived = 0;
+static int g_indexPagesReceived = 0;
+
 WaitHandle run_node(const NodeParams& params) {
     WaitHandle ret;
     io::Reactor::Ptr reactor = io::Reactor::create();
@@ -45,6 +53,7 @@ WaitHandle run_node(const NodeParams& params) {
             io::Reactor::Scope scope(*reactor);
             beam::Node node;
 
+            node.m_Cfg.m_sPathLocal = FILENAME ".db";
             node.m_Cfg.m_Listen.port(params.nodeAddress.port());
             node.m_Cfg.m_Listen.ip(params.nodeAddress.ip());
             node.m_Cfg.m_MiningThreads = 1;
@@ -61,10 +70,39 @@ WaitHandle run_node(const NodeParams& params) {
                 LOG_INFO() << "Treasury blocks read: " << node.m_Cfg.m_Treasury.size();
             }
 
-            explorer::IAdapter::Ptr adapter = explorer::create_adapter(node);
+            explorer::IAdapter::Ptr adapter = explorer::create_adapter(node, 1U << 20, true);
 
             LOG_INFO() << "starting a node on " << node.m_Cfg.m_Listen.port() << " port...";
             node.Initialize();
+
+            // blocks are served by the adapter workers, from the read-only DB snapshot
+            io::Timer::Ptr timer = io::Timer::create(*reactor);
+            timer->start(2000, false, [&adapter]() {
+                adapter->get_blocks(1, 3, [](bool ok, io::SerializedMsg& out) {
+                    std::string s;
+                    for (const auto& x : out) s.append((const char*) x.data, x.size);
+                    LOG_INFO() << "blocks: " << s;
+
+                    if (!ok || s.empty() || (s.front() != '[') || (s.back() != ']')) {
+                        LOG_ERROR() << "get_blocks failed";
+                        g_failures++;
+                    }
+                    g_blocksReceived++;
+                });
+
+                adapter->get_blocks_by_time(0, std::numeric_limits<int64_t>::max(), 0, 2, [](bool ok, io::SerializedMsg& out) {
+                    std::string s;
+                    for (const auto& x : out) s.append((const char*) x.data, x.size);
+                    LOG_INFO() << "blocks by time: " << s;
+
+                    if (!ok || (s.find("{\"items\":[") != 0) || (s.find("\"next\":") == std::string::npos)) {
+                        LOG_ERROR() << "get_blocks_by_time failed";
+                        g_failures++;
+                    }
+                    g_indexPagesReceived++;
+                });
+            });
+
             reactor->run();
         }
     );
@@ -73,11 +111,196 @@ WaitHandle run_node(const NodeParams& params) {
     return ret;
 }
 
-#define FILENAME "_xx"
-
 void cleanup_files() {
     boost::filesystem::remove_all(FILENAME);
     boost::filesystem::remove_all(FILENAME "_");
+    boost::filesystem::remove_all(FILENAME ".db");
+    boost::filesystem::remove_all(FILENAME "-utxo-image.bin");
+    boost::filesystem::remove_all(FILENAME "-utxo-image.bin.journal");
+    boost::filesystem::remove_all(FILENAME ".db-blocks.db");
+    boost::filesystem::remove_all(FILENAME ".db-blocks.db-wal");
+    boost::filesystem::remove_all(FILENAME ".db-blocks.db-shm");
+    boost::filesystem::remove_all(FILENAME ".db-index.db");
+    boost::filesystem::remove_all(FILENAME ".db-index.db-wal");
+    boost::filesystem::remove_all(FILENAME ".db-index.db-shm");
+}
+
+#define EXPLORER_CHECK(x) if (!(x)) { LOG_ERROR() << "FAILED: " #x " at line " << __LINE__; g_failures++; }
+
+void test_block_cache() {
+    using explorer::BlockCache;
+
+    const std::string json = "{\"chainwork\":\"0x1f3\",\"hash\":\"0a1b2c3d4e5f60718293a4b5c6d7e8f90a1b2c3d4e5f60718293a4b5c6d7e8f9\","
+        "\"height\":12345678901,\"odd\":\"abcdef012\",\"s\":\"\xd0\xbf\x80\xff\"}";
+
+    std::string big;
+    for (int i = 0; i < 300; i++) big += "0123456789abcdef";
+
+    for (const std::string& s : { json, big, std::string("1"), std::string("a,"), std::string() }) {
+        ByteBuffer packed;
+        BlockCache::pack(packed, s.data(), s.size());
+        io::SharedBuffer res;
+        EXPLORER_CHECK(BlockCache::unpack(res, packed.data(), packed.size()));
+        EXPLORER_CHECK(std::string((const char*)res.data, res.size) == s);
+    }
+
+    {
+        ByteBuffer packed;
+        BlockCache::pack(packed, big.data(), big.size());
+#ifdef BEAM_EXPLORER_ZLIB
+        EXPLORER_CHECK(packed.size() < big.size() / 10);
+#endif // BEAM_EXPLORER_ZLIB
+        EXPLORER_CHECK(packed.size() <= big.size() + 1); // never expanded beyond the tag
+
+        uint8_t bad[] = { 1, 0x10, 0, 0, 0, 1, 2 };
+        io::SharedBuffer res;
+        EXPLORER_CHECK(!BlockCache::unpack(res, bad, sizeof(bad)));
+        EXPLORER_CHECK(!BlockCache::unpack(res, bad, 0));
+    }
+
+    const char* path = FILENAME ".db-blocks.db";
+    Merkle::Hash h1, h2;
+    h1 = 1U;
+    h2 = 2U;
+    io::SharedBuffer body(json.data(), json.size()), res;
+
+    {
+        BlockCache bc;
+        EXPLORER_CHECK(bc.open(path, 1U << 20));
+        for (Height h = 1; h <= 10; h++) bc.put(h, h1, body);
+
+        EXPLORER_CHECK(bc.get(5, h1, res));
+        EXPLORER_CHECK(std::string((const char*)res.data, res.size) == json);
+        EXPLORER_CHECK(!bc.get(5, h2, res)); // replaced block
+        EXPLORER_CHECK(!bc.get(11, h1, res));
+
+        bc.truncate(8);
+        EXPLORER_CHECK(bc.get_top() == 7);
+    }
+
+    {
+        // persistent, evicts the lowest
+        BlockCache bc;
+        EXPLORER_CHECK(bc.open(path, 800));
+        EXPLORER_CHECK(bc.get(7, h1, res));
+        bc.put(8, h2, body);
+        EXPLORER_CHECK(bc.get(8, h2, res));
+        EXPLORER_CHECK(!bc.get(1, h1, res));
+        EXPLORER_CHECK(bc.get_top() == 8);
+    }
+
+    cleanup_files();
+}
+
+void test_indexer() {
+    using explorer::Indexer;
+
+    const char* path = FILENAME ".db-index.db";
+
+    // synthetic chain, each block with a couple of kernels
+    std::vector<Block::SystemState::Full> states(10);
+    std::vector<std::vector<TxKernel::Ptr> > kernels(states.size());
+    PeerID owner;
+    owner = 7U;
+
+    for (size_t i = 0; i < states.size(); i++) {
+        auto& s = states[i];
+        s.m_Height = Rules::HeightGenesis + i;
+        s.m_TimeStamp = 1000 + i * 60;
+        if (i) states[i - 1].get_Hash(s.m_Prev);
+
+        for (uint32_t k = 0; k < 2; k++) {
+            auto krn = std::make_unique<TxKernelStd>();
+            krn->m_Fee = 100 * (k + 1);
+            krn->m_Height.m_Min = (i % 3) ? 0 : 5;
+            krn->m_Internal.m_ID = static_cast<uint32_t>(i * 2 + k);
+            kernels[i].push_back(std::move(krn));
+        }
+    }
+
+    // block 3 creates the asset, block 5 emits (nested), block 8 destroys it
+    {
+        auto krn = std::make_unique<TxKernelAssetCreate>();
+        krn->m_Owner = owner;
+        kernels[2].push_back(std::move(krn));
+
+        auto emit = std::make_unique<TxKernelAssetEmit>();
+        emit->m_Owner = owner;
+        emit->m_AssetID = 3;
+        emit->m_Value = -50;
+        kernels[4].back()->m_vNested.push_back(std::move(emit));
+
+        auto destroy = std::make_unique<TxKernelAssetDestroy>();
+        destroy->m_Owner = owner;
+        destroy->m_AssetID = 3;
+        kernels[7].push_back(std::move(destroy));
+    }
+
+    {
+        Indexer idx;
+        EXPLORER_CHECK(idx.open(path));
+        EXPLORER_CHECK(!idx.add_block(states[1], kernels[1])); // not from the genesis
+        for (size_t i = 0; i < 8; i++) {
+            EXPLORER_CHECK(idx.add_block(states[i], kernels[i]));
+        }
+        EXPLORER_CHECK(!idx.add_block(states[9], kernels[9])); // gap
+        EXPLORER_CHECK(!idx.add_block(states[7], kernels[7])); // dup
+
+        // resolved by the emit
+        std::vector<Indexer::AssetEvent> events;
+        EXPLORER_CHECK(!idx.get_asset_history(3, 0, 10, events));
+        EXPLORER_CHECK(events.size() == 3);
+        if (events.size() == 3) {
+            EXPLORER_CHECK(events[0].kind == Indexer::AssetEvent::Create && events[0].height == 3);
+            EXPLORER_CHECK(events[1].kind == Indexer::AssetEvent::Emit && events[1].value == -50);
+            EXPLORER_CHECK(events[2].kind == Indexer::AssetEvent::Destroy && events[2].height == 8);
+        }
+
+        // pagination
+        std::vector<Indexer::Kernel> v;
+        uint64_t cursor = idx.get_kernels_by_fee(200, 0, 3, v);
+        EXPLORER_CHECK(cursor && v.size() == 3);
+        cursor = idx.get_kernels_by_fee(200, cursor, 3, v);
+        EXPLORER_CHECK(cursor && v.size() == 6);
+        cursor = idx.get_kernels_by_fee(200, cursor, 3, v);
+        EXPLORER_CHECK(!cursor && v.size() == 8);
+        for (size_t i = 0; i < v.size(); i++) {
+            EXPLORER_CHECK(v[i].height == Rules::HeightGenesis + i && v[i].fee == 200);
+        }
+
+        v.clear();
+        EXPLORER_CHECK(!idx.get_kernels_by_lock_height(5, 0, 100, v));
+        EXPLORER_CHECK(v.size() == 6); // 2 at heights 1, 4, 7
+
+        idx.commit();
+    }
+
+    {
+        // persistent, rolled back
+        Indexer idx;
+        EXPLORER_CHECK(idx.open(path));
+
+        Height h = 0;
+        Merkle::Hash hash;
+        EXPLORER_CHECK(idx.get_top(h, hash) && h == 8);
+
+        EXPLORER_CHECK(idx.truncate(6));
+        EXPLORER_CHECK(idx.get_top(h, hash) && h == 5);
+
+        std::vector<Indexer::AssetEvent> events;
+        idx.get_asset_history(3, 0, 10, events);
+        EXPLORER_CHECK(events.size() == 2);
+
+        EXPLORER_CHECK(idx.add_block(states[5], kernels[5]));
+
+        std::vector<Indexer::BlockInfo> blocks;
+        uint64_t cursor = idx.get_blocks_by_time(1060, 1240, 0, 2, blocks);
+        EXPLORER_CHECK(cursor == 3 && blocks.size() == 2);
+        EXPLORER_CHECK(!idx.get_blocks_by_time(1060, 1240, cursor, 2, blocks));
+        EXPLORER_CHECK(blocks.size() == 4 && blocks.back().height == 5);
+    }
+
+    cleanup_files();
 }
 
 int test_adapter(int seconds) {
@@ -99,7 +322,17 @@ int test_adapter(int seconds) {
     nodeWH.reactor->stop();
     nodeWH.future.get();
 
-    return 0;
+    if (!g_blocksReceived) {
+        LOG_ERROR() << "no blocks received";
+        g_failures++;
+    }
+
+    if (!g_indexPagesReceived) {
+        LOG_ERROR() << "no index pages received";
+        g_failures++;
+    }
+
+    return g_failures;
 }
 
 } //namespace
@@ -132,6 +365,9 @@ int main(int argc, char* argv[]) {
         Rules::get().FakePoW = true;
     }
 
+    test_block_cache();
+    test_indexer();
+
     int ret = test_adapter(seconds);
     return ret;
 }
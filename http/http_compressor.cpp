@@ -0,0 +1,174 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "http_compressor.h"
+#include "utility/logger.h"
+#include <string_view>
+#include <cstdlib>
+#include <ctype.h>
+
+#ifdef BEAM_HTTP_ZLIB
+#include <zlib.h>
+#endif
+
+namespace beam {
+
+#ifdef BEAM_HTTP_ZLIB
+namespace {
+
+static const size_t OUT_FRAGMENT_SIZE = 16384;
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && isspace((unsigned char)s.front())) s.remove_prefix(1);
+    while (!s.empty() && isspace((unsigned char)s.back())) s.remove_suffix(1);
+    return s;
+}
+
+static bool equal_ci(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (tolower((unsigned char)a[i]) != b[i]) return false;
+    }
+    return true;
+}
+
+} //namespace
+#endif // BEAM_HTTP_ZLIB
+
+HttpCompressor::Encoding HttpCompressor::select(const std::string& acceptEncoding) {
+#ifdef BEAM_HTTP_ZLIB
+    bool gzipOk = false, deflateOk = false, any = false, gzipRefused = false;
+
+    std::string_view s(acceptEncoding);
+    while (!s.empty()) {
+        auto pos = s.find(',');
+        std::string_view item = s.substr(0, pos);
+        s = (pos == std::string_view::npos) ? std::string_view() : s.substr(pos + 1);
+
+        // coding[;q=value], q=0 means not acceptable
+        bool refused = false;
+        pos = item.find(';');
+        if (pos != std::string_view::npos) {
+            std::string_view q = trim(item.substr(pos + 1));
+            if (q.size() > 2 && (q[0] == 'q' || q[0] == 'Q') && q[1] == '=') {
+                refused = (strtod(std::string(q.substr(2)).c_str(), nullptr) <= 0);
+            }
+            item = item.substr(0, pos);
+        }
+
+        item = trim(item);
+        if (equal_ci(item, "gzip") || equal_ci(item, "x-gzip")) {
+            gzipOk = !refused;
+            gzipRefused = refused;
+        } else if (equal_ci(item, "deflate")) {
+            deflateOk = !refused;
+        } else if (item == "*") {
+            any = !refused;
+        }
+    }
+
+    if (gzipOk || (any && !gzipRefused)) return gzip;
+    if (deflateOk) return deflate;
+#endif
+    (void)acceptEncoding;
+    return identity;
+}
+
+const char* HttpCompressor::name(Encoding e) {
+    switch (e) {
+        case gzip: return "gzip";
+        case deflate: return "deflate";
+        default: return "identity";
+    }
+}
+
+#ifdef BEAM_HTTP_ZLIB
+
+struct HttpCompressor::Impl {
+    z_stream zs;
+    bool ok = false;
+
+    explicit Impl(Encoding e) {
+        zs = z_stream();
+        // windowBits+16 for the gzip wrapper, "deflate" in http is the zlib format
+        int windowBits = (e == gzip) ? 15 + 16 : 15;
+        ok = (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+        if (!ok) LOG_ERROR() << "deflateInit2 failed";
+    }
+
+    ~Impl() {
+        if (ok) deflateEnd(&zs);
+    }
+
+    bool run(const void* p, size_t size, int flush, io::SerializedMsg& out, std::pair<uint8_t*, io::SharedMem>& buf, size_t& used) {
+        zs.next_in = (Bytef*)p;
+        zs.avail_in = static_cast<uInt>(size);
+
+        while (true) {
+            if (!buf.first || used == OUT_FRAGMENT_SIZE) {
+                if (buf.first) out.push_back(io::SharedBuffer(buf.first, used, std::move(buf.second)));
+                buf = io::alloc_heap(OUT_FRAGMENT_SIZE);
+                used = 0;
+            }
+
+            zs.next_out = buf.first + used;
+            zs.avail_out = static_cast<uInt>(OUT_FRAGMENT_SIZE - used);
+
+            int ret = ::deflate(&zs, flush);
+            used = OUT_FRAGMENT_SIZE - zs.avail_out;
+
+            if (ret == Z_STREAM_ERROR) return false;
+            if (flush == Z_FINISH) {
+                if (ret == Z_STREAM_END) return true;
+            } else if (zs.avail_in == 0 && zs.avail_out != 0) {
+                return true;
+            }
+        }
+    }
+};
+
+HttpCompressor::HttpCompressor(Encoding e) : _impl(std::make_unique<Impl>(e))
+{}
+
+bool HttpCompressor::compress(const io::SerializedMsg& in, io::SerializedMsg& out, bool finish) {
+    if (!_impl->ok) return false;
+
+    std::pair<uint8_t*, io::SharedMem> buf;
+    size_t used = 0;
+
+    for (const auto& f : in) {
+        if (f.size && !_impl->run(f.data, f.size, Z_NO_FLUSH, out, buf, used)) return false;
+    }
+
+    if (!_impl->run(nullptr, 0, finish ? Z_FINISH : Z_SYNC_FLUSH, out, buf, used)) return false;
+
+    if (used) out.push_back(io::SharedBuffer(buf.first, used, std::move(buf.second)));
+    return true;
+}
+
+#else
+
+struct HttpCompressor::Impl {};
+
+HttpCompressor::HttpCompressor(Encoding) {}
+
+bool HttpCompressor::compress(const io::SerializedMsg&, io::SerializedMsg&, bool) {
+    return false;
+}
+
+#endif // BEAM_HTTP_ZLIB
+
+HttpCompressor::~HttpCompressor() = default;
+
+} //namespace
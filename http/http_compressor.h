@@ -0,0 +1,49 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "utility/io/buffer.h"
+#include <memory>
+#include <string>
+
+namespace beam {
+
+/// Content-Encoding of the response bodies. Streaming, so that a chunked body is compressed part by part.
+/// Available if built with zlib, otherwise the identity encoding is always selected
+class HttpCompressor {
+public:
+    enum Encoding { identity, gzip, deflate };
+
+    /// Picks the encoding by the Accept-Encoding request header, gzip is preferred
+    static Encoding select(const std::string& acceptEncoding);
+
+    /// Content-Encoding header value
+    static const char* name(Encoding e);
+
+    explicit HttpCompressor(Encoding e);
+    ~HttpCompressor();
+
+    HttpCompressor(const HttpCompressor&) = delete;
+    HttpCompressor& operator=(const HttpCompressor&) = delete;
+
+    /// Appends the compressed fragments to out. If not finished, the output is flushed
+    /// so that the peer can decode everything sent so far
+    bool compress(const io::SerializedMsg& in, io::SerializedMsg& out, bool finish);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+} //namespace
@@ -41,15 +41,24 @@ public:
             bodySizeThreshold
         )
     {
-        _stream->enable_read(
-            [this](io::ErrorCode what, void* data, size_t size) -> bool
-            { return _msgReader.new_data_from_stream(what, data, size); }
-        );
+        resume_reading();
     }
 
     uint64_t id() const override { return _msgReader.id(); }
     void change_id(uint64_t newId) override { _msgReader.change_id(newId); }
 
+    /// Stops reading the pipelined requests until resumed. Not from within the message callback
+    void pause_reading() {
+        _stream->disable_read();
+    }
+
+    bool resume_reading() {
+        return bool(_stream->enable_read(
+            [this](io::ErrorCode what, void* data, size_t size) -> bool
+            { return _msgReader.new_data_from_stream(what, data, size); }
+        ));
+    }
+
 private:
     HttpMsgReader _msgReader;
 };
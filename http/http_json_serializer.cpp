@@ -31,6 +31,15 @@ bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const js
     return result;
 }
 
+bool write_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const std::function<void(JsonWriter&)>& fn) {
+    size_t initialFragments = out.size();
+    io::FragmentWriter& fw = packer.acquire_writer(out);
+    bool result = write_json_msg(fw, fn);
+    packer.release_writer();
+    if (!result) out.resize(initialFragments);
+    return result;
+}
+
 } //namespace
 
 
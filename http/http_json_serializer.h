@@ -15,13 +15,18 @@
 #pragma once
 #include "nlohmann/json_fwd.hpp"
 #include "utility/io/buffer.h"
+#include <functional>
 
 namespace beam {
 
 class HttpMsgCreator;
+class JsonWriter;
 
 // appends json msg to out by http packer
 bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const nlohmann::json& o);
 
+// appends json msg written by the streaming writer, w/o building the DOM
+bool write_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const std::function<void(JsonWriter&)>& fn);
+
 } //namespace
 
@@ -123,4 +123,23 @@ bool HttpMsgCreator::create_response(
     return create_message(_fragmentWriter, headers, num_headers, content_type, bodySize);
 }
 
+void append_chunk(io::SerializedMsg& out, const io::SerializedMsg& body) {
+    static const io::SharedBuffer crlf("\r\n", 2);
+
+    size_t size = 0;
+    for (const auto& f : body) { size += f.size; }
+    if (!size) return;
+
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%zx\r\n", size);
+    out.push_back(io::SharedBuffer(buf, n));
+    out.insert(out.end(), body.begin(), body.end());
+    out.push_back(crlf);
+}
+
+void append_last_chunk(io::SerializedMsg& out) {
+    static const io::SharedBuffer lastChunk("0\r\n\r\n", 5);
+    out.push_back(lastChunk);
+}
+
 } //namepsace
@@ -83,6 +83,12 @@ private:
     io::SerializedMsg* _currentMsg;
 };
 
+// chunked transfer encoding: appends the body as a chunk, unless it's empty (that'd terminate the message)
+void append_chunk(io::SerializedMsg& out, const io::SerializedMsg& body);
+
+// appends the terminating chunk
+void append_last_chunk(io::SerializedMsg& out);
+
 // appends json msg to out by http packer
 bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const nlohmann::json& o);
 
@@ -305,9 +305,14 @@ private:
         return response_status;
     }
 
+    int get_minor_version() const override {
+        return minor_http_version;
+    }
+
 public:
     std::vector<uint8_t> _body;
     size_t _bodyCursor=0;
+    phr_chunked_decoder _decoder;
 
     void reset(size_t bodySizeThreshold) {
         reset_headers();
@@ -318,6 +323,7 @@ public:
             _body.clear();
         }
         _bodyCursor = 0;
+        _decoder = phr_chunked_decoder();
         _methodCached.clear();
         _pathCached.clear();
         _headersCached.clear();
@@ -347,6 +353,47 @@ public:
         return ret;
     }
 
+    bool parse_chunked() {
+        static const std::string transferEncoding("transfer-encoding");
+        std::string value = find_header(transferEncoding);
+        std::transform(value.begin(), value.end(), value.begin(), [](char c)->char { return (char)tolower(c);} );
+
+        // chunked is the last of the codings if any
+        static const std::string chunked("chunked");
+        if (value.size() < chunked.size() || value.compare(value.size() - chunked.size(), chunked.size(), chunked) != 0)
+            return false;
+
+        _body.clear();
+        _bodyCursor = 0;
+        _decoder = phr_chunked_decoder();
+        _decoder.consume_trailer = 1; // the next pipelined message follows
+        return true;
+    }
+
+    // decodes in place, _bodyCursor is the decoded size
+    size_t feed_chunked(const uint8_t* p, size_t sz, size_t maxLength, bool& completed, HttpMsgReader::What& error) {
+        error = HttpMsgReader::nothing;
+        _body.resize(_bodyCursor);
+        _body.insert(_body.end(), p, p + sz);
+
+        size_t decoded = sz;
+        ssize_t ret = phr_decode_chunked(&_decoder, (char*)_body.data() + _bodyCursor, &decoded);
+        if (ret == -1) {
+            error = HttpMsgReader::message_corrupted;
+            return 0;
+        }
+
+        _bodyCursor += decoded;
+        _body.resize(_bodyCursor);
+        if (_bodyCursor > maxLength) {
+            error = HttpMsgReader::message_too_long;
+            return 0;
+        }
+
+        completed = (ret >= 0);
+        return completed ? sz - size_t(ret) : sz;
+    }
+
     size_t feed_body(const uint8_t* p, size_t sz, bool& completed) {
         assert(_bodyCursor <= _body.size());
         size_t maxBytes = _body.size() - _bodyCursor;
@@ -404,7 +451,11 @@ bool HttpMsgReader::new_data_from_stream(io::ErrorCode connectionStatus, const v
     size_t sz = size;
     size_t consumed = 0;
     while (sz > 0) {
-        consumed = _state == reading_header ? feed_header(p, sz) : feed_body(p, sz);
+        switch (_state) {
+            case reading_header: consumed = feed_header(p, sz); break;
+            case reading_body: consumed = feed_body(p, sz); break;
+            default: consumed = feed_chunked(p, sz); break;
+        }
         if (consumed == 0) {
             // error occured, no more reads from this stream
             // at this moment, the *this* may be deleted
@@ -423,17 +474,14 @@ size_t HttpMsgReader::feed_header(const uint8_t* p, size_t sz) {
     What error = nothing;
     bool headers_completed = _msg->parse_headers(_mode == client, p, sz, consumed, error);
     if (headers_completed) {
+        if (_msg->parse_chunked()) {
+            _state = reading_chunked;
+            return consumed;
+        }
         size_t contentLength = _msg->parse_content_length(_maxBodySize, error);
         if (contentLength == 0) {
             // message w/o body, completed
-            bool proceed = _callback(_streamId, Message(_msg));
-            if (proceed) {
-                _msg->reset(_bodySizeThreshold);
-                return consumed;
-            } else {
-                // the object may be deleted here
-                return 0;
-            }
+            return on_message(consumed);
         } else if (error == nothing) {
             _state = reading_body;
         } else {
@@ -453,19 +501,37 @@ size_t HttpMsgReader::feed_body(const uint8_t* p, size_t sz) {
     bool completed = false;
     size_t consumed = _msg->feed_body(p, sz, completed);
     if (completed) {
-        _state = reading_header;
-        bool proceed = _callback(_streamId, Message(_msg));
-        if (proceed) {
-            _msg->reset(_bodySizeThreshold);
-            _state = reading_header;
-        } else {
-            // the object may be deleted here
-            return 0;
-        }
+        return on_message(consumed);
     }
     return consumed;
 }
 
+size_t HttpMsgReader::feed_chunked(const uint8_t* p, size_t sz) {
+    bool completed = false;
+    What error = nothing;
+    size_t consumed = _msg->feed_chunked(p, sz, _maxBodySize, completed, error);
+    if (error != nothing) {
+        _callback(_streamId, Message(error));
+        // the object may be deleted here
+        return 0;
+    }
+    if (completed) {
+        return on_message(consumed);
+    }
+    return consumed;
+}
+
+size_t HttpMsgReader::on_message(size_t consumed) {
+    _state = reading_header;
+    bool proceed = _callback(_streamId, Message(_msg));
+    if (proceed) {
+        _msg->reset(_bodySizeThreshold);
+        return consumed;
+    }
+    // the object may be deleted here
+    return 0;
+}
+
 void HttpMsgReader::reset() {
     _msg->reset(_bodySizeThreshold);
     _state = reading_header;
@@ -56,9 +56,11 @@ public:
     virtual const std::string& get_header(const std::string& headerName) const = 0;
     virtual const void* get_body(size_t& size) const = 0;
     virtual int get_status() const = 0;
+    virtual int get_minor_version() const = 0;
 };
 
-/// Extracts individual http messages from stream, performs header/size validation
+/// Extracts individual http messages from stream, performs header/size validation.
+/// Pipelined messages are extracted one by one, bodies are either sized or chunked
 class HttpMsgReader {
 public:
     enum What { nothing, http_message, connection_error, message_corrupted, message_too_long };
@@ -102,9 +104,11 @@ public:
 private:
     size_t feed_header(const uint8_t* p, size_t sz);
     size_t feed_body(const uint8_t* p, size_t sz);
+    size_t feed_chunked(const uint8_t* p, size_t sz);
+    size_t on_message(size_t consumed);
 
-    /// 2 states of the reader
-    enum State { reading_header, reading_body };
+    /// States of the reader
+    enum State { reading_header, reading_body, reading_chunked };
 
     /// callback
     Callback _callback;
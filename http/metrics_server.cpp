@@ -0,0 +1,113 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "metrics_server.h"
+#include "http_compressor.h"
+#include "utility/metrics.h"
+#include "utility/helpers.h"
+#include "utility/logger.h"
+
+namespace beam {
+
+namespace {
+
+#define STS "Metrics server: "
+
+static const char* CONTENT_TYPE = "text/plain; version=0.0.4";
+
+} //namespace
+
+MetricsServer::MetricsServer(io::Reactor& reactor, io::Address bindAddress) :
+    _msgCreator(2000)
+{
+    _server = io::TcpServer::create(reactor, bindAddress, BIND_THIS_MEMFN(on_stream_accepted));
+    LOG_INFO() << STS << "listening on " << bindAddress;
+}
+
+void MetricsServer::create_response(HttpMsgCreator& creator, const HttpMessage& request, io::SerializedMsg& out) {
+    std::string text;
+    metrics::Registry::get().Write(text);
+
+    io::SerializedMsg body;
+    body.push_back(io::SharedBuffer(text.data(), text.size()));
+
+    HeaderPair headers[2];
+    size_t numHeaders = 0;
+
+    HttpCompressor::Encoding encoding = HttpCompressor::select(request.get_header("accept-encoding"));
+    if (encoding != HttpCompressor::identity) {
+        io::SerializedMsg compressed;
+        HttpCompressor compressor(encoding);
+        if (compressor.compress(body, compressed, true)) {
+            body.swap(compressed);
+            headers[numHeaders++] = HeaderPair("Content-Encoding", HttpCompressor::name(encoding));
+            headers[numHeaders++] = HeaderPair("Vary", "Accept-Encoding");
+        }
+    }
+
+    size_t bodySize = 0;
+    for (const auto& f : body) { bodySize += f.size; }
+
+    if (!creator.create_response(out, 200, "OK", headers, numHeaders, 1, CONTENT_TYPE, bodySize)) {
+        LOG_ERROR() << STS << "cannot create response";
+        out.clear();
+        return;
+    }
+
+    for (auto& f : body) out.push_back(std::move(f));
+}
+
+void MetricsServer::on_stream_accepted(io::TcpStream::Ptr&& newStream, io::ErrorCode errorCode) {
+    if (errorCode != 0) {
+        LOG_ERROR() << STS << io::error_str(errorCode);
+        return;
+    }
+
+    auto peer = newStream->peer_address();
+    _connections[peer.u64()] = std::make_unique<HttpConnection>(
+        peer.u64(),
+        BaseConnection::inbound,
+        BIND_THIS_MEMFN(on_request),
+        1024,
+        1024,
+        std::move(newStream)
+    );
+}
+
+bool MetricsServer::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
+    auto it = _connections.find(id);
+    if (it == _connections.end()) return false;
+
+    io::SerializedMsg out;
+    bool ok = (msg.what == HttpMsgReader::http_message) && msg.msg;
+
+    if (ok) {
+        if (msg.msg->get_path() == "/metrics") {
+            create_response(_msgCreator, *msg.msg, out);
+        } else {
+            _msgCreator.create_response(out, 404, "Not Found", 0, 0, 1);
+            ok = false;
+        }
+    }
+
+    if (out.empty() || !it->second->write_msg(out)) ok = false;
+
+    if (!ok) {
+        it->second->shutdown();
+        _connections.erase(it);
+    }
+    return ok;
+}
+
+} //namespace
@@ -0,0 +1,43 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "http/http_connection.h"
+#include "http/http_msg_creator.h"
+#include "utility/io/tcpserver.h"
+#include <map>
+
+namespace beam {
+
+/// Serves GET /metrics from metrics::Registry in the Prometheus text format.
+/// The collectors are invoked on the reactor thread
+class MetricsServer {
+public:
+    /// Throws if cannot listen
+    MetricsServer(io::Reactor& reactor, io::Address bindAddress);
+
+    /// Appends the exposition response to out, gzipped if accepted
+    static void create_response(HttpMsgCreator& creator, const HttpMessage& request, io::SerializedMsg& out);
+
+private:
+    void on_stream_accepted(io::TcpStream::Ptr&& newStream, io::ErrorCode errorCode);
+    bool on_request(uint64_t id, const HttpMsgReader::Message& msg);
+
+    HttpMsgCreator _msgCreator;
+    io::TcpServer::Ptr _server;
+    std::map<uint64_t, HttpConnection::Ptr> _connections;
+};
+
+} //namespace
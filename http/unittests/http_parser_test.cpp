@@ -13,8 +13,12 @@
 // limitations under the License.
 
 #include "http/http_msg_reader.h"
+#include "http/http_compressor.h"
 #include "utility/helpers.h"
 #include "utility/logger.h"
+#ifdef BEAM_HTTP_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace beam;
 using namespace std;
@@ -164,6 +168,132 @@ int test_multiple() {
     return REPORT(errors);
 }
 
+int test_pipelined_chunked() {
+    const char* input0 = "GET /zzz HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    const char* input10 = "POST /zzz HTTP/1.1\r\nHost: example.com\r\nContent-Length: 10\r\n\r\n0123456789";
+    const char* inputChunked =
+        "POST /zzz HTTP/1.1\r\nHost: example.com\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "3\r\n012\r\n7;ext=1\r\n3456789\r\n0\r\nTrailer: x\r\n\r\n";
+    std::string stream;
+
+    int expected = 0;
+    for (int i=0; i<999; ++i) {
+        if (i % 3 == 0) stream += input0;
+        else if (i % 3 == 1) stream += inputChunked;
+        else stream += input10;
+        ++expected;
+    }
+
+    int errors = 0;
+    int calls = 0;
+    bool corrupted = false;
+
+    HttpMsgReader reader(
+        HttpMsgReader::server,
+        1,
+        [&errors, &calls, &corrupted](uint64_t, const HttpMsgReader::Message& m) -> bool {
+            if (m.what != HttpMsgReader::http_message) {
+                ++errors;
+                corrupted = true;
+                return false;
+            }
+            if (m.msg->get_path() != "/zzz") ++errors;
+            size_t bodySize=0;
+            const void* body = m.msg->get_body(bodySize);
+            if (calls % 3 == 0) {
+                if (m.msg->get_method() != "GET" || bodySize != 0) ++errors;
+            } else {
+                if (m.msg->get_method() != "POST") ++errors;
+                if (!body || bodySize != 10 || memcmp(body, "0123456789", 10)) ++errors;
+            }
+            ++calls;
+            return true;
+        },
+        100,
+        100
+    );
+
+    FragmentedInput input(stream.c_str(), stream.size());
+    size_t fragmentSize = 1;
+    for (;;) {
+        const void* p = 0;
+        size_t s = 0;
+        if (!input.next_fragment(&p, &s, fragmentSize))
+            break;
+
+        reader.new_data_from_stream(io::EC_OK, p, s);
+        if (corrupted)
+            break;
+        fragmentSize = fragmentSize % 97 + 7;
+    }
+
+    if (calls != expected) ++errors;
+
+    LOG_DEBUG() << __FUNCTION__ << TRACE(calls) << TRACE(corrupted);
+
+    return REPORT(errors);
+}
+
+int test_compressor() {
+    int errors = 0;
+
+#ifdef BEAM_HTTP_ZLIB
+    if (HttpCompressor::select("gzip, deflate, br") != HttpCompressor::gzip) ++errors;
+    if (HttpCompressor::select("deflate;q=0.5, gzip;q=0") != HttpCompressor::deflate) ++errors;
+    if (HttpCompressor::select("*") != HttpCompressor::gzip) ++errors;
+    if (HttpCompressor::select("br") != HttpCompressor::identity) ++errors;
+    if (HttpCompressor::select("") != HttpCompressor::identity) ++errors;
+
+    // parts compressed one by one, the output of each is decodable before the stream is finished
+    std::string expected;
+    std::string decoded;
+    HttpCompressor compressor(HttpCompressor::gzip);
+
+    z_stream zs = z_stream();
+    if (inflateInit2(&zs, 15 + 16) != Z_OK) return REPORT(1);
+
+    for (int i = 0; i < 100; i++) {
+        std::string part = std::string(i ? "," : "[") + "{\"height\":" + std::to_string(i) + ",\"hash\":\"00ff00ff\"}";
+        if (i == 99) part += "]";
+        expected += part;
+
+        io::SerializedMsg in, out;
+        in.push_back(io::SharedBuffer(part.data(), part.size()));
+        if (!compressor.compress(in, out, i == 99)) {
+            ++errors;
+            break;
+        }
+
+        for (const auto& f : out) {
+            zs.next_in = (Bytef*)f.data;
+            zs.avail_in = static_cast<uInt>(f.size);
+            while (zs.avail_in) {
+                char buf[256];
+                zs.next_out = (Bytef*)buf;
+                zs.avail_out = sizeof(buf);
+                int ret = inflate(&zs, Z_NO_FLUSH);
+                if (ret != Z_OK && ret != Z_STREAM_END) {
+                    ++errors;
+                    break;
+                }
+                decoded.append(buf, sizeof(buf) - zs.avail_out);
+                if (ret == Z_STREAM_END) break;
+            }
+        }
+
+        if (decoded != expected) {
+            ++errors;
+            break;
+        }
+    }
+    inflateEnd(&zs);
+#else
+    if (HttpCompressor::select("gzip") != HttpCompressor::identity) ++errors;
+#endif
+
+    return REPORT(errors);
+}
+
 int compare(const HttpUrl& a, const HttpUrl& b) {
     int nErrors=0;
     if (a.dir != b.dir) ++nErrors;
@@ -243,6 +373,8 @@ int main() {
         retCode += test_bodyless_request();
         retCode += test_request_with_body();
         retCode += test_multiple();
+        retCode += test_pipelined_chunked();
+        retCode += test_compressor();
         retCode += test_query_strings();
     } catch (const exception& e) {
         LOG_ERROR() << e.what();
@@ -536,11 +536,37 @@ namespace beam::wallet
 
     /////////////////////////
     // LocalPrivateKeyKeeper2
-    LocalPrivateKeyKeeper2::LocalPrivateKeyKeeper2(const Key::IKdf::Ptr& pKdf)
-        :m_pKdf(pKdf)
+    LocalPrivateKeyKeeper2::LocalPrivateKeyKeeper2(const Key::IKdf::Ptr& pKdf, const std::shared_ptr<Executor>& pOutputsExecutor)
+        :m_pOutputsExecutor(pOutputsExecutor)
+        ,m_pKdf(pKdf)
     {
     }
 
+    LocalPrivateKeyKeeper2::~LocalPrivateKeyKeeper2()
+    {
+        // the executor may outlive us, wait for our batches before anything else is destroyed
+        std::unique_lock<std::mutex> scope(m_MutexDone);
+        while (m_nBatches)
+            m_cvDone.wait(scope);
+    }
+
+    std::shared_ptr<Executor> LocalPrivateKeyKeeper2::get_SharedExecutor()
+    {
+        static std::mutex s_Mutex;
+        static std::weak_ptr<Executor> s_pExecutor;
+
+        std::unique_lock<std::mutex> scope(s_Mutex);
+
+        std::shared_ptr<Executor> pRet = s_pExecutor.lock();
+        if (!pRet)
+        {
+            pRet = std::make_shared<ExecutorMT_Std>();
+            s_pExecutor = pRet;
+        }
+
+        return pRet;
+    }
+
     IPrivateKeyKeeper2::Status::Type LocalPrivateKeyKeeper2::ToImage(Point::Native& res, uint32_t iGen, const Scalar::Native& sk)
     {
         const Generator::Obscured* pGen;
@@ -716,14 +742,16 @@ namespace beam::wallet
         return Status::Success;
     }
 
+    bool LocalPrivateKeyKeeper2::IsOutputSchemeAllowed(Height hScheme)
+    {
+        // disallow weak paramters in trustless mode. Blinding factor can be tampered without user permission
+        return !IsTrustless() || (hScheme >= Rules::get().pForks[1].m_Height);
+    }
+
     IPrivateKeyKeeper2::Status::Type LocalPrivateKeyKeeper2::InvokeSync(Method::CreateOutput& x)
     {
-        if (IsTrustless())
-        {
-            // disallow weak paramters
-            if (x.m_hScheme < Rules::get().pForks[1].m_Height)
-                return Status::Unspecified; // blinding factor can be tampered without user permission
-        }
+        if (!IsOutputSchemeAllowed(x.m_hScheme))
+            return Status::Unspecified;
 
         x.m_pResult.reset(new Output);
 
@@ -733,6 +761,176 @@ namespace beam::wallet
         return Status::Success;
     }
 
+    void LocalPrivateKeyKeeper2::CreateOutputs(Method::CreateOutputs& x, size_t i0, size_t i1)
+    {
+        // may be called from different threads, each on its own range
+        for (size_t i = i0; i < i1; i++)
+        {
+            const CoinID& cid = x.m_vCids[i];
+            Output::Ptr& pOut = x.m_vResults[i];
+
+            pOut.reset(new Output);
+
+            Scalar::Native sk;
+            pOut->Create(x.m_hScheme, sk, *cid.get_ChildKdf(m_pKdf), cid, *m_pKdf);
+        }
+    }
+
+    Executor* LocalPrivateKeyKeeper2::get_OutputsExecutor(size_t nCount)
+    {
+        if ((nCount < 2) || !m_pOutputsExecutor || (m_pOutputsExecutor->get_Threads() < 2))
+            return nullptr;
+
+        return m_pOutputsExecutor.get();
+    }
+
+    struct LocalPrivateKeyKeeper2::OutputsTask
+        :public Executor::TaskAsync
+    {
+        struct Batch
+        {
+            LocalPrivateKeyKeeper2* m_pThis;
+            Method::CreateOutputs* m_pM;
+            std::atomic<uint32_t> m_Pending;
+
+            virtual ~Batch() {}
+            virtual void OnDone() = 0; // called by the thread that completed the last portion
+        };
+
+        std::shared_ptr<Batch> m_pBatch;
+        size_t m_i0;
+        size_t m_i1;
+
+        virtual void Exec(Executor::Context&) override
+        {
+            m_pBatch->m_pThis->CreateOutputs(*m_pBatch->m_pM, m_i0, m_i1);
+
+            if (!--m_pBatch->m_Pending)
+                m_pBatch->OnDone();
+        }
+
+        static void Push(Executor& ex, const std::shared_ptr<Batch>& pBatch)
+        {
+            size_t nCount = pBatch->m_pM->m_vCids.size();
+            uint32_t nTasks = std::min(ex.get_Threads(), static_cast<uint32_t>(nCount));
+            pBatch->m_Pending = nTasks;
+
+            for (uint32_t i = 0; i < nTasks; i++)
+            {
+                std::unique_ptr<OutputsTask> pTask = std::make_unique<OutputsTask>();
+                pTask->m_pBatch = pBatch;
+                pTask->m_i0 = nCount * i / nTasks;
+                pTask->m_i1 = nCount * (i + 1) / nTasks;
+
+                ex.Push(std::move(pTask));
+            }
+        }
+    };
+
+    IPrivateKeyKeeper2::Status::Type LocalPrivateKeyKeeper2::InvokeSync(Method::CreateOutputs& x)
+    {
+        if (!IsOutputSchemeAllowed(x.m_hScheme))
+            return Status::Unspecified;
+
+        size_t nCount = x.m_vCids.size();
+        x.m_vResults.resize(nCount);
+
+        Executor* pEx = get_OutputsExecutor(nCount);
+        if (!pEx)
+        {
+            CreateOutputs(x, 0, nCount);
+            return Status::Success;
+        }
+
+        // the executor is shared, so wait for our batch only, rather than for all its tasks
+        struct MyBatch
+            :public OutputsTask::Batch
+        {
+            std::mutex m_Mutex;
+            std::condition_variable m_cv;
+            bool m_Done = false;
+
+            virtual void OnDone() override
+            {
+                std::unique_lock<std::mutex> scope(m_Mutex);
+                m_Done = true;
+                m_cv.notify_one();
+            }
+        };
+
+        auto pBatch = std::make_shared<MyBatch>();
+        pBatch->m_pThis = this;
+        pBatch->m_pM = &x;
+
+        OutputsTask::Push(*pEx, pBatch);
+
+        std::unique_lock<std::mutex> scope(pBatch->m_Mutex);
+        while (!pBatch->m_Done)
+            pBatch->m_cv.wait(scope);
+
+        return Status::Success;
+    }
+
+    void LocalPrivateKeyKeeper2::InvokeAsync(Method::CreateOutputs& x, const Handler::Ptr& pHandler)
+    {
+        size_t nCount = x.m_vCids.size();
+
+        Executor* pEx = IsOutputSchemeAllowed(x.m_hScheme) ? get_OutputsExecutor(nCount) : nullptr;
+        if (!pEx)
+        {
+            PushOut(InvokeSync(x), pHandler);
+            return;
+        }
+
+        // The reactor thread isn't blocked, the completion is posted back to it
+        EnsureEvtOut();
+        x.m_vResults.resize(nCount);
+
+        struct MyBatch
+            :public OutputsTask::Batch
+        {
+            Task::Ptr m_pDone; // carries the handler
+
+            virtual void OnDone() override
+            {
+                std::unique_lock<std::mutex> scope(m_pThis->m_MutexDone);
+                if (m_pThis->m_queDone.Push(m_pDone))
+                    m_pThis->m_pNewOut->post();
+
+                if (!--m_pThis->m_nBatches)
+                    m_pThis->m_cvDone.notify_all();
+            }
+        };
+
+        auto pBatch = std::make_shared<MyBatch>();
+        pBatch->m_pThis = this;
+        pBatch->m_pM = &x;
+        pBatch->m_pDone.reset(new Task);
+        pBatch->m_pDone->m_pHandler = pHandler; // keeps the method alive
+        pBatch->m_pDone->m_Status = Status::Success;
+
+        {
+            std::unique_lock<std::mutex> scope(m_MutexDone);
+            m_nBatches++;
+        }
+
+        OutputsTask::Push(*pEx, pBatch);
+    }
+
+    void LocalPrivateKeyKeeper2::OnNewOut()
+    {
+        // protect this obj from destruction from the handler invocation
+        TaskList que;
+        m_queOut.swap(que);
+
+        {
+            std::unique_lock<std::mutex> scope(m_MutexDone);
+            que.splice(que.end(), m_queDone);
+        }
+
+        CallNewOut(que);
+    }
+
     void LocalPrivateKeyKeeper2::UpdateOffset(Method::TxCommon& tx, const Scalar::Native& kDiff, const Scalar::Native& kKrn)
     {
         Scalar::Native k = kDiff + kKrn;
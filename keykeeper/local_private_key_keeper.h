@@ -16,6 +16,7 @@
 
 #include "wallet/core/private_key_keeper.h"
 #include "wallet/core/variables_db.h"
+#include "utility/executor.h"
 #include <utility>
 
 namespace beam::wallet
@@ -187,16 +188,38 @@ namespace beam::wallet
 
         struct Aggregation;
 
+        // outputs of a batch are created in parallel
+        struct OutputsTask;
+        std::shared_ptr<Executor> m_pOutputsExecutor;
+        std::mutex m_MutexDone;
+        std::condition_variable m_cvDone;
+        TaskList m_queDone; // completed batches, filled by the executor threads
+        uint32_t m_nBatches = 0; // async batches in progress
+
+        bool IsOutputSchemeAllowed(Height);
+        void CreateOutputs(Method::CreateOutputs&, size_t i0, size_t i1);
+        Executor* get_OutputsExecutor(size_t nCount); // null if not worth it
+
+        virtual void OnNewOut() override;
+
     public:
 
-        LocalPrivateKeyKeeper2(const ECC::Key::IKdf::Ptr&);
+        // The executor is shared by default with all the local key keepers of the process
+        LocalPrivateKeyKeeper2(const ECC::Key::IKdf::Ptr&, const std::shared_ptr<Executor>& pOutputsExecutor = get_SharedExecutor());
+        ~LocalPrivateKeyKeeper2();
+
+        static std::shared_ptr<Executor> get_SharedExecutor(); // created on demand, stopped with the last user
 
 #define THE_MACRO(method) \
         virtual Status::Type InvokeSync(Method::method& m) override;
 
         KEY_KEEPER_METHODS(THE_MACRO)
+        THE_MACRO(CreateOutputs)
 #undef THE_MACRO
 
+        using PrivateKeyKeeper_AsyncNotify::InvokeAsync;
+        virtual void InvokeAsync(Method::CreateOutputs&, const Handler::Ptr&) override;
+
     protected:
 
         ECC::Key::IKdf::Ptr m_pKdf;
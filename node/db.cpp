@@ -15,9 +15,27 @@
 #include "db.h"
 #include "../core/peer_manager.h"
 #include "../utility/logger.h"
+#include "../utility/metrics.h"
 
 namespace beam {
 
+namespace
+{
+	metrics::Histogram& get_QueryTime(NodeDB::Query::Enum e)
+	{
+		static std::atomic<metrics::Histogram*> s_ppHist[NodeDB::Query::count];
+		assert(e < NodeDB::Query::count);
+
+		metrics::Histogram* pHist = s_ppHist[e].load(std::memory_order_acquire);
+		if (!pHist)
+		{
+			// races are ok, the registry returns the same one
+			pHist = &metrics::Registry::get().get_Histogram("beam_db_query_seconds", "NodeDB statement step time", metrics::Writer::Label("query", NodeDB::Query::get_Name(e)));
+			s_ppHist[e].store(pHist, std::memory_order_release);
+		}
+		return *pHist;
+	}
+}
 
 // Literal constants
 #define TblParams				"Params"
@@ -78,6 +96,7 @@ namespace beam {
 #define TblDummy				"Dummies"
 #define TblDummy_ID				"ID"
 #define TblDummy_SpendHeight	"SpendHeight"
+#define TblDummy_Output			"Output"
 
 #define TblTxo					"Txo"
 #define TblTxo_ID				"ID"
@@ -101,6 +120,7 @@ namespace beam {
 
 NodeDB::NodeDB()
 	:m_pDb(NULL)
+	,m_ReadOnly(false)
 {
 	ZeroObject(m_pPrep);
 }
@@ -110,6 +130,18 @@ NodeDB::~NodeDB()
 	Close();
 }
 
+const char* NodeDB::Query::get_Name(Enum e)
+{
+	switch (e)
+	{
+#define THE_MACRO(name) case name: return #name;
+		NodeDB_QueriesAll(THE_MACRO)
+#undef THE_MACRO
+	default:
+		return "?";
+	}
+}
+
 void NodeDB::TestRet(int ret)
 {
 	if (SQLITE_OK != ret)
@@ -147,19 +179,44 @@ void NodeDB::Statement::Close()
 
 void NodeDB::Close()
 {
+	if (m_MetricsCollector)
+	{
+		metrics::Registry::get().RemoveCollector(m_MetricsCollector);
+		m_MetricsCollector = 0;
+	}
+
+	if (m_pProfiler)
+	{
+		m_pProfiler->Dump();
+		m_pProfiler.reset();
+	}
+
 	if (m_pDb)
 	{
+		if (!m_ReadOnly)
+		{
+			try {
+				SaveFilter(m_KrnFilter, ParamID::KrnFilter);
+				SaveFilter(m_UniqueFilter, ParamID::UniqueFilter);
+			}
+			catch (...) {
+				// ignore, they'll be rebuilt
+			}
+		}
+
 		for (size_t i = 0; i < _countof(m_pPrep); i++)
 			m_pPrep[i].Close();
 
         BEAM_VERIFY(SQLITE_OK == sqlite3_close(m_pDb));
 		m_pDb = NULL;
+		m_ReadOnly = false;
 	}
 }
 
 NodeDB::Recordset::Recordset()
 	:m_pStmt(nullptr)
 	,m_pDB(nullptr)
+	,m_eQuery(Query::count)
 {
 }
 
@@ -172,6 +229,7 @@ NodeDB::Recordset::Recordset(NodeDB& db, Query::Enum val, const char* sql)
 void NodeDB::Recordset::InitInternal(NodeDB& db, Query::Enum val, const char* sql)
 {
 	m_pDB = &db;
+	m_eQuery = val;
 	m_pStmt = db.get_Statement(val, sql);
 }
 
@@ -197,7 +255,7 @@ void NodeDB::Recordset::Reset(NodeDB& db, Query::Enum val, const char* sql)
 
 bool NodeDB::Recordset::Step()
 {
-	return m_pDB->ExecStep(m_pStmt);
+	return m_pDB->TestStep(m_pDB->ExecStepRaw(m_pStmt, m_eQuery));
 }
 
 void NodeDB::Recordset::StepStrict()
@@ -208,7 +266,8 @@ void NodeDB::Recordset::StepStrict()
 
 bool NodeDB::Recordset::StepModifySafe()
 {
-	int nVal = m_pDB->ExecStepRaw(m_pStmt);
+	int nVal = m_pDB->ExecStepRaw(m_pStmt, m_eQuery);
+
 	switch (nVal)
 	{
 
@@ -318,13 +377,16 @@ const void* NodeDB::Recordset::get_BlobStrict(int col, uint32_t n)
 	return x.p;
 }
 
-void NodeDB::Open(const char* szPath)
+void NodeDB::Open(const char* szPath, bool bShared)
 {
 	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_CREATE, NULL));
 	// Attempt to fix the "busy" error when PC goes to sleep and then awakes. Try the busy handler with non-zero timeout (maybe a single retry would be enough)
 	sqlite3_busy_timeout(m_pDb, 5000);
 
-	ExecTextOut("PRAGMA locking_mode = EXCLUSIVE");
+	if (bShared)
+		ExecTextOut("PRAGMA journal_mode = WAL"); // readers see the last committed state, and don't block the writer
+	else
+		ExecTextOut("PRAGMA locking_mode = EXCLUSIVE");
 	ExecTextOut("PRAGMA journal_size_limit=1048576"); // limit journal file, otherwise it may remain huge even after tx commit, until the app is closed
 
 	bool bCreate;
@@ -334,7 +396,7 @@ void NodeDB::Open(const char* szPath)
 		bCreate = !rs.Step();
 	}
 
-	const uint64_t nVersionTop = 21;
+	const uint64_t nVersionTop = 22;
 
 	Transaction t(*this);
 
@@ -366,6 +428,10 @@ void NodeDB::Open(const char* szPath)
 
 			LOG_INFO() << "DB migrate from" << 20;
 			MigrateFrom20();
+			// no break;
+
+		case 21: // before precomputed dummy outputs
+			ExecQuick("ALTER TABLE " TblDummy " ADD COLUMN "  "[" TblDummy_Output	"] BLOB");
 
 			ParamIntSet(ParamID::DbVer, nVersionTop);
 			// no break;
@@ -382,9 +448,24 @@ void NodeDB::Open(const char* szPath)
 		}
 	}
 
+	LoadFilter(m_KrnFilter, ParamID::KrnFilter);
+	LoadFilter(m_UniqueFilter, ParamID::UniqueFilter);
+
 	t.Commit();
 }
 
+void NodeDB::OpenReadOnly(const char* szPath)
+{
+	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL));
+	sqlite3_busy_timeout(m_pDb, 5000);
+
+	m_ReadOnly = true;
+
+	// The scheme is maintained by the writer. Filters are not loaded, lookups go directly to the DB
+	m_KrnFilter.Reset(0);
+	m_UniqueFilter.Reset(0);
+}
+
 void NodeDB::CheckIntegrity()
 {
 	std::string s = ExecTextOut("PRAGMA integrity_check");
@@ -477,7 +558,8 @@ void NodeDB::Create()
 
 	ExecQuick("CREATE TABLE [" TblDummy "] ("
 		"[" TblDummy_ID				"] BLOB NOT NULL PRIMARY KEY,"
-		"[" TblDummy_SpendHeight	"] INTEGER NOT NULL)");
+		"[" TblDummy_SpendHeight	"] INTEGER NOT NULL,"
+		"[" TblDummy_Output			"] BLOB)");
 
 	ExecQuick("CREATE INDEX [Idx" TblDummy "H] ON [" TblDummy "] ([" TblDummy_SpendHeight "])");
 
@@ -554,9 +636,31 @@ int NodeDB::ExecStepRaw(sqlite3_stmt* pStmt)
 	return nVal;
 }
 
-bool NodeDB::ExecStep(sqlite3_stmt* pStmt)
+int NodeDB::ExecStepRaw(sqlite3_stmt* pStmt, Query::Enum eQuery)
 {
+	bool bMetrics = metrics::IsEnabled();
+	if (!bMetrics && !m_pProfiler)
+		return ExecStepRaw(pStmt);
+
+	auto t0 = std::chrono::steady_clock::now();
 	int nVal = ExecStepRaw(pStmt);
+	uint64_t dt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+
+	if (bMetrics)
+		get_QueryTime(eQuery).Observe(dt);
+	if (m_pProfiler)
+		m_pProfiler->OnStep(eQuery, dt, SQLITE_ROW == nVal);
+
+	return nVal;
+}
+
+bool NodeDB::ExecStep(sqlite3_stmt* pStmt)
+{
+	return TestStep(ExecStepRaw(pStmt));
+}
+
+bool NodeDB::TestStep(int nVal)
+{
 	switch (nVal)
 	{
 
@@ -582,7 +686,7 @@ bool NodeDB::ExecStep(sqlite3_stmt* pStmt)
 
 bool NodeDB::ExecStep(Query::Enum val, const char* sql)
 {
-	return ExecStep(get_Statement(val, sql));
+	return TestStep(ExecStepRaw(get_Statement(val, sql), val));
 
 }
 
@@ -617,6 +721,122 @@ uint64_t NodeDB::get_LastInsertRowID() const
 	return sqlite3_last_insert_rowid(m_pDb);
 }
 
+void NodeDB::EnableProfiler(uint64_t nSlowQuery_us)
+{
+	if (!m_pProfiler)
+	{
+		m_pProfiler = std::make_unique<Profiler>();
+		m_MetricsCollector = metrics::Registry::get().AddCollector([this](metrics::Writer& w) {
+			if (m_pProfiler)
+				m_pProfiler->Write(w);
+		});
+	}
+
+	m_pProfiler->m_SlowQuery_us = nSlowQuery_us;
+}
+
+uint32_t NodeDB::Profiler::get_Bucket(uint64_t x)
+{
+	if (x < 4)
+		return static_cast<uint32_t>(x);
+
+	uint32_t nOrder = 0; // floor(log2(x))
+	for (uint64_t y = x; y >>= 1; )
+		nOrder++;
+
+	uint32_t iSub = static_cast<uint32_t>(x >> (nOrder - 2)) & 3;
+	return std::min(4 * (nOrder - 1) + iSub, s_Buckets - 1);
+}
+
+uint64_t NodeDB::Profiler::get_BucketMax(uint32_t i)
+{
+	if (i < 4)
+		return i;
+
+	uint32_t nShift = i / 4 - 1;
+	uint64_t x0 = uint64_t(4 + i % 4) << nShift;
+	return x0 + (uint64_t(1) << nShift) - 1;
+}
+
+void NodeDB::Profiler::Stats::Add(uint64_t dt_us, bool bRow)
+{
+	m_Steps++;
+	if (bRow)
+		m_Rows++;
+	m_Total_us += dt_us;
+	m_Max_us = std::max(m_Max_us, dt_us);
+	m_pHist[get_Bucket(dt_us)]++;
+}
+
+uint64_t NodeDB::Profiler::Stats::get_Quantile(double q) const
+{
+	uint64_t nTarget = static_cast<uint64_t>(q * m_Steps + 0.5);
+	if (!nTarget)
+		nTarget = 1;
+
+	uint64_t n = 0;
+	for (uint32_t i = 0; i < s_Buckets; i++)
+	{
+		n += m_pHist[i];
+		if (n >= nTarget)
+			return std::min(get_BucketMax(i), m_Max_us);
+	}
+
+	return m_Max_us;
+}
+
+void NodeDB::Profiler::OnStep(Query::Enum e, uint64_t dt_us, bool bRow)
+{
+	assert(e < Query::count);
+	m_pStats[e].Add(dt_us, bRow);
+
+	if (m_SlowQuery_us && (dt_us >= m_SlowQuery_us))
+		LOG_WARNING() << "Slow query " << Query::get_Name(e) << ": " << dt_us << " us";
+}
+
+void NodeDB::Profiler::Dump() const
+{
+	std::vector<uint32_t> v;
+	for (uint32_t i = 0; i < Query::count; i++)
+		if (m_pStats[i].m_Steps)
+			v.push_back(i);
+
+	if (v.empty())
+		return;
+
+	std::sort(v.begin(), v.end(), [this](uint32_t a, uint32_t b) { return m_pStats[a].m_Total_us > m_pStats[b].m_Total_us; });
+
+	LOG_INFO() << "DB profile, by total time. Query: steps, rows, total ms, p50/p99/max us";
+	for (uint32_t i : v)
+	{
+		const Stats& s = m_pStats[i];
+		LOG_INFO() << "    " << Query::get_Name(static_cast<Query::Enum>(i)) << ": " << s.m_Steps << ", " << s.m_Rows << ", " << s.m_Total_us / 1000
+			<< ", " << s.get_Quantile(0.5) << "/" << s.get_Quantile(0.99) << "/" << s.m_Max_us;
+	}
+}
+
+void NodeDB::Profiler::Write(metrics::Writer& w) const
+{
+	w.Header("beam_db_profile_seconds", "NodeDB statement step time", "summary");
+	for (uint32_t i = 0; i < Query::count; i++)
+	{
+		const Stats& s = m_pStats[i];
+		if (!s.m_Steps)
+			continue;
+
+		std::string sLabel = metrics::Writer::Label("query", Query::get_Name(static_cast<Query::Enum>(i)));
+		w.Value("beam_db_profile_seconds", sLabel + ",quantile=\"0.5\"", s.get_Quantile(0.5) * 1e-6);
+		w.Value("beam_db_profile_seconds", sLabel + ",quantile=\"0.99\"", s.get_Quantile(0.99) * 1e-6);
+		w.Value("beam_db_profile_seconds_sum", sLabel, s.m_Total_us * 1e-6);
+		w.Value("beam_db_profile_seconds_count", sLabel, s.m_Steps);
+	}
+
+	w.Header("beam_db_profile_rows_total", "Rows returned by NodeDB statements", "counter");
+	for (uint32_t i = 0; i < Query::count; i++)
+		if (m_pStats[i].m_Steps)
+			w.Value("beam_db_profile_rows_total", metrics::Writer::Label("query", Query::get_Name(static_cast<Query::Enum>(i))), m_pStats[i].m_Rows);
+}
+
 void NodeDB::TestChanged1Row()
 {
 	if (1 != get_RowsChanged())
@@ -723,6 +943,14 @@ void NodeDB::Transaction::Rollback()
 	if (m_pDB)
 	{
 		m_pDB->ExecStep(Query::Rollback, "ROLLBACK");
+
+		if (!m_pDB->m_ReadOnly)
+		{
+			// filters may miss the restored keys. On a read-only connection they're disabled, and nothing is restored
+			m_pDB->m_KrnFilter.m_Valid = false;
+			m_pDB->m_UniqueFilter.m_Valid = false;
+		}
+
 		m_pDB = nullptr;
 	}
 }
@@ -1997,7 +2225,7 @@ void NodeDB::InsertDummy(Height h, const Key::ID& kid)
 
 Height NodeDB::GetLowestDummy(Key::ID& kid)
 {
-	Recordset rs(*this, Query::DummyFindLowest, "SELECT " TblDummy_ID "," TblDummy_SpendHeight " FROM " TblDummy " ORDER BY " TblDummy_SpendHeight " ASC LIMIT 1");
+	Recordset rs(*this, Query::DummyFindLowest, "SELECT " TblDummy_ID "," TblDummy_SpendHeight " FROM " TblDummy " WHERE " TblDummy_Output " IS NULL ORDER BY " TblDummy_SpendHeight " ASC LIMIT 1");
 	if (!rs.Step())
 		return MaxHeight;
 
@@ -2040,6 +2268,331 @@ void NodeDB::SetDummyHeight(const Key::ID& kid, Height h)
 	TestChanged1Row();
 }
 
+void NodeDB::InsertDummyOutput(Height hScheme, const Key::ID& kid, const Blob& output)
+{
+	Recordset rs(*this, Query::DummyOutputIns, "INSERT INTO " TblDummy "(" TblDummy_ID "," TblDummy_SpendHeight "," TblDummy_Output ") VALUES(?,?,?)");
+	Key::ID::Packed p;
+	rs.put(0, kid, p);
+	rs.put(1, hScheme);
+	rs.put(2, output);
+	rs.Step();
+	TestChanged1Row();
+}
+
+Height NodeDB::GetDummyOutput(Key::ID& kid, ByteBuffer& output)
+{
+	Recordset rs(*this, Query::DummyOutputFind, "SELECT " TblDummy_ID "," TblDummy_SpendHeight "," TblDummy_Output " FROM " TblDummy " WHERE " TblDummy_Output " IS NOT NULL LIMIT 1");
+	if (!rs.Step())
+		return MaxHeight;
+
+	Height hScheme;
+	rs.get(0, kid);
+	rs.get(1, hScheme);
+	rs.get(2, output);
+
+	return hScheme;
+}
+
+void NodeDB::SetDummyOutputUsed(const Key::ID& kid, Height h)
+{
+	Recordset rs(*this, Query::DummyOutputUsed, "UPDATE " TblDummy " SET " TblDummy_SpendHeight "=?," TblDummy_Output "=NULL WHERE " TblDummy_ID "=?");
+	rs.put(0, h);
+	Key::ID::Packed p;
+	rs.put(1, kid, p);
+	rs.Step();
+	TestChanged1Row();
+}
+
+uint64_t NodeDB::get_DummyOutputsCount()
+{
+	Recordset rs(*this, Query::DummyOutputCount, "SELECT COUNT(*) FROM " TblDummy " WHERE " TblDummy_Output " IS NOT NULL");
+	rs.StepStrict();
+
+	uint64_t res;
+	rs.get(0, res);
+	return res;
+}
+
+/////////////////////////////
+// KeyFilter
+double NodeDB::KeyFilter::Stats::get_FpRate() const
+{
+	assert(m_Positives <= m_Lookups);
+	uint64_t nNegative = m_Lookups - m_Positives + m_FalsePositives;
+	return nNegative ? (static_cast<double>(m_FalsePositives) / static_cast<double>(nNegative)) : 0.;
+}
+
+void NodeDB::KeyFilter::Reset(uint64_t nKeys)
+{
+	m_Count = 0;
+	m_vSlots.clear();
+
+	if (nKeys)
+	{
+		// keep the load at most 50%, leave room for the growth
+		uint64_t nBuckets = 1024;
+		while (nBuckets * s_BucketSize < nKeys * 2)
+			nBuckets <<= 1;
+
+		m_vSlots.resize(nBuckets * s_BucketSize, 0);
+	}
+
+	m_Valid = true;
+}
+
+void NodeDB::KeyFilter::get_Pos(const Blob& key, uint64_t& iBucket, uint16_t& fp) const
+{
+	// FNV-1a, followed by the splitmix64 finalizer
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (uint32_t i = 0; i < key.n; i++)
+		h = (h ^ reinterpret_cast<const uint8_t*>(key.p)[i]) * 0x100000001b3ULL;
+
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+
+	iBucket = h & (get_Buckets() - 1);
+	fp = static_cast<uint16_t>(h >> 48);
+	if (!fp)
+		fp = 1;
+}
+
+uint64_t NodeDB::KeyFilter::get_AltBucket(uint64_t iBucket, uint16_t fp) const
+{
+	// symmetric, the alternative of the alternative is the original
+	uint64_t h = fp * 0x5bd1e995ULL;
+	return (iBucket ^ h) & (get_Buckets() - 1);
+}
+
+bool NodeDB::KeyFilter::InsertAt(uint64_t iBucket, uint16_t fp)
+{
+	uint16_t* p = &m_vSlots[iBucket * s_BucketSize];
+	for (uint32_t i = 0; i < s_BucketSize; i++)
+		if (!p[i])
+		{
+			p[i] = fp;
+			return true;
+		}
+
+	return false;
+}
+
+bool NodeDB::KeyFilter::DeleteAt(uint64_t iBucket, uint16_t fp)
+{
+	uint16_t* p = &m_vSlots[iBucket * s_BucketSize];
+	for (uint32_t i = 0; i < s_BucketSize; i++)
+		if (p[i] == fp)
+		{
+			p[i] = 0;
+			return true;
+		}
+
+	return false;
+}
+
+void NodeDB::KeyFilter::Insert(const Blob& key)
+{
+	if (!m_Valid || m_vSlots.empty())
+		return;
+
+	if ((m_Count + 1) * 10 > m_vSlots.size() * 9)
+	{
+		m_Valid = false; // overloaded, should be rebuilt with more room
+		return;
+	}
+
+	uint64_t iBucket;
+	uint16_t fp;
+	get_Pos(key, iBucket, fp);
+
+	m_Count++;
+
+	if (InsertAt(iBucket, fp))
+		return;
+
+	iBucket = get_AltBucket(iBucket, fp);
+
+	for (uint32_t nKicks = 0; nKicks < s_MaxKicks; nKicks++)
+	{
+		if (InsertAt(iBucket, fp))
+			return;
+
+		// evict a victim, move it to its alternative bucket
+		std::swap(fp, m_vSlots[iBucket * s_BucketSize + (nKicks % s_BucketSize)]);
+		iBucket = get_AltBucket(iBucket, fp);
+	}
+
+	m_Valid = false; // the last victim is lost
+}
+
+void NodeDB::KeyFilter::Delete(const Blob& key)
+{
+	if (!m_Valid || m_vSlots.empty())
+		return;
+
+	uint64_t iBucket;
+	uint16_t fp;
+	get_Pos(key, iBucket, fp);
+
+	if (DeleteAt(iBucket, fp) || DeleteAt(get_AltBucket(iBucket, fp), fp))
+		m_Count--;
+	else
+		m_Valid = false; // should not happen
+}
+
+bool NodeDB::KeyFilter::MayContain(const Blob& key) const
+{
+	if (m_vSlots.empty())
+		return true;
+
+	uint64_t iBucket;
+	uint16_t fp;
+	get_Pos(key, iBucket, fp);
+
+	for (uint32_t iPass = 0; iPass < 2; iPass++)
+	{
+		const uint16_t* p = &m_vSlots[iBucket * s_BucketSize];
+		for (uint32_t i = 0; i < s_BucketSize; i++)
+			if (p[i] == fp)
+				return true;
+
+		iBucket = get_AltBucket(iBucket, fp);
+	}
+
+	return false;
+}
+
+void NodeDB::KeyFilter::Export(ByteBuffer& buf) const
+{
+	// native byte order, the snapshot is a local cache
+	uint64_t pHdr[] = { m_Count, m_vSlots.size() };
+
+	size_t nSize = sizeof(uint16_t) * m_vSlots.size();
+	buf.resize(sizeof(pHdr) + nSize);
+
+	memcpy(&buf.front(), pHdr, sizeof(pHdr));
+	if (nSize)
+		memcpy(&buf.front() + sizeof(pHdr), &m_vSlots.front(), nSize);
+}
+
+bool NodeDB::KeyFilter::Import(const Blob& blob)
+{
+	uint64_t pHdr[2];
+	if (blob.n < sizeof(pHdr))
+		return false;
+
+	memcpy(pHdr, blob.p, sizeof(pHdr));
+
+	uint64_t nSlots = pHdr[1];
+	if ((blob.n - sizeof(pHdr)) != sizeof(uint16_t) * nSlots)
+		return false;
+
+	uint64_t nBuckets = nSlots / s_BucketSize;
+	if ((nBuckets * s_BucketSize != nSlots) || (nBuckets & (nBuckets - 1)))
+		return false;
+
+	m_Count = pHdr[0];
+	m_vSlots.resize(nSlots);
+	if (nSlots)
+		memcpy(&m_vSlots.front(), reinterpret_cast<const uint8_t*>(blob.p) + sizeof(pHdr), blob.n - sizeof(pHdr));
+
+	m_Valid = true;
+	return true;
+}
+
+bool NodeDB::TestFilter(KeyFilter& f, const Blob& key, bool bKrn)
+{
+	if (!f.m_Valid)
+		RebuildFilter(f, bKrn);
+
+	f.m_Stats.m_Lookups++;
+	if (!f.MayContain(key))
+		return false;
+
+	f.m_Stats.m_Positives++;
+	return true;
+}
+
+void NodeDB::RebuildFilter(KeyFilter& f, bool bKrn)
+{
+	Recordset rsCount, rsEnum;
+	if (bKrn)
+	{
+		rsCount.Reset(*this, Query::KernelCount, "SELECT COUNT(*) FROM " TblKernels);
+		rsEnum.Reset(*this, Query::KernelEnumKeys, "SELECT " TblKernels_Key " FROM " TblKernels);
+	}
+	else
+	{
+		rsCount.Reset(*this, Query::UniqueCount, "SELECT COUNT(*) FROM " TblUnique);
+		rsEnum.Reset(*this, Query::UniqueEnumKeys, "SELECT " TblUnique_Key " FROM " TblUnique);
+	}
+
+	rsCount.StepStrict();
+
+	uint64_t nKeys;
+	rsCount.get(0, nKeys);
+
+	f.Reset(nKeys + 1);
+
+	while (rsEnum.Step())
+	{
+		Blob key;
+		rsEnum.get(0, key);
+		f.Insert(key);
+	}
+
+	if (!f.m_Valid)
+	{
+		// pathological (too many duplicates?). Just disable it
+		LOG_WARNING() << "Key filter rebuild failed";
+		f.Reset(0);
+	}
+}
+
+void NodeDB::get_FilterStamp(uint64_t* pStamp)
+{
+	pStamp[0] = ParamIntGetDef(ParamID::CursorRow);
+	pStamp[1] = ParamIntGetDef(ParamID::CursorHeight);
+}
+
+void NodeDB::LoadFilter(KeyFilter& f, uint32_t iParam)
+{
+	ByteBuffer buf;
+	if (!ParamGet(iParam, nullptr, nullptr, &buf))
+		return;
+
+	ParamSet(iParam, nullptr, nullptr); // would be stale after any modification
+
+	uint64_t pStamp[2], pStampActual[2];
+	if (buf.size() < sizeof(pStamp))
+		return;
+
+	memcpy(pStamp, &buf.front(), sizeof(pStamp));
+	get_FilterStamp(pStampActual);
+
+	if (memcmp(pStamp, pStampActual, sizeof(pStamp)))
+		return;
+
+	if (!f.Import(Blob(&buf.front() + sizeof(pStamp), static_cast<uint32_t>(buf.size() - sizeof(pStamp)))))
+		f.m_Valid = false;
+}
+
+void NodeDB::SaveFilter(const KeyFilter& f, uint32_t iParam)
+{
+	if (!f.m_Valid)
+		return;
+
+	uint64_t pStamp[2];
+	get_FilterStamp(pStamp);
+
+	ByteBuffer buf;
+	f.Export(buf);
+	buf.insert(buf.begin(), reinterpret_cast<const uint8_t*>(pStamp), reinterpret_cast<const uint8_t*>(pStamp) + sizeof(pStamp));
+
+	Blob blob(buf);
+	ParamSet(iParam, nullptr, &blob);
+}
+
 void NodeDB::InsertKernel(const Blob& key, Height h)
 {
 	assert(h >= Rules::HeightGenesis);
@@ -2049,6 +2602,8 @@ void NodeDB::InsertKernel(const Blob& key, Height h)
 	rs.put(1, h);
 	rs.Step();
 	TestChanged1Row();
+
+	m_KrnFilter.Insert(key);
 }
 
 void NodeDB::DeleteKernel(const Blob& key, Height h)
@@ -2063,18 +2618,27 @@ void NodeDB::DeleteKernel(const Blob& key, Height h)
 	uint32_t nRows = get_RowsChanged();
 	if (!nRows)
 		ThrowError("no krn");
-	else
-		// in the *very* unlikely case of kernel duplicate at the same height (!!!) - just re-insert it
-		while (--nRows)
-			InsertKernel(key, h);
+
+	for (uint32_t i = 0; i < nRows; i++)
+		m_KrnFilter.Delete(key);
+
+	// in the *very* unlikely case of kernel duplicate at the same height (!!!) - just re-insert it
+	while (--nRows)
+		InsertKernel(key, h);
 }
 
 Height NodeDB::FindKernel(const Blob& key)
 {
+	if (!TestFilter(m_KrnFilter, key, true))
+		return Rules::HeightGenesis - 1;
+
 	Recordset rs(*this, Query::KernelFind, "SELECT " TblKernels_Height " FROM " TblKernels " WHERE " TblKernels_Key "=? ORDER BY " TblKernels_Height " DESC LIMIT 1");
 	rs.put(0, key);
 	if (!rs.Step())
+	{
+		m_KrnFilter.m_Stats.m_FalsePositives++;
 		return Rules::HeightGenesis - 1;
+	}
 
 	Height h;
 	rs.get(0, h);
@@ -2396,14 +2960,25 @@ bool NodeDB::UniqueInsertSafe(const Blob& key, const Blob* pVal)
 	if (pVal)
 		rs.put(1, *pVal);
 
-	return rs.StepModifySafe();
+	if (!rs.StepModifySafe())
+		return false;
+
+	m_UniqueFilter.Insert(key);
+	return true;
 }
 
 bool NodeDB::UniqueFind(const Blob& key, Recordset& rs)
 {
+	if (!TestFilter(m_UniqueFilter, key, false))
+		return false;
+
 	rs.Reset(*this, Query::UniqueFind, "SELECT " TblUnique_Value " FROM " TblUnique " WHERE " TblUnique_Key "=?");
 	rs.put(0, key);
-	return rs.Step();
+	if (rs.Step())
+		return true;
+
+	m_UniqueFilter.m_Stats.m_FalsePositives++;
+	return false;
 }
 
 void NodeDB::UniqueDeleteStrict(const Blob& key)
@@ -2413,6 +2988,8 @@ void NodeDB::UniqueDeleteStrict(const Blob& key)
 
 	rs.Step();
 	TestChanged1Row();
+
+	m_UniqueFilter.Delete(key);
 }
 
 const Asset::ID NodeDB::s_AssetEmpty0 = Asset::s_MaxCount;
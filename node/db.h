@@ -20,6 +20,8 @@
 
 namespace beam {
 
+namespace metrics { struct Writer; }
+
 class NodeDBUpgradeException : public std::runtime_error
 {
 public:
@@ -59,123 +61,137 @@ public:
 			ShieldedInputs,
 			AssetsCount, // Including unused. The last element is guaranteed to be used.
 			AssetsCountUsed, // num of 'live' assets
+			KrnFilter, // snapshot of the kernels filter, valid for the cursor it was saved with. Erased once loaded
+			UniqueFilter, // same for the unique storage
 		};
 	};
 
+#define NodeDB_QueriesAll(macro) \
+	macro(Begin) \
+	macro(Commit) \
+	macro(Rollback) \
+	macro(Scheme) \
+	macro(AutoincrementID) \
+	macro(ParamGet) \
+	macro(ParamIns) \
+	macro(ParamUpd) \
+	macro(StateIns) \
+	macro(StateDel) \
+	macro(StateGet) \
+	macro(StateGetHash) \
+	macro(StateGetHeightAndPrev) \
+	macro(StateFind) \
+	macro(StateFind2) \
+	macro(StateFindWithFlag) \
+	macro(StateFindWorkGreater) \
+	macro(StateUpdPrevRow) \
+	macro(StateGetNextFCount) \
+	macro(StateSetNextCount) \
+	macro(StateSetNextCountF) \
+	macro(StateGetHeightAndAux) \
+	macro(StateGetNextFunctional) \
+	macro(StateSetFlags) \
+	macro(StateGetFlags0) \
+	macro(StateGetFlags1) \
+	macro(StateGetChainWork) \
+	macro(StateGetNextCount) \
+	macro(StateSetPeer) \
+	macro(StateGetPeer) \
+	macro(StateGetExtra) \
+	macro(StateSetInputs) \
+	macro(StateGetInputs) \
+	macro(StateSetTxosAndExtra) \
+	macro(StateGetTxos) \
+	macro(StateFindByTxos) \
+	macro(TipAdd) \
+	macro(TipDel) \
+	macro(TipReachableAdd) \
+	macro(TipReachableDel) \
+	macro(EnumTips) \
+	macro(EnumFunctionalTips) \
+	macro(EnumAtHeight) \
+	macro(EnumAncestors) \
+	macro(StateGetPrev) \
+	macro(Unactivate) \
+	macro(Activate) \
+	macro(StateGetBlock) \
+	macro(StateSetBlock) \
+	macro(StateDelBlockPP) \
+	macro(StateDelBlockPPR) \
+	macro(StateDelBlockAll) \
+	macro(EventIns) \
+	macro(EventDel) \
+	macro(EventEnum) \
+	macro(EventFind) \
+	macro(PeerAdd) \
+	macro(PeerDel) \
+	macro(PeerEnum) \
+	macro(BbsEnumCSeq) \
+	macro(BbsHistogram) \
+	macro(BbsEnumAllSeq) \
+	macro(BbsEnumAll) \
+	macro(BbsFindRaw) \
+	macro(BbsFind) \
+	macro(BbsFindCursor) \
+	macro(BbsDel) \
+	macro(BbsIns) \
+	macro(BbsMaxTime) \
+	macro(BbsTotals) \
+	macro(DummyIns) \
+	macro(DummyFindLowest) \
+	macro(DummyFind) \
+	macro(DummyUpdHeight) \
+	macro(DummyDel) \
+	macro(DummyOutputIns) \
+	macro(DummyOutputFind) \
+	macro(DummyOutputUsed) \
+	macro(DummyOutputCount) \
+	macro(KernelIns) \
+	macro(KernelFind) \
+	macro(KernelDel) \
+	macro(KernelCount) \
+	macro(KernelEnumKeys) \
+	macro(TxoAdd) \
+	macro(TxoDel) \
+	macro(TxoDelFrom) \
+	macro(TxoSetSpent) \
+	macro(TxoEnum) \
+	macro(TxoEnumBySpentMigrate) \
+	macro(TxoSetValue) \
+	macro(TxoGetValue) \
+	macro(BlockFind) \
+	macro(FindHeightBelow) \
+	macro(StreamIns) \
+	macro(StreamDel) \
+	macro(EnumSystemStatesBkwd) \
+	macro(UniqueIns) \
+	macro(UniqueFind) \
+	macro(UniqueDel) \
+	macro(UniqueCount) \
+	macro(UniqueEnumKeys) \
+	macro(AssetFindOwner) \
+	macro(AssetFindMin) \
+	macro(AssetAdd) \
+	macro(AssetDel) \
+	macro(AssetGet) \
+	macro(AssetSetVal) \
+	macro(Dbg0) \
+	macro(Dbg1) \
+	macro(Dbg2) \
+	macro(Dbg3) \
+	macro(Dbg4)
+
 	struct Query
 	{
 		enum Enum
 		{
-			Begin,
-			Commit,
-			Rollback,
-			Scheme,
-			AutoincrementID,
-			ParamGet,
-			ParamIns,
-			ParamUpd,
-			StateIns,
-			StateDel,
-			StateGet,
-			StateGetHash,
-			StateGetHeightAndPrev,
-			StateFind,
-			StateFind2,
-			StateFindWithFlag,
-			StateFindWorkGreater,
-			StateUpdPrevRow,
-			StateGetNextFCount,
-			StateSetNextCount,
-			StateSetNextCountF,
-			StateGetHeightAndAux,
-			StateGetNextFunctional,
-			StateSetFlags,
-			StateGetFlags0,
-			StateGetFlags1,
-			StateGetChainWork,
-			StateGetNextCount,
-			StateSetPeer,
-			StateGetPeer,
-			StateGetExtra,
-			StateSetInputs,
-			StateGetInputs,
-			StateSetTxosAndExtra,
-			StateGetTxos,
-			StateFindByTxos,
-			TipAdd,
-			TipDel,
-			TipReachableAdd,
-			TipReachableDel,
-			EnumTips,
-			EnumFunctionalTips,
-			EnumAtHeight,
-			EnumAncestors,
-			StateGetPrev,
-			Unactivate,
-			Activate,
-			StateGetBlock,
-			StateSetBlock,
-			StateDelBlockPP,
-			StateDelBlockPPR,
-			StateDelBlockAll,
-			EventIns,
-			EventDel,
-			EventEnum,
-			EventFind,
-			PeerAdd,
-			PeerDel,
-			PeerEnum,
-			BbsEnumCSeq,
-			BbsHistogram,
-			BbsEnumAllSeq,
-			BbsEnumAll,
-			BbsFindRaw,
-			BbsFind,
-			BbsFindCursor,
-			BbsDel,
-			BbsIns,
-			BbsMaxTime,
-			BbsTotals,
-			DummyIns,
-			DummyFindLowest,
-			DummyFind,
-			DummyUpdHeight,
-			DummyDel,
-			KernelIns,
-			KernelFind,
-			KernelDel,
-			TxoAdd,
-			TxoDel,
-			TxoDelFrom,
-			TxoSetSpent,
-			TxoEnum,
-			TxoEnumBySpentMigrate,
-			TxoSetValue,
-			TxoGetValue,
-			BlockFind,
-			FindHeightBelow,
-			StreamIns,
-			StreamDel,
-			EnumSystemStatesBkwd,
-			UniqueIns,
-			UniqueFind,
-			UniqueDel,
-
-			AssetFindOwner,
-			AssetFindMin,
-			AssetAdd,
-			AssetDel,
-			AssetGet,
-			AssetSetVal,
-
-			Dbg0,
-			Dbg1,
-			Dbg2,
-			Dbg3,
-			Dbg4,
-
+#define THE_MACRO(name) name,
+			NodeDB_QueriesAll(THE_MACRO)
+#undef THE_MACRO
 			count
 		};
+
+		static const char* get_Name(Enum);
 	};
 
 	struct StreamType
@@ -197,17 +213,51 @@ public:
 	virtual ~NodeDB();
 
 	void Close();
-	void Open(const char* szPath);
+	void Open(const char* szPath, bool bShared = false); // shared - other connections may read concurrently (WAL mode, no exclusive lock)
+	void OpenReadOnly(const char* szPath); // another connection to the shared DB, for reading only
 
 	void Vacuum();
 	void CheckIntegrity();
 
 	virtual void OnModified() {}
 
+	// Optional per-query profile of the statement steps. As the rest of NodeDB, not thread-safe:
+	// the metrics collector assumes the scrape is served on the DB thread
+	struct Profiler
+	{
+		static const uint32_t s_Buckets = 4 * 30; // log-linear, 4 per power of 2, microseconds
+
+		struct Stats
+		{
+			uint64_t m_Steps = 0;
+			uint64_t m_Rows = 0;
+			uint64_t m_Total_us = 0;
+			uint64_t m_Max_us = 0;
+			uint32_t m_pHist[s_Buckets] = {};
+
+			void Add(uint64_t dt_us, bool bRow);
+			uint64_t get_Quantile(double) const; // upper bound, microseconds
+		};
+
+		Stats m_pStats[Query::count];
+		uint64_t m_SlowQuery_us = 0; // 0 - don't log
+
+		void OnStep(Query::Enum, uint64_t dt_us, bool bRow);
+		void Dump() const; // to the log, by the total time
+		void Write(metrics::Writer&) const;
+
+		static uint32_t get_Bucket(uint64_t);
+		static uint64_t get_BucketMax(uint32_t);
+	};
+
+	void EnableProfiler(uint64_t nSlowQuery_us);
+	const Profiler* get_Profiler() const { return m_pProfiler.get(); }
+
 	class Recordset
 	{
 		sqlite3_stmt* m_pStmt;
 		NodeDB* m_pDB;
+		Query::Enum m_eQuery;
 
 		void InitInternal(NodeDB&, Query::Enum, const char*);
 
@@ -471,6 +521,52 @@ public:
 	void SetDummyHeight(const Key::ID&, Height);
 	Height GetDummyHeight(const Key::ID&);
 
+	// precomputed dummy outputs, not used yet. For them the height is the scheme height of the output
+	void InsertDummyOutput(Height hScheme, const Key::ID&, const Blob& output);
+	Height GetDummyOutput(Key::ID&, ByteBuffer& output); // returns MaxHeight if none
+	void SetDummyOutputUsed(const Key::ID&, Height);
+	uint64_t get_DummyOutputsCount();
+
+	struct KeyFilter
+	{
+		// Cuckoo filter in front of the table lookups. No false negatives, supports deletion.
+		// Rebuilt from the table on demand (initially, after rollback, or if it's overloaded)
+		struct Stats
+		{
+			uint64_t m_Lookups = 0;
+			uint64_t m_Positives = 0; // passed to the DB
+			uint64_t m_FalsePositives = 0;
+
+			double get_FpRate() const; // wrt all the lookups of the absent keys
+		} m_Stats;
+
+		bool m_Valid = false;
+
+		void Reset(uint64_t nKeys); // if nKeys is zero - the filter is disabled, i.e. passes everything
+		void Insert(const Blob&);
+		void Delete(const Blob&);
+		bool MayContain(const Blob&) const;
+
+		void Export(ByteBuffer&) const;
+		bool Import(const Blob&);
+
+	private:
+		static const uint32_t s_BucketSize = 4;
+		static const uint32_t s_MaxKicks = 500;
+
+		std::vector<uint16_t> m_vSlots; // fingerprints, zero is empty
+		uint64_t m_Count = 0;
+
+		uint64_t get_Buckets() const { return m_vSlots.size() / s_BucketSize; }
+		void get_Pos(const Blob&, uint64_t& iBucket, uint16_t& fp) const;
+		uint64_t get_AltBucket(uint64_t iBucket, uint16_t fp) const;
+		bool InsertAt(uint64_t iBucket, uint16_t fp);
+		bool DeleteAt(uint64_t iBucket, uint16_t fp);
+	};
+
+	const KeyFilter& get_KrnFilter() const { return m_KrnFilter; }
+	const KeyFilter& get_UniqueFilter() const { return m_UniqueFilter; }
+
 	void InsertKernel(const Blob&, Height h);
 	void DeleteKernel(const Blob&, Height h);
 	Height FindKernel(const Blob&); // in case of duplicates - returning the one with the largest Height
@@ -582,6 +678,16 @@ public:
 private:
 
 	sqlite3* m_pDb;
+	bool m_ReadOnly;
+
+	KeyFilter m_KrnFilter;
+	KeyFilter m_UniqueFilter;
+
+	bool TestFilter(KeyFilter&, const Blob&, bool bKrn);
+	void RebuildFilter(KeyFilter&, bool bKrn);
+	void LoadFilter(KeyFilter&, uint32_t iParam);
+	void SaveFilter(const KeyFilter&, uint32_t iParam);
+	void get_FilterStamp(uint64_t*);
 
 	struct Statement
 	{
@@ -607,8 +713,13 @@ private:
 	std::string ExecTextOut(const char*);
 	bool ExecStep(sqlite3_stmt*);
 	int ExecStepRaw(sqlite3_stmt*);
+	int ExecStepRaw(sqlite3_stmt*, Query::Enum); // profiled
+	bool TestStep(int);
 	bool ExecStep(Query::Enum, const char*); // returns true while there's a row
 
+	std::unique_ptr<Profiler> m_pProfiler;
+	uint32_t m_MetricsCollector = 0;
+
 	sqlite3_stmt* get_Statement(Query::Enum, const char*);
 
 	uint64_t get_AutoincrementID(const char* szTable);
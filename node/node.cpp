@@ -24,6 +24,7 @@
 #include "../utility/io/tcpserver.h"
 #include "../utility/logger.h"
 #include "../utility/logger_checkpoints.h"
+#include "../utility/metrics.h"
 
 #include "pow/external_pow.h"
 
@@ -82,6 +83,7 @@ void Node::UpdateSyncStatus()
 					peer.SendLogin();
 			}
 
+			m_DummyPool.Refill();
 		}
 
 		if (m_Cfg.m_Observer)
@@ -549,6 +551,8 @@ void Node::Processor::FlushInsanePeers()
 void Node::Processor::DeleteOutdated()
 {
 	TxPool::Fluff& txp = get_ParentObj().m_TxPool;
+	txp.ResetTemplate(); // tip changed
+
 	for (TxPool::Fluff::Queue::iterator it = txp.m_Queue.begin(); txp.m_Queue.end() != it; )
 	{
 		TxPool::Fluff::Element& x = (it++)->get_ParentObj();
@@ -667,6 +671,8 @@ void Node::Processor::OnRolledBack()
 
 	// Delete shielded txs which referenced shielded outputs which were reverted
 	TxPool::Fluff& txp = get_ParentObj().m_TxPool;
+	txp.ResetTemplate();
+
 	for (TxPool::Fluff::Queue::iterator it = txp.m_Queue.begin(); txp.m_Queue.end() != it; )
 	{
 		TxPool::Fluff::Element& x = (it++)->get_ParentObj();
@@ -689,6 +695,13 @@ void Node::Processor::OnRolledBack()
 		pObserver->OnRolledBack(m_Cursor.m_ID);
 }
 
+void Node::Processor::OnBlockInterpreted(const NodeDB::StateID&, const Block::SystemState::Full& s, const Block::Body& block)
+{
+	IObserver* pObserver = get_ParentObj().m_Cfg.m_Observer;
+	if (pObserver)
+		pObserver->OnBlockInterpreted(s, block);
+}
+
 uint32_t Node::Processor::MyExecutorMT::get_Threads()
 {
 	Config& cfg = get_ParentObj().get_ParentObj().m_Cfg; // alias
@@ -889,6 +902,9 @@ void Node::Initialize(IExternalPOW* externalPOW)
 	ZeroObject(m_SyncStatus);
     RefreshCongestions();
 
+	// scraped on the reactor thread
+	m_MetricsCollector = metrics::Registry::get().AddCollector([this](metrics::Writer& w) { WriteMetrics(w); });
+
     if (m_Cfg.m_Listen.port())
     {
         m_Server.Listen(m_Cfg.m_Listen);
@@ -898,6 +914,7 @@ void Node::Initialize(IExternalPOW* externalPOW)
 
     m_PeerMan.Initialize();
     m_Miner.Initialize(externalPOW);
+    m_DummyPool.Initialize();
 	m_Processor.get_DB().get_BbsTotals(m_Bbs.m_Totals);
     m_Bbs.Cleanup();
 	m_Bbs.m_HighestPosted_s = m_Processor.get_DB().get_BbsMaxTime();
@@ -1049,6 +1066,9 @@ Node::~Node()
 {
     LOG_INFO() << "Node stopping...";
 
+	if (m_MetricsCollector)
+		metrics::Registry::get().RemoveCollector(m_MetricsCollector);
+
     m_Miner.HardAbortSafe();
 	if (m_Miner.m_External.m_pSolver)
 		m_Miner.m_External.m_pSolver->stop();
@@ -2422,27 +2442,26 @@ void Node::AddDummyOutputs(Transaction& tx)
 
     while (tx.m_vOutputs.size() < m_Cfg.m_Dandelion.m_OutputsMin)
     {
-		CoinID cid(Zero);
-		cid.m_Type = Key::Type::Decoy;
-        cid.set_Subkey(m_Keys.m_nMinerSubIndex);
-
-		while (true)
-		{
-			NextNonce().ExportWord<0>(cid.m_Idx);
-			if (MaxHeight == db.GetDummyHeight(cid))
-				break;
-		}
-
         bModified = true;
 
-        Output::Ptr pOutput(new Output);
+        DummyPool::Item di;
         ECC::Scalar::Native sk;
-        pOutput->Create(m_Processor.m_Cursor.m_ID.m_Height + 1, sk, *m_Keys.m_pMiner, cid, *m_Keys.m_pOwner);
 
 		Height h = SampleDummySpentHeight();
-        db.InsertDummy(h, cid);
 
-        tx.m_vOutputs.push_back(std::move(pOutput));
+        if (m_DummyPool.Take(di, sk))
+            db.SetDummyOutputUsed(di.m_Cid, h);
+        else
+        {
+            // none precomputed, create it now
+            di.m_Cid = get_NewDummyID();
+            di.m_pOutput.reset(new Output);
+            di.m_pOutput->Create(m_Processor.m_Cursor.m_ID.m_Height + 1, sk, *m_Keys.m_pMiner, di.m_Cid, *m_Keys.m_pOwner);
+
+            db.InsertDummy(h, di.m_Cid);
+        }
+
+        tx.m_vOutputs.push_back(std::move(di.m_pOutput));
 
         sk = -sk;
         tx.m_Offset = ECC::Scalar::Native(tx.m_Offset) + sk;
@@ -2452,9 +2471,154 @@ void Node::AddDummyOutputs(Transaction& tx)
     {
         m_Processor.FlushDB();
         tx.Normalize();
+        m_DummyPool.Refill();
     }
 }
 
+CoinID Node::get_NewDummyID()
+{
+	CoinID cid(Zero);
+	cid.m_Type = Key::Type::Decoy;
+	cid.set_Subkey(m_Keys.m_nMinerSubIndex);
+
+	while (true)
+	{
+		NextNonce().ExportWord<0>(cid.m_Idx);
+		if ((m_DummyPool.m_setIdxPending.end() == m_DummyPool.m_setIdxPending.find(cid.m_Idx)) &&
+			(MaxHeight == m_Processor.get_DB().GetDummyHeight(cid)))
+			break;
+	}
+
+	return cid;
+}
+
+struct Node::DummyPool::Task
+	:public Executor::TaskAsync
+{
+	std::shared_ptr<Ready> m_pReady;
+	Key::IKdf::Ptr m_pKdf;
+	Key::IPKdf::Ptr m_pOwner;
+	Item m_Item;
+
+	virtual void Exec(Executor::Context&) override
+	{
+		ECC::Scalar::Native sk;
+		m_Item.m_pOutput.reset(new Output);
+		m_Item.m_pOutput->Create(m_Item.m_hScheme, sk, *m_pKdf, m_Item.m_Cid, *m_pOwner);
+
+		{
+			std::scoped_lock<std::mutex> scope(m_pReady->m_Mutex);
+			m_pReady->m_vItems.push_back(std::move(m_Item));
+			m_pReady->m_Pending--;
+		}
+
+		m_pReady->m_Trigger(); // no-op if the pool is gone
+	}
+};
+
+void Node::DummyPool::Initialize()
+{
+	m_pEvtReady = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { SaveReady(); });
+	m_pReady->m_Trigger = m_pEvtReady;
+	Refill();
+}
+
+void Node::DummyPool::SaveReady()
+{
+	std::vector<Item> v;
+	{
+		std::scoped_lock<std::mutex> scope(m_pReady->m_Mutex);
+		v.swap(m_pReady->m_vItems);
+	}
+
+	NodeDB& db = get_ParentObj().m_Processor.get_DB();
+	Serializer ser;
+
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		const Item& x = v[i];
+
+		ser.reset();
+		ser & *x.m_pOutput;
+
+		SerializeBuffer sb = ser.buffer();
+		db.InsertDummyOutput(x.m_hScheme, x.m_Cid, Blob(sb.first, static_cast<uint32_t>(sb.second)));
+		m_setIdxPending.erase(x.m_Cid.m_Idx);
+	}
+}
+
+bool Node::DummyPool::Take(Item& res, ECC::Scalar::Native& sk)
+{
+	SaveReady();
+
+	Node& n = get_ParentObj();
+	NodeDB& db = n.m_Processor.get_DB();
+
+	size_t iFork = Rules::get().FindFork(n.m_Processor.m_Cursor.m_ID.m_Height + 1);
+
+	while (true)
+	{
+		ByteBuffer buf;
+		res.m_hScheme = db.GetDummyOutput(res.m_Cid, buf);
+		if (MaxHeight == res.m_hScheme)
+			return false;
+
+		if (Rules::get().FindFork(res.m_hScheme) == iFork) // rangeproof depends on the fork
+		{
+			res.m_pOutput.reset(new Output);
+
+			Deserializer der;
+			der.reset(buf);
+			der & *res.m_pOutput;
+
+			ECC::Point comm;
+			CoinID::Worker(res.m_Cid).Create(sk, comm, *n.m_Keys.m_pMiner);
+
+			if (comm == res.m_pOutput->m_Commitment)
+				return true;
+		}
+
+		db.DeleteDummy(res.m_Cid);
+	}
+}
+
+void Node::DummyPool::Refill()
+{
+	Node& n = get_ParentObj();
+	if (!n.m_Cfg.m_Dandelion.m_DummyLifetimeHi || !n.m_Keys.m_pMiner || !n.m_PostStartSynced)
+		return; // create them only when the node is idle
+
+	uint32_t nHave = static_cast<uint32_t>(n.m_Processor.get_DB().get_DummyOutputsCount());
+	{
+		std::scoped_lock<std::mutex> scope(m_pReady->m_Mutex);
+		nHave += static_cast<uint32_t>(m_pReady->m_vItems.size()) + m_pReady->m_Pending;
+	}
+
+	if (nHave >= n.m_Cfg.m_Dandelion.m_DummiesPrecomputed)
+		return;
+
+	uint32_t nMissing = n.m_Cfg.m_Dandelion.m_DummiesPrecomputed - nHave;
+	{
+		std::scoped_lock<std::mutex> scope(m_pReady->m_Mutex);
+		m_pReady->m_Pending += nMissing;
+	}
+
+	Executor& ex = n.m_Processor.get_Executor();
+
+	for (uint32_t i = 0; i < nMissing; i++)
+	{
+		std::unique_ptr<Task> pTask(new Task);
+		pTask->m_pReady = m_pReady;
+		pTask->m_pKdf = n.m_Keys.m_pMiner;
+		pTask->m_pOwner = n.m_Keys.m_pOwner;
+		pTask->m_Item.m_Cid = n.get_NewDummyID();
+		pTask->m_Item.m_hScheme = n.m_Processor.m_Cursor.m_ID.m_Height + 1;
+		m_setIdxPending.insert(pTask->m_Item.m_Cid.m_Idx);
+
+		ex.Push(std::move(pTask));
+	}
+}
+
 Height Node::SampleDummySpentHeight()
 {
 	const Config::Dandelion& d = m_Cfg.m_Dandelion; // alias
@@ -2520,9 +2684,9 @@ bool Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const Peer* pPeer, TxPo
 
 	TxPool::Fluff::Element* pNewTxElem = m_TxPool.AddValidTx(std::move(ptx), ctx, key.m_Key);
 
-	while (m_TxPool.m_setProfit.size() > m_Cfg.m_MaxPoolTransactions)
+	while ((m_TxPool.m_setProfit.size() > m_Cfg.m_MaxPoolTransactions) || (m_TxPool.m_SizeTotal > m_Cfg.m_MaxPoolSize))
 	{
-		TxPool::Fluff::Element& txDel = m_TxPool.m_setProfit.rbegin()->get_ParentObj();
+		TxPool::Fluff::Element& txDel = m_TxPool.get_Worst();
 		if (&txDel == pNewTxElem)
 			pNewTxElem = nullptr; // Anti-spam protection: in case the maximum pool capacity is reached - ensure this tx is any better BEFORE broadcasting ti
 
@@ -2613,6 +2777,33 @@ void Node::Peer::OnLogin(proto::Login&& msg)
 	BroadcastBbs();
 }
 
+void Node::WriteMetrics(metrics::Writer& w)
+{
+	w.Header("beam_peers", "Connected peers", "gauge");
+	w.Value("beam_peers", "", static_cast<uint64_t>(m_lstPeers.size()));
+
+	w.Header("beam_peer_received_bytes_total", "Bytes received from the peer", "counter");
+	for (Peer& p : m_lstPeers)
+		if (p.get_Connection())
+			w.Value("beam_peer_received_bytes_total", metrics::Writer::Label("peer", p.m_RemoteAddr.str()), p.get_Connection()->get_State().received);
+
+	w.Header("beam_peer_sent_bytes_total", "Bytes sent to the peer", "counter");
+	for (Peer& p : m_lstPeers)
+		if (p.get_Connection())
+			w.Value("beam_peer_sent_bytes_total", metrics::Writer::Label("peer", p.m_RemoteAddr.str()), p.get_Connection()->get_State().sent);
+
+	w.Header("beam_peer_chocking_total", "Times the peer was chocking", "counter");
+	for (Peer& p : m_lstPeers)
+		w.Value("beam_peer_chocking_total", metrics::Writer::Label("peer", p.m_RemoteAddr.str()), static_cast<uint64_t>(p.m_ChockingEvents));
+
+	w.Header("beam_txpool_txs", "Transactions in the pool", "gauge");
+	w.Value("beam_txpool_txs", "pool=\"fluff\"", static_cast<uint64_t>(m_TxPool.m_setTxs.size()));
+	w.Value("beam_txpool_txs", "pool=\"stem\"", static_cast<uint64_t>(m_Dandelion.m_setTime.size()));
+
+	w.Header("beam_txpool_bytes", "Size of the fluff pool transactions", "gauge");
+	w.Value("beam_txpool_bytes", "", m_TxPool.m_SizeTotal);
+}
+
 bool Node::Peer::IsChocking(size_t nExtra /* = 0 */)
 {
 	if (Flags::Chocking & m_Flags)
@@ -2629,6 +2820,10 @@ void Node::Peer::OnChocking()
 {
 	if (!(Flags::Chocking & m_Flags))
 	{
+		static metrics::Counter& s_Chocking = metrics::Registry::get().get_Counter("beam_chocking_events_total", "Peers that stopped being fed due to the send backlog");
+		s_Chocking.Inc();
+		m_ChockingEvents++;
+
 		m_Flags |= Flags::Chocking;
 		Send(proto::Ping(Zero));
 	}
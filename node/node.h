@@ -37,6 +37,7 @@ struct Node
 		virtual void OnSyncProgress() = 0;
 		virtual void OnStateChanged() {}
 		virtual void OnRolledBack(const Block::SystemState::ID& id) {};
+		virtual void OnBlockInterpreted(const Block::SystemState::Full&, const Block::Body&) {}
 		virtual void InitializeUtxosProgress(uint64_t done, uint64_t total) {};
 
         enum Error
@@ -71,6 +72,7 @@ struct Node
 
 		uint32_t m_MaxConcurrentBlocksRequest = 18;
 		uint32_t m_MaxPoolTransactions = 100 * 1000;
+		uint64_t m_MaxPoolSize = uint64_t(100) * 1024 * 1024; // netto size of all the pool txs. Least profitable are evicted
 		uint32_t m_MiningThreads = 0; // by default disabled
 
 		bool m_LogEvents = false; // may be insecure. Off by default.
@@ -134,6 +136,7 @@ struct Node
 			// dummy creation strategy
 			uint32_t m_DummyLifetimeLo = 720;
 			uint32_t m_DummyLifetimeHi = 1440 * 7; // set to 0 to disable
+			uint32_t m_DummiesPrecomputed = 10; // created in advance on the verification threads. Set to 0 to create them on demand
 
 		} m_Dandelion;
 
@@ -208,6 +211,7 @@ private:
 		void OnPeerInsane(const PeerID&) override;
 		void OnNewState() override;
 		void OnRolledBack() override;
+		void OnBlockInterpreted(const NodeDB::StateID&, const Block::SystemState::Full&, const Block::Body&) override;
 		void OnModified() override;
 		Key::IPKdf* get_ViewerKey() override;
 		const ShieldedTxo::Viewer* get_ViewerShieldedKey() override;
@@ -349,6 +353,39 @@ private:
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_Dandelion)
 	} m_Dandelion;
 
+	struct DummyPool
+	{
+		// dummy outputs with the rangeproofs, created by the verification threads when the node is idle, and kept in the DB until used
+		struct Item
+		{
+			CoinID m_Cid;
+			Height m_hScheme;
+			Output::Ptr m_pOutput;
+		};
+
+		struct Task;
+
+		// shared with the tasks, which may outlive the pool
+		struct Ready
+		{
+			std::mutex m_Mutex;
+			std::vector<Item> m_vItems; // not saved yet. Protected by mutex
+			uint32_t m_Pending = 0; // protected by mutex
+			io::AsyncEvent::Trigger m_Trigger;
+		};
+
+		std::shared_ptr<Ready> m_pReady = std::make_shared<Ready>();
+		io::AsyncEvent::Ptr m_pEvtReady;
+		std::set<uint64_t> m_setIdxPending; // not saved yet, to avoid collisions
+
+		void Initialize();
+		bool Take(Item&, ECC::Scalar::Native& sk);
+		void Refill();
+		void SaveReady();
+
+		IMPLEMENT_GET_PARENT_OBJ(Node, m_DummyPool)
+	} m_DummyPool;
+
 	uint8_t OnTransactionStem(Transaction::Ptr&&, const Peer*);
 	void OnTransactionAggregated(Dandelion::Element&);
 	void PerformAggregation(Dandelion::Element&);
@@ -356,6 +393,7 @@ private:
 	bool AddDummyInputRaw(Transaction& tx, const CoinID&);
 	bool AddDummyInputEx(Transaction& tx, const CoinID&);
 	void AddDummyOutputs(Transaction&);
+	CoinID get_NewDummyID();
 	Height SampleDummySpentHeight();
 	bool OnTransactionFluff(Transaction::Ptr&&, const Peer*, Dandelion::Element*);
 
@@ -470,6 +508,7 @@ private:
 
 		uint16_t m_Flags;
 		uint16_t m_Port; // to connect to
+		uint32_t m_ChockingEvents = 0;
 		beam::io::Address m_RemoteAddr; // for logging only
 
 		Block::SystemState::Full m_Tip;
@@ -578,6 +617,9 @@ private:
 
 	void RefreshCongestions();
 
+	uint32_t m_MetricsCollector = 0;
+	void WriteMetrics(metrics::Writer&);
+
 	struct Server
 		:public proto::NodeConnection::Server
 	{
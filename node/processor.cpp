@@ -19,11 +19,20 @@
 #include "../utility/serialize.h"
 #include "../utility/logger.h"
 #include "../utility/logger_checkpoints.h"
+#include "../utility/metrics.h"
 #include <condition_variable>
 #include <cctype>
 
 namespace beam {
 
+namespace
+{
+	metrics::Histogram& get_BlockPhaseTime(const char* szPhase)
+	{
+		return metrics::Registry::get().get_Histogram("beam_block_interpret_seconds", "Block interpretation time per phase", metrics::Writer::Label("phase", szPhase));
+	}
+}
+
 void NodeProcessor::OnCorrupted()
 {
 	CorruptionException exc;
@@ -86,7 +95,10 @@ void NodeProcessor::Initialize(const char* szPath)
 
 void NodeProcessor::Initialize(const char* szPath, const StartParams& sp)
 {
-	m_DB.Open(szPath);
+	if (sp.m_DbProfile || sp.m_DbSlowQuery_ms)
+		m_DB.EnableProfiler(uint64_t(sp.m_DbSlowQuery_ms) * 1000);
+
+	m_DB.Open(szPath, sp.m_SharedDB);
 	m_DbTx.Start(m_DB);
 
 	if (sp.m_CheckIntegrity)
@@ -312,6 +324,9 @@ NodeProcessor::~NodeProcessor()
 
 void NodeProcessor::CommitUtxosAndDB()
 {
+	static metrics::Histogram& s_hTime = get_BlockPhaseTime("commit");
+	metrics::Timer t(s_hTime);
+
 	UtxoTreeMapped::Stamp us;
 
 	bool bFlushUtxos = (m_Utxos.IsOpen() && m_Utxos.get_Hdr().m_Dirty);
@@ -327,6 +342,8 @@ void NodeProcessor::CommitUtxosAndDB()
 		}
 
 		m_DB.ParamSet(NodeDB::ParamID::UtxoStamp, nullptr, &blob);
+
+		m_Utxos.PrepareFlush(us);
 	}
 
 	m_DbTx.Commit();
@@ -338,7 +355,7 @@ void NodeProcessor::CommitUtxosAndDB()
 void NodeProcessor::Vacuum()
 {
 	if (m_DbTx.IsInProgress())
-		m_DbTx.Commit();
+		CommitUtxosAndDB();
 
 	LOG_INFO() << "DB compacting...";
 	m_DB.Vacuum();
@@ -1323,6 +1340,9 @@ void NodeProcessor::MultiblockContext::MyTask::Exec(Executor::Context&)
 
 void NodeProcessor::MultiblockContext::MyTask::SharedBlock::Exec(uint32_t iVerifier)
 {
+	static metrics::Histogram& s_hTime = get_BlockPhaseTime("verify"); // per verifier
+	metrics::Timer t(s_hTime);
+
 	TxBase::Context ctx(m_Ctx.m_Params);
 	ctx.m_Height = m_Ctx.m_Height;
 	ctx.m_iVerifier = iVerifier;
@@ -2108,6 +2128,9 @@ struct NodeProcessor::KrnFlyMmr
 
 bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, const Block::SystemState::Full& s, MultiblockContext& mbc)
 {
+	static metrics::Histogram& s_hTime = get_BlockPhaseTime("handle");
+	metrics::Timer t(s_hTime);
+
 	ByteBuffer bbP, bbE;
 	m_DB.GetStateBlock(sid.m_Row, &bbP, &bbE, nullptr);
 
@@ -2302,15 +2325,22 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, const Block::SystemS
 		}
 
 		m_RecentStates.Push(sid.m_Row, s);
+
+		OnBlockInterpreted(sid, s, block);
 	}
 
 	return bOk;
 }
 
 void NodeProcessor::AdjustOffset(ECC::Scalar& offs, uint64_t rowid, bool bAdd)
+{
+	AdjustOffset(m_DB, offs, rowid, bAdd);
+}
+
+void NodeProcessor::AdjustOffset(NodeDB& db, ECC::Scalar& offs, uint64_t rowid, bool bAdd)
 {
 	ECC::Scalar offsPrev;
-	if (!m_DB.get_StateExtra(rowid, offsPrev))
+	if (!db.get_StateExtra(rowid, offsPrev))
 		OnCorrupted();
 
 	ECC::Scalar::Native s(offsPrev);
@@ -3518,13 +3548,18 @@ bool NodeProcessor::ValidateUniqueNoDup(BlockInterpretCtx& bic, const Blob& key)
 }
 
 void NodeProcessor::ToInputWithMaturity(Input& inp, TxoID id)
+{
+	ToInputWithMaturity(m_DB, inp, id);
+}
+
+void NodeProcessor::ToInputWithMaturity(NodeDB& db, Input& inp, TxoID id)
 {
 	// awkward and relatively used, but this is not used frequently.
 	// NodeDB::StateInput doesn't contain the maturity of the spent UTXO. Hence we reconstruct it
 	// We find the original UTXO height, and then decode the UTXO body, and check its additional maturity factors (coinbase, incubation)
 
 	NodeDB::WalkerTxo wlk;
-	m_DB.TxoGetValue(wlk, id);
+	db.TxoGetValue(wlk, id);
 
 	uint8_t pNaked[s_TxoNakedMax];
 	Blob val = wlk.m_Value;
@@ -3540,7 +3575,7 @@ void NodeProcessor::ToInputWithMaturity(Input& inp, TxoID id)
 	inp.m_Internal.m_ID = id;
 
 	NodeDB::StateID sidPrev;
-	m_DB.FindStateByTxoID(sidPrev, id); // relatively heavy operation: search for the original txo height
+	db.FindStateByTxoID(sidPrev, id); // relatively heavy operation: search for the original txo height
 
 	inp.m_Internal.m_Maturity = outp.get_MinMaturity(sidPrev.m_Height);
 }
@@ -4046,6 +4081,33 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 
 	ECC::Scalar::Native offset = bc.m_Block.m_Offset;
 
+	// our own elements are validated in the current context, and undone before return
+	struct OwnElements
+	{
+		NodeProcessor& m_This;
+		BlockInterpretCtx& m_Bic;
+		const Output* m_pCoinbase = nullptr;
+		const TxKernel* m_pKrn = nullptr;
+		const Output* m_pFees = nullptr;
+
+		OwnElements(NodeProcessor& x, BlockInterpretCtx& bic) :m_This(x), m_Bic(bic) {}
+
+		~OwnElements()
+		{
+			m_Bic.m_Fwd = false;
+
+			if (m_pFees)
+				BEAM_VERIFY(m_This.HandleBlockElement(*m_pFees, m_Bic));
+			if (m_pKrn)
+				BEAM_VERIFY(m_This.HandleBlockElement(*m_pKrn, m_Bic));
+			if (m_pCoinbase)
+				BEAM_VERIFY(m_This.HandleBlockElement(*m_pCoinbase, m_Bic));
+
+			m_Bic.m_Fwd = true;
+		}
+
+	} own(*this, bic);
+
 	if (BlockContext::Mode::Assemble != bc.m_Mode)
 	{
 		if (pOutp)
@@ -4053,12 +4115,14 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 			if (!HandleBlockElement(*pOutp, bic))
 				return 0;
 
+			own.m_pCoinbase = pOutp.get();
 			bc.m_Block.m_vOutputs.push_back(std::move(pOutp));
 		}
 
 		if (!HandleBlockElement(*pKrn, bic))
 			return 0;
 
+		own.m_pKrn = pKrn.get();
 		bc.m_Block.m_vKernels.push_back(std::move(pKrn));
 	}
 
@@ -4074,99 +4138,293 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretC
 		m_nSizeUtxoComission = ssc2.m_Counter.m_Value;
 	}
 
-	if (bc.m_Fees)
-		ssc.m_Counter.m_Value += m_nSizeUtxoComission;
-
 	const size_t nSizeMax = Rules::get().MaxBodySize;
-	if (ssc.m_Counter.m_Value > nSizeMax)
+	if (ssc.m_Counter.m_Value + (bc.m_Fees ? m_nSizeUtxoComission : 0) > nSizeMax)
 	{
 		// the block may be non-empty (i.e. contain treasury)
 		LOG_WARNING() << "Block too large.";
 		return 0; //
 	}
 
-	size_t nTxNum = 0;
+	UpdateTemplate(bc, bic, ssc.m_Counter.m_Value);
 
-	for (TxPool::Fluff::ProfitSet::iterator it = bc.m_TxPool.m_setProfit.begin(); bc.m_TxPool.m_setProfit.end() != it; )
+	const TxPool::Fluff::Template& tpl = bc.m_TxPool.m_Template; // alias
+	for (size_t i = 0; i < tpl.m_vElems.size(); i++)
 	{
-		TxPool::Fluff::Element& x = (it++)->get_ParentObj();
+		const Transaction& tx = *tpl.m_vElems[i]->m_pValue;
+
+		TxVectors::Writer(bc.m_Block, bc.m_Block).Dump(tx.get_Reader());
+		offset += ECC::Scalar::Native(tx.m_Offset);
+	}
+
+	bc.m_Fees += tpl.m_Fees;
+	ssc.m_Counter.m_Value += tpl.m_Size;
+	if (bc.m_Fees)
+		ssc.m_Counter.m_Value += m_nSizeUtxoComission;
 
-		if (AmountBig::get_Hi(x.m_Profit.m_Fee))
+	size_t nTxNum = tpl.m_vElems.size();
+
+	LOG_INFO() << "GenerateNewBlock: size of block = " << ssc.m_Counter.m_Value << "; amount of tx = " << nTxNum;
+
+	if (BlockContext::Mode::Assemble != bc.m_Mode)
+	{
+		if (bc.m_Fees)
 		{
-			// huge fees are unsupported
-			bc.m_TxPool.Delete(x);
-			continue;
+			bb.AddFees(bc.m_Fees, pOutp);
+			if (!HandleBlockElement(*pOutp, bic))
+				return 0;
+
+			own.m_pFees = pOutp.get();
+			bc.m_Block.m_vOutputs.push_back(std::move(pOutp));
 		}
 
-		Amount feesNext = bc.m_Fees + AmountBig::get_Lo(x.m_Profit.m_Fee);
-		if (feesNext < bc.m_Fees)
-			continue; // huge fees are unsupported
+		bb.m_Offset = -bb.m_Offset;
+		offset += bb.m_Offset;
+	}
+	else
+	{
+		// The template may be reused without interpretation. The assembled block is handed over as-is, hence validate it once in the current context
+		if (!HandleValidatedTx(bc.m_Block, bic))
+		{
+			LOG_WARNING() << "Assembled block is invalid";
+			bc.m_TxPool.ResetTemplate();
+			return 0;
+		}
+
+		bic.m_Fwd = false;
+		BEAM_VERIFY(HandleValidatedTx(bc.m_Block, bic)); // undo changes
+		bic.m_Fwd = true;
+	}
+
+	bc.m_Block.m_Offset = offset;
+
+	return ssc.m_Counter.m_Value;
+}
+
+bool NodeProcessor::IsTemplateActual(const TxPool::Fluff::Template& tpl) const
+{
+	if (!tpl.m_bActual || (tpl.m_Tip != m_Cursor.m_ID))
+		return false;
+
+	for (size_t i = 0; i < tpl.m_vElems.size(); i++)
+		if (!tpl.m_vElems[i]->m_pValue)
+			return false; // deleted from the pool
+
+	return true;
+}
+
+bool NodeProcessor::get_TemplateNewTxs(TxPool::Fluff& txp, std::vector<TxPool::Fluff::Element*>& vNew, size_t nSizeBase) const
+{
+	const TxPool::Fluff::Template& tpl = txp.m_Template; // alias
+	size_t nSizeNew = 0;
 
-		size_t nSizeNext = ssc.m_Counter.m_Value + x.m_Profit.m_nSize;
-		if (!bc.m_Fees && feesNext)
-			nSizeNext += m_nSizeUtxoComission;
+	TxPool::Fluff::Queue::iterator it = tpl.m_pCursor ?
+		++TxPool::Fluff::Queue::s_iterator_to(tpl.m_pCursor->m_Queue) :
+		txp.m_Queue.begin();
 
-		if (nSizeNext > nSizeMax)
+	for (; txp.m_Queue.end() != it; ++it)
+	{
+		TxPool::Fluff::Element& x = it->get_ParentObj();
+		if (x.m_pValue)
 		{
-			if (bc.m_Block.m_vInputs.empty() &&
-				(bc.m_Block.m_vOutputs.size() == 1) &&
-				(bc.m_Block.m_vKernels.size() == 1))
-			{
-				// won't fit in empty block
-				LOG_INFO() << "Tx is too big.";
-				bc.m_TxPool.Delete(x);
-			}
-			continue;
+			vNew.push_back(&x);
+			nSizeNew += x.m_Profit.m_nSize;
 		}
+	}
+
+	// newer txs, by profit
+	std::sort(vNew.begin(), vNew.end(), [](const TxPool::Fluff::Element* p0, const TxPool::Fluff::Element* p1) {
+		return p0->m_Profit < p1->m_Profit;
+	});
 
-		Transaction& tx = *x.m_pValue;
+	if (!vNew.empty() && (nSizeBase + tpl.m_Size + nSizeNew + m_nSizeUtxoComission > Rules::get().MaxBodySize))
+	{
+		// Not all the newer txs would fit. If the best of them is better than the worst selected - selection should be redone
+		for (size_t i = 0; i < tpl.m_vElems.size(); i++)
+			if (vNew.front()->m_Profit < tpl.m_vElems[i]->m_Profit)
+				return false;
+	}
+
+	return true;
+}
+
+void NodeProcessor::get_TemplateRelated(const TxPool::Fluff::Template& tpl, const std::vector<TxPool::Fluff::Element*>& vNew, std::vector<TxPool::Fluff::Element*>& vRes) const
+{
+	// The newer txs may interfere with the selected ones only via the same inputs or kernels.
+	// Unless they have kernels with the context-dependent logic (non-std, relative locks), then all the selected txs are related.
+	struct Walker
+		:public TxKernel::IWalker
+	{
+		std::set<Merkle::Hash> m_setKrns;
+		bool m_Collect = true;
 
-		bool bDelete = !x.m_Threshold.m_Height.IsInRange(bic.m_Height);
-		if (!bDelete)
+		virtual bool OnKrn(const TxKernel& krn) override
 		{
-			assert(!bic.m_LimitExceeded);
-			if (HandleValidatedTx(tx, bic))
-			{
-				TxVectors::Writer(bc.m_Block, bc.m_Block).Dump(tx.get_Reader());
+			if (!m_Collect)
+				return m_setKrns.end() == m_setKrns.find(krn.m_Internal.m_ID);
 
-				bc.m_Fees = feesNext;
-				ssc.m_Counter.m_Value = nSizeNext;
-				offset += ECC::Scalar::Native(tx.m_Offset);
-				++nTxNum;
-			}
-			else
-			{
-				if (bic.m_LimitExceeded)
-					bic.m_LimitExceeded = false; // don't delete it, leave it for the next block
-				else
-					bDelete = true;
-			}
+			if (krn.m_Internal.m_HasNonStd)
+				return false;
+			if ((TxKernel::Subtype::Std == krn.get_Subtype()) && Cast::Up<TxKernelStd>(krn).m_pRelativeLock)
+				return false;
+
+			m_setKrns.insert(krn.m_Internal.m_ID);
+			return true;
 		}
+	} wlk;
 
-		if (bDelete)
-			bc.m_TxPool.Delete(x); // isn't available in this context
+	std::set<ECC::Point> setIns;
+
+	bool bAll = false;
+	for (size_t i = 0; (i < vNew.size()) && !bAll; i++)
+	{
+		const Transaction& tx = *vNew[i]->m_pValue;
+		bAll = !wlk.Process(tx.m_vKernels);
+
+		for (size_t j = 0; j < tx.m_vInputs.size(); j++)
+			setIns.insert(tx.m_vInputs[j]->m_Commitment);
 	}
 
-	LOG_INFO() << "GenerateNewBlock: size of block = " << ssc.m_Counter.m_Value << "; amount of tx = " << nTxNum;
+	wlk.m_Collect = false;
 
-	if (BlockContext::Mode::Assemble != bc.m_Mode)
+	for (size_t i = 0; i < tpl.m_vElems.size(); i++)
 	{
-		if (bc.m_Fees)
+		const Transaction& tx = *tpl.m_vElems[i]->m_pValue;
+
+		bool bRelated = bAll || !wlk.Process(tx.m_vKernels);
+		for (size_t j = 0; (j < tx.m_vInputs.size()) && !bRelated; j++)
+			bRelated = (setIns.end() != setIns.find(tx.m_vInputs[j]->m_Commitment));
+
+		if (bRelated)
+			vRes.push_back(tpl.m_vElems[i]);
+	}
+}
+
+void NodeProcessor::UpdateTemplate(BlockContext& bc, BlockInterpretCtx& bic, size_t nSizeBase)
+{
+	// The txs are interpreted only if the template is rebuilt or extended. All the changes are undone afterwards
+	TxPool::Fluff& txp = bc.m_TxPool; // alias
+	const TxPool::Fluff::Template& tpl = txp.m_Template; // alias
+
+	std::vector<TxPool::Fluff::Element*> vNew;
+	std::vector<TxPool::Fluff::Element*> vApplied; // selected txs re-applied for the newer ones
+	bool bRebuild = !IsTemplateActual(tpl) || !get_TemplateNewTxs(txp, vNew, nSizeBase);
+
+	if (!bRebuild)
+	{
+		if (vNew.empty())
+			return; // unchanged
+
+		// re-apply only the related selected txs. They've already been validated in this context
+		get_TemplateRelated(tpl, vNew, vApplied);
+
+		bic.m_AlreadyValidated = true;
+
+		size_t i = 0;
+		for (; i < vApplied.size(); i++)
+			if (!HandleValidatedTx(*vApplied[i]->m_pValue, bic))
+				break;
+
+		bic.m_AlreadyValidated = false;
+
+		if (i < vApplied.size())
 		{
-			bb.AddFees(bc.m_Fees, pOutp);
-			if (!HandleBlockElement(*pOutp, bic))
-				return 0;
+			// should not happen
+			LOG_WARNING() << "Block template re-apply failed";
 
-			bc.m_Block.m_vOutputs.push_back(std::move(pOutp));
+			bic.m_Fwd = false;
+			while (i--)
+				BEAM_VERIFY(HandleValidatedTx(*vApplied[i]->m_pValue, bic));
+
+			bic.m_Fwd = true;
+			vApplied.clear();
+			bRebuild = true;
 		}
+	}
 
-		bb.m_Offset = -bb.m_Offset;
-		offset += bb.m_Offset;
+	size_t nAdded0 = tpl.m_vElems.size();
+
+	if (bRebuild)
+	{
+		txp.ResetTemplate();
+		txp.m_Template.m_Tip = m_Cursor.m_ID;
+		txp.m_Template.m_bActual = true;
+		nAdded0 = 0;
+
+		for (TxPool::Fluff::ProfitSet::iterator it = txp.m_setProfit.begin(); txp.m_setProfit.end() != it; )
+		{
+			TxPool::Fluff::Element& x = (it++)->get_ParentObj();
+			TryAddToTemplate(bc, bic, x, nSizeBase);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < vNew.size(); i++)
+			TryAddToTemplate(bc, bic, *vNew[i], nSizeBase);
 	}
 
-	bc.m_Block.m_Offset = offset;
+	// undo changes
+	bic.m_Fwd = false;
+	for (size_t i = tpl.m_vElems.size(); i-- > nAdded0; )
+		BEAM_VERIFY(HandleValidatedTx(*tpl.m_vElems[i]->m_pValue, bic));
+	for (size_t i = vApplied.size(); i--; )
+		BEAM_VERIFY(HandleValidatedTx(*vApplied[i]->m_pValue, bic));
 
-	return ssc.m_Counter.m_Value;
+	bic.m_Fwd = true;
+
+	txp.SetTemplateCursor(txp.m_Queue.empty() ? nullptr : &txp.m_Queue.back().get_ParentObj());
+}
+
+bool NodeProcessor::TryAddToTemplate(BlockContext& bc, BlockInterpretCtx& bic, TxPool::Fluff::Element& x, size_t nSizeBase)
+{
+	TxPool::Fluff& txp = bc.m_TxPool; // alias
+	const TxPool::Fluff::Template& tpl = txp.m_Template; // alias
+
+	if (AmountBig::get_Hi(x.m_Profit.m_Fee))
+	{
+		// huge fees are unsupported
+		txp.Delete(x);
+		return false;
+	}
+
+	Amount fees = bc.m_Fees + tpl.m_Fees;
+	Amount feesNext = fees + AmountBig::get_Lo(x.m_Profit.m_Fee);
+	if (feesNext < fees)
+		return false; // huge fees are unsupported
+
+	size_t nSizeNext = nSizeBase + tpl.m_Size + x.m_Profit.m_nSize;
+	if (feesNext)
+		nSizeNext += m_nSizeUtxoComission;
+
+	if (nSizeNext > Rules::get().MaxBodySize)
+	{
+		if (tpl.m_vElems.empty())
+		{
+			// won't fit in empty block
+			LOG_INFO() << "Tx is too big.";
+			txp.Delete(x);
+		}
+		return false;
+	}
+
+	if (x.m_Threshold.m_Height.IsInRange(bic.m_Height))
+	{
+		assert(!bic.m_LimitExceeded);
+		if (HandleValidatedTx(*x.m_pValue, bic))
+		{
+			txp.AddToTemplate(x);
+			return true;
+		}
+
+		if (bic.m_LimitExceeded)
+		{
+			bic.m_LimitExceeded = false; // don't delete it, leave it for the next block
+			return false;
+		}
+	}
+
+	txp.Delete(x); // isn't available in this context
+	return false;
 }
 
 void NodeProcessor::GenerateNewHdr(BlockContext& bc)
@@ -4225,12 +4483,13 @@ bool NodeProcessor::GenerateNewBlock(BlockContext& bc)
 	{
 		if (!HandleValidatedTx(bc.m_Block, bic))
 			return false;
+
+		bic.m_Fwd = false;
+		BEAM_VERIFY(HandleValidatedTx(bc.m_Block, bic)); // undo changes
 	}
 	else
-		nSizeEstimated = GenerateNewBlockInternal(bc, bic);
+		nSizeEstimated = GenerateNewBlockInternal(bc, bic); // leaves no changes
 
-	bic.m_Fwd = false;
-    BEAM_VERIFY(HandleValidatedTx(bc.m_Block, bic)); // undo changes
 	assert(bbR.empty());
 
 	// reset input maturities
@@ -4414,6 +4673,79 @@ bool NodeProcessor::ExtractBlockWithExtra(Block::Body& block, const NodeDB::Stat
 	return true;
 }
 
+void NodeProcessor::BlockReader::Init()
+{
+	m_DB.get_Cursor(m_Cursor);
+
+	m_TxoLo = m_DB.ParamIntGetDef(NodeDB::ParamID::HeightTxoLo, Rules::HeightGenesis - 1);
+	m_TxoHi = m_DB.ParamIntGetDef(NodeDB::ParamID::HeightTxoHi, Rules::HeightGenesis - 1);
+
+	if (Rules::get().TreasuryChecksum == Zero)
+		m_TxosTreasury = 1; // artificial gap
+	else
+		m_TxosTreasury = m_DB.ParamIntGetDef(NodeDB::ParamID::Treasury);
+}
+
+bool NodeProcessor::BlockReader::ExtractBlockWithExtra(Block::Body& block, const NodeDB::StateID& sid)
+{
+	// Same as GetBlockInternal for the full block (h0 = 0, hLo1 = h-1, hHi1 = h), followed by the maturity of the inputs.
+	// Within a single block nothing is spent, hence all the inputs and full outputs are included
+	if ((sid.m_Height > m_Cursor.m_Height) || (m_TxoHi > sid.m_Height) || (m_TxoLo >= sid.m_Height))
+		return false;
+
+	if (!(m_DB.GetStateFlags(sid.m_Row) & NodeDB::StateFlags::Active))
+		return false;
+
+	ByteBuffer bbE;
+	m_DB.GetStateBlock(sid.m_Row, nullptr, &bbE, nullptr);
+
+	TxoID id1 = m_DB.get_StateTxos(sid.m_Row);
+	TxoID id0;
+
+	if (!m_DB.get_StateExtra(sid.m_Row, block.m_Offset))
+		OnCorrupted();
+
+	uint64_t rowid = sid.m_Row;
+	if (m_DB.get_Prev(rowid))
+	{
+		AdjustOffset(m_DB, block.m_Offset, rowid, false);
+		id0 = m_DB.get_StateTxos(rowid);
+	}
+	else
+		id0 = m_TxosTreasury;
+
+	std::vector<NodeDB::StateInput> v;
+	m_DB.get_StateInputs(sid.m_Row, v);
+
+	block.m_vInputs.reserve(v.size());
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		Input::Ptr& pInp = block.m_vInputs.emplace_back();
+		pInp.reset(new Input);
+		ToInputWithMaturity(m_DB, *pInp, v[i].get_ID());
+	}
+
+	NodeDB::WalkerTxo wlk;
+	for (m_DB.EnumTxos(wlk, id0); wlk.MoveNext(); )
+	{
+		if (wlk.m_ID >= id1)
+			break;
+
+		Deserializer der;
+		der.reset(wlk.m_Value.p, wlk.m_Value.n);
+
+		Output::Ptr& pOutp = block.m_vOutputs.emplace_back();
+		pOutp.reset(new Output);
+		der & *pOutp;
+	}
+
+	Deserializer der;
+	der.reset(bbE);
+	der & Cast::Down<TxVectors::Eternal>(block);
+
+	return true;
+}
+
 TxoID NodeProcessor::get_TxosBefore(Height h)
 {
 	if (h < Rules::HeightGenesis)
@@ -4555,9 +4887,38 @@ void NodeProcessor::InitializeUtxos()
 {
 	assert(!m_Extra.m_Txos);
 
+	// Bulk load. Unspent TXOs are read sequentially (that's the DB), and processed in chunks:
+	//	decoded in parallel, sorted by key (and ID, to keep the duplicates in order), and inserted in this order.
+	// Sorted insertion touches the tree sequentially, which is much faster than the random order, especially for the mapped image.
+	// Finally the Merkle hashes are evaluated in parallel too.
+	static const size_t s_Chunk = 0x40000;
+
 	struct Walker
-		:public ITxoWalker_UnspentNaked
+		:public ITxoWalker
 	{
+		struct Txo
+		{
+			TxoID m_ID;
+			Height m_hCreate;
+			uint32_t m_nNaked;
+			uint8_t m_pNaked[s_TxoNakedMax];
+		};
+
+		struct Item
+		{
+			UtxoTree::Key m_Key;
+			TxoID m_ID;
+
+			bool operator < (const Item& x) const
+			{
+				int n = m_Key.V.cmp(x.m_Key.V);
+				return n ? (n < 0) : (m_ID < x.m_ID);
+			}
+		};
+
+		std::vector<Txo> m_vTxos;
+		std::vector<Item> m_vItems;
+
 		TxoID m_TxosTotal;
 		NodeProcessor& m_This;
 		Walker(NodeProcessor& x) :m_This(x) {}
@@ -4565,23 +4926,108 @@ void NodeProcessor::InitializeUtxos()
 		virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate) override
 		{
 			m_This.InitializeUtxosProgress(wlk.m_ID, m_TxosTotal);
-			return ITxoWalker_UnspentNaked::OnTxo(wlk, hCreate);
+
+			if (wlk.m_SpendHeight != MaxHeight)
+				return true;
+
+			Txo& x = m_vTxos.emplace_back();
+			x.m_ID = wlk.m_ID;
+			x.m_hCreate = hCreate;
+
+			Blob blob = wlk.m_Value;
+			TxoToNaked(x.m_pNaked, blob); // always copies into the buffer
+			x.m_nNaked = blob.n;
+
+			if (m_vTxos.size() >= s_Chunk)
+				Flush();
+
+			return true;
 		}
 
-		virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate, Output& outp) override
+		struct DecodeTask
+			:public Executor::TaskSync
 		{
-			m_This.m_Extra.m_Txos = wlk.m_ID;
-			BlockInterpretCtx bic(hCreate, true);
-			if (!m_This.HandleBlockElement(outp, bic))
-				OnCorrupted();
+			Walker* m_pThis;
 
-			return true;
+			virtual void Exec(Executor::Context& ctx) override
+			{
+				uint32_t i0, nCount;
+				ctx.get_Portion(i0, nCount, static_cast<uint32_t>(m_pThis->m_vTxos.size()));
+
+				for (nCount += i0; i0 < nCount; i0++)
+				{
+					const Txo& x = m_pThis->m_vTxos[i0];
+
+					Deserializer der;
+					der.reset(x.m_pNaked, x.m_nNaked);
+
+					Output outp;
+					der & outp;
+
+					UtxoTree::Key::Data d;
+					d.m_Commitment = outp.m_Commitment;
+					d.m_Maturity = outp.get_MinMaturity(x.m_hCreate);
+
+					Item& itm = m_pThis->m_vItems[i0];
+					itm.m_Key = d;
+					itm.m_ID = x.m_ID;
+				}
+			}
+		};
+
+		void Flush()
+		{
+			if (m_vTxos.empty())
+				return;
+
+			m_vItems.resize(m_vTxos.size());
+
+			DecodeTask t;
+			t.m_pThis = this;
+			m_This.get_Executor().ExecAll(t);
+
+			std::sort(m_vItems.begin(), m_vItems.end());
+
+			UtxoTreeMapped& u = m_This.m_Utxos;
+			u.OnDirty();
+
+			for (const Item& itm : m_vItems)
+			{
+				u.EnsureReserve();
+
+				UtxoTree::Cursor cu;
+				bool bCreate = true;
+				UtxoTree::MyLeaf* p = u.Find(cu, itm.m_Key, bCreate);
+
+				cu.InvalidateElement();
+
+				if (bCreate)
+					p->m_ID = itm.m_ID;
+				else
+				{
+					Input::Count nCountInc = p->get_Count() + 1;
+					if (!nCountInc)
+						OnCorrupted();
+
+					u.PushID(itm.m_ID, *p);
+				}
+			}
+
+			m_This.m_Extra.m_Txos = m_vTxos.back().m_ID + 1;
+
+			m_vTxos.clear();
+			m_vItems.clear();
 		}
 	};
 
 	Walker wlk(*this);
 	wlk.m_TxosTotal = get_TxosBefore(m_Cursor.m_ID.m_Height + 1);
+	wlk.m_vTxos.reserve(std::min<size_t>(s_Chunk, static_cast<size_t>(wlk.m_TxosTotal)));
+
 	EnumTxos(wlk);
+	wlk.Flush();
+
+	m_Utxos.EvaluateHashes(get_Executor());
 }
 
 bool NodeProcessor::GetBlock(const NodeDB::StateID& sid, ByteBuffer* pEthernal, ByteBuffer* pPerishable, Height h0, Height hLo1, Height hHi1, bool bActive)
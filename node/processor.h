@@ -99,9 +99,11 @@ class NodeProcessor
 	static bool TxoIsNaked(const Blob&);
 
 	void ToInputWithMaturity(Input&, TxoID);
+	static void ToInputWithMaturity(NodeDB&, Input&, TxoID);
 
 	TxoID get_TxosBefore(Height);
 	void AdjustOffset(ECC::Scalar&, uint64_t rowid, bool bAdd);
+	static void AdjustOffset(NodeDB&, ECC::Scalar&, uint64_t rowid, bool bAdd);
 
 	void InitCursor(bool bMovingUp);
 	bool InitUtxoMapping(const char*, bool bForceReset);
@@ -169,6 +171,9 @@ public:
 		bool m_Vacuum = false;
 		bool m_ResetSelfID = false;
 		bool m_EraseSelfID = false;
+		bool m_SharedDB = false; // allow concurrent read-only connections, see BlockReader
+		bool m_DbProfile = false; // per-query statement profile, logged on close
+		uint32_t m_DbSlowQuery_ms = 0; // log the statement steps above, 0 - off. Implies the profile
 	};
 
 	void Initialize(const char* szPath);
@@ -242,6 +247,22 @@ public:
 
 	bool ExtractBlockWithExtra(Block::Body&, const NodeDB::StateID&);
 
+	// Same, but over another (read-only) connection to the shared DB, independent of the processor state. Can be used from other threads.
+	// Should be used within a transaction, which gives a consistent snapshot
+	struct BlockReader
+	{
+		NodeDB& m_DB;
+		NodeDB::StateID m_Cursor;
+		Height m_TxoLo;
+		Height m_TxoHi;
+		TxoID m_TxosTreasury;
+
+		BlockReader(NodeDB& db) :m_DB(db) {}
+
+		void Init(); // reads the current state from the snapshot
+		bool ExtractBlockWithExtra(Block::Body&, const NodeDB::StateID&);
+	};
+
 	struct DataStatus {
 		enum Enum {
 			Accepted,
@@ -322,6 +343,7 @@ public:
 	virtual void OnPeerInsane(const PeerID&) {}
 	virtual void OnNewState() {}
 	virtual void OnRolledBack() {}
+	virtual void OnBlockInterpreted(const NodeDB::StateID&, const Block::SystemState::Full&, const Block::Body&) {} // fwd only, the DB reflects the block
 	virtual void OnModified() {}
 	virtual void InitializeUtxosProgress(uint64_t done, uint64_t total) {}
 
@@ -504,6 +526,11 @@ public:
 
 private:
 	size_t GenerateNewBlockInternal(BlockContext&, BlockInterpretCtx&);
+	bool IsTemplateActual(const TxPool::Fluff::Template&) const;
+	bool get_TemplateNewTxs(TxPool::Fluff&, std::vector<TxPool::Fluff::Element*>&, size_t nSizeBase) const;
+	void get_TemplateRelated(const TxPool::Fluff::Template&, const std::vector<TxPool::Fluff::Element*>& vNew, std::vector<TxPool::Fluff::Element*>&) const;
+	void UpdateTemplate(BlockContext&, BlockInterpretCtx&, size_t nSizeBase);
+	bool TryAddToTemplate(BlockContext&, BlockInterpretCtx&, TxPool::Fluff::Element&, size_t nSizeBase);
 	void GenerateNewHdr(BlockContext&);
 	DataStatus::Enum OnStateInternal(const Block::SystemState::Full&, Block::SystemState::ID&, bool bAlreadyChecked);
 	bool GetBlockInternal(const NodeDB::StateID&, ByteBuffer* pEthernal, ByteBuffer* pPerishable, Height h0, Height hLo1, Height hHi1, bool bActive, Block::Body*);
@@ -57,6 +57,10 @@ TxPool::Fluff::Element* TxPool::Fluff::AddValidTx(Transaction::Ptr&& pValue, con
 	m_setProfit.insert(p->m_Profit);
 	m_setTxs.insert(p->m_Tx);
 
+	m_SizeTotal += p->m_Profit.m_nSize;
+
+	InsertSpends(*p);
+
 	p->m_Queue.m_Refs = 1;
 	m_Queue.push_back(p->m_Queue);
 
@@ -66,12 +70,16 @@ TxPool::Fluff::Element* TxPool::Fluff::AddValidTx(Transaction::Ptr&& pValue, con
 void TxPool::Fluff::Delete(Element& x)
 {
 	assert(x.m_pValue);
+	DeleteSpends(x);
 	x.m_pValue.reset();
 
 	m_setThreshold.erase(ThresholdSet::s_iterator_to(x.m_Threshold));
 	m_setProfit.erase(ProfitSet::s_iterator_to(x.m_Profit));
 	m_setTxs.erase(TxSet::s_iterator_to(x.m_Tx));
 
+	assert(m_SizeTotal >= x.m_Profit.m_nSize);
+	m_SizeTotal -= x.m_Profit.m_nSize;
+
 	Release(x);
 }
 
@@ -88,10 +96,123 @@ void TxPool::Fluff::Release(Element& x)
 
 void TxPool::Fluff::Clear()
 {
+	ResetTemplate();
+
 	while (!m_setThreshold.empty())
 		Delete(m_setThreshold.begin()->get_ParentObj());
 }
 
+TxPool::Fluff::Element& TxPool::Fluff::get_Worst()
+{
+	assert(!m_setProfit.empty());
+	return m_setOutbid.empty() ?
+		m_setProfit.rbegin()->get_ParentObj() :
+		m_setOutbid.rbegin()->get_ParentObj();
+}
+
+void TxPool::Fluff::InsertSpends(Element& x)
+{
+	const std::vector<Input::Ptr>& vIns = x.m_pValue->m_vInputs;
+	x.m_vSpends.resize(vIns.size());
+
+	for (size_t i = 0; i < vIns.size(); i++)
+	{
+		Element::Spend& s = x.m_vSpends[i];
+		s.m_pThis = &x;
+		s.m_pInp = vIns[i].get();
+
+		std::pair<SpendSet::iterator, SpendSet::iterator> range = m_setSpends.equal_range(s);
+		for (SpendSet::iterator it = range.first; range.second != it; ++it)
+			OnConflict(x, *it->m_pThis, true);
+
+		m_setSpends.insert(s);
+	}
+}
+
+void TxPool::Fluff::DeleteSpends(Element& x)
+{
+	for (size_t i = 0; i < x.m_vSpends.size(); i++)
+	{
+		Element::Spend& s = x.m_vSpends[i];
+		m_setSpends.erase(SpendSet::s_iterator_to(s));
+
+		std::pair<SpendSet::iterator, SpendSet::iterator> range = m_setSpends.equal_range(s);
+		for (SpendSet::iterator it = range.first; range.second != it; ++it)
+			OnConflict(x, *it->m_pThis, false);
+	}
+
+	x.m_vSpends.clear();
+	assert(!x.m_Outbid.m_Count);
+}
+
+void TxPool::Fluff::OnConflict(Element& x0, Element& x1, bool bAdd)
+{
+	// equally profitable txs don't outbid each other
+	if (x0.m_Profit < x1.m_Profit)
+		SetOutbid(x1, bAdd);
+	else
+	{
+		if (x1.m_Profit < x0.m_Profit)
+			SetOutbid(x0, bAdd);
+	}
+}
+
+void TxPool::Fluff::SetOutbid(Element& x, bool bAdd)
+{
+	if (bAdd)
+	{
+		if (!x.m_Outbid.m_Count++)
+			m_setOutbid.insert(x.m_Outbid);
+	}
+	else
+	{
+		assert(x.m_Outbid.m_Count);
+		if (!--x.m_Outbid.m_Count)
+			m_setOutbid.erase(OutbidSet::s_iterator_to(x.m_Outbid));
+	}
+}
+
+void TxPool::Fluff::ResetTemplate()
+{
+	Template& tpl = m_Template; // alias
+
+	for (size_t i = 0; i < tpl.m_vElems.size(); i++)
+		Release(*tpl.m_vElems[i]);
+	tpl.m_vElems.clear();
+
+	SetTemplateCursor(nullptr);
+
+	tpl.m_Fees = 0;
+	tpl.m_Size = 0;
+	tpl.m_bActual = false;
+}
+
+void TxPool::Fluff::AddToTemplate(Element& x)
+{
+	assert(x.m_pValue);
+	x.m_Queue.m_Refs++;
+
+	Template& tpl = m_Template; // alias
+	tpl.m_vElems.push_back(&x);
+	tpl.m_Fees += AmountBig::get_Lo(x.m_Profit.m_Fee);
+	tpl.m_Size += x.m_Profit.m_nSize;
+}
+
+void TxPool::Fluff::SetTemplateCursor(Element* p)
+{
+	Template& tpl = m_Template; // alias
+	if (tpl.m_pCursor == p)
+		return;
+
+	if (p)
+		p->m_Queue.m_Refs++;
+
+	if (tpl.m_pCursor)
+		Release(*tpl.m_pCursor);
+
+	tpl.m_pCursor = p;
+}
+
 /////////////////////////////
 // Stem
 bool TxPool::Stem::TryMerge(Element& trg, Element& src)
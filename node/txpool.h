@@ -71,24 +71,75 @@ struct TxPool
 				uint32_t m_Refs = 0;
 				IMPLEMENT_GET_PARENT_OBJ(Element, m_Queue)
 			} m_Queue;
+
+			struct Spend
+				:public boost::intrusive::set_base_hook<>
+			{
+				Element* m_pThis;
+				const Input* m_pInp;
+				bool operator < (const Spend& t) const { return m_pInp->m_Commitment < t.m_pInp->m_Commitment; }
+			};
+
+			std::vector<Spend> m_vSpends;
+
+			struct Outbid
+				:public boost::intrusive::set_base_hook<>
+			{
+				uint32_t m_Count = 0; // conflicting txs (spending the same input) with better profit
+				bool operator < (const Outbid& t) const { return get_ParentObj().m_Profit < t.get_ParentObj().m_Profit; }
+				IMPLEMENT_GET_PARENT_OBJ(Element, m_Outbid)
+			} m_Outbid;
 		};
 
 		typedef boost::intrusive::multiset<Element::Tx> TxSet;
 		typedef boost::intrusive::multiset<Element::Profit> ProfitSet;
 		typedef boost::intrusive::multiset<Element::Threshold> ThresholdSet;
 		typedef boost::intrusive::list<Element::Queue> Queue;
+		typedef boost::intrusive::multiset<Element::Spend> SpendSet;
+		typedef boost::intrusive::multiset<Element::Outbid> OutbidSet;
 
 		TxSet m_setTxs;
 		ProfitSet m_setProfit;
 		ThresholdSet m_setThreshold;
 		Queue m_Queue;
+		SpendSet m_setSpends;
+		OutbidSet m_setOutbid; // txs that can't be mined along with the better ones
+
+		uint64_t m_SizeTotal = 0; // netto size of all the txs in the pool
+
+		struct Template
+		{
+			// Txs selected for the next block, consistent with each other at the tip they were selected for.
+			// Extended incrementally by the newer txs, rebuilt if the tip changes, or any of its txs is deleted from the pool.
+			std::vector<Element*> m_vElems; // in order of inclusion. Each holds a ref
+			Element* m_pCursor = nullptr; // last element in the queue that was considered. Holds a ref
+			Block::SystemState::ID m_Tip;
+			Amount m_Fees = 0;
+			size_t m_Size = 0; // txs only
+			bool m_bActual = false;
+
+		} m_Template;
 
 		Element* AddValidTx(Transaction::Ptr&&, const Transaction::Context&, const Transaction::KeyType&);
 		void Delete(Element&);
 		void Release(Element&);
 		void Clear();
 
+		// Pool txs are validated against the tip, hence they can't depend on each other. But they may conflict (spend the same input), only one of them can be mined.
+		// Outbid txs are evicted first, then the least profitable
+		Element& get_Worst();
+
+		void ResetTemplate();
+		void AddToTemplate(Element&);
+		void SetTemplateCursor(Element*);
+
 		~Fluff() { Clear(); }
+
+	private:
+		void InsertSpends(Element&);
+		void DeleteSpends(Element&);
+		void OnConflict(Element&, Element&, bool bAdd);
+		void SetOutbid(Element&, bool bAdd);
 	};
 
 	struct Stem
@@ -549,6 +549,24 @@ namespace beam
 
 		verify_test(MaxHeight == db.GetLowestDummy(kid));
 
+		// precomputed dummy outputs
+		kid.m_Idx = 347;
+		db.InsertDummyOutput(210, kid, bBodyP);
+		verify_test(db.get_DummyOutputsCount() == 1);
+		verify_test(MaxHeight == db.GetLowestDummy(kid)); // not used yet
+
+		ByteBuffer bufOutp;
+		verify_test(db.GetDummyOutput(kid, bufOutp) == 210);
+		verify_test(kid.m_Idx == 347U);
+		verify_test((bufOutp.size() == bBodyP.n) && !memcmp(&bufOutp.front(), bBodyP.p, bBodyP.n));
+
+		db.SetDummyOutputUsed(kid, 1200);
+		verify_test(db.get_DummyOutputsCount() == 0);
+		verify_test(MaxHeight == db.GetDummyOutput(kid, bufOutp));
+		verify_test(db.GetLowestDummy(kid) == 1200);
+
+		db.DeleteDummy(kid);
+
 		// Kernels
 		db.InsertKernel(bBodyP, 5);
 		db.InsertKernel(bBodyP, 5); // duplicate
@@ -567,6 +585,43 @@ namespace beam
 		db.DeleteKernel(bBodyP, 5);
 		verify_test(db.FindKernel(bBodyP) == 0);
 
+		verify_test(db.get_KrnFilter().m_Valid);
+		verify_test(db.get_KrnFilter().m_Stats.m_Lookups == 6);
+
+		{
+			// no false negatives, insertion/deletion consistent
+			NodeDB::KeyFilter kf;
+			kf.Reset(1000);
+
+			std::vector<ECC::Hash::Value> vKeys(1000);
+			for (size_t i = 0; i < vKeys.size(); i++)
+			{
+				ECC::GenRandom(vKeys[i]);
+				kf.Insert(vKeys[i]);
+			}
+			verify_test(kf.m_Valid);
+
+			for (size_t i = 0; i < vKeys.size(); i++)
+				verify_test(kf.MayContain(vKeys[i]));
+
+			for (size_t i = 0; i < vKeys.size(); i += 2)
+				kf.Delete(vKeys[i]);
+			verify_test(kf.m_Valid);
+
+			for (size_t i = 1; i < vKeys.size(); i += 2)
+				verify_test(kf.MayContain(vKeys[i]));
+
+			uint32_t nFalse = 0;
+			for (uint32_t i = 0; i < 10000; i++)
+			{
+				ECC::Hash::Value hv;
+				ECC::GenRandom(hv);
+				if (kf.MayContain(hv))
+					nFalse++;
+			}
+			verify_test(nFalse < 50); // 16-bit fingerprints
+		}
+
 		// Shielded
 		TxoID nShielded = 16 * 1024 * 3 + 5;
 		db.ShieldedResize(nShielded, 0);
@@ -697,6 +752,55 @@ namespace beam
 			NodeDB db;
 			db.Open(g_sz); // test to open already-existing DB
 		}
+
+		for (uint64_t x = 0; x < 100000; x = x * 3 / 2 + 1)
+		{
+			uint32_t i = NodeDB::Profiler::get_Bucket(x);
+			verify_test(x <= NodeDB::Profiler::get_BucketMax(i));
+			verify_test(!i || (x > NodeDB::Profiler::get_BucketMax(i - 1)));
+		}
+
+		{
+			NodeDB db;
+			db.EnableProfiler(0);
+			db.Open(g_sz);
+
+			NodeDB::StateID sid;
+			db.get_Cursor(sid); // some queries
+
+			const NodeDB::Profiler* pProf = db.get_Profiler();
+			verify_test(pProf);
+
+			uint64_t nSteps = 0;
+			for (uint32_t i = 0; i < NodeDB::Query::count; i++)
+			{
+				const NodeDB::Profiler::Stats& st = pProf->m_pStats[i];
+				nSteps += st.m_Steps;
+				verify_test(st.m_Rows <= st.m_Steps);
+				if (st.m_Steps)
+					verify_test(st.get_Quantile(0.5) <= st.get_Quantile(0.99));
+			}
+			verify_test(nSteps);
+		}
+
+		{
+			// read-only connection, as used by the explorer workers. The filters stay disabled after a rollback
+			NodeDB db;
+			db.EnableProfiler(0);
+			db.OpenReadOnly(g_sz);
+
+			Merkle::Hash hv(Zero);
+			for (int i = 0; i < 2; i++)
+			{
+				NodeDB::Transaction t(db);
+				db.FindKernel(hv);
+			} // rolled back
+
+			verify_test(db.get_KrnFilter().m_Valid);
+			verify_test(!db.get_Profiler()->m_pStats[NodeDB::Query::KernelCount].m_Steps);
+			verify_test(!db.get_Profiler()->m_pStats[NodeDB::Query::KernelEnumKeys].m_Steps);
+			verify_test(db.get_Profiler()->m_pStats[NodeDB::Query::KernelFind].m_Steps);
+		}
 	}
 
 	struct MiniWallet
@@ -958,11 +1062,36 @@ namespace beam
 				pTx->get_Key(key);
 
 				np.m_TxPool.AddValidTx(std::move(pTx), ctx, key);
+
+				// assembling extends the pool template incrementally
+				NodeProcessor::BlockContext bcAsm(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+				bcAsm.m_Mode = NodeProcessor::BlockContext::Mode::Assemble;
+				verify_test(np.GenerateNewBlock(bcAsm));
+				verify_test(np.m_TxPool.m_Template.m_vElems.size() == np.m_TxPool.m_setTxs.size());
 			}
 
+			uint64_t nSizeTotal = 0;
+			for (TxPool::Fluff::TxSet::iterator it = np.m_TxPool.m_setTxs.begin(); np.m_TxPool.m_setTxs.end() != it; it++)
+				nSizeTotal += it->get_ParentObj().m_Profit.m_nSize;
+			verify_test(np.m_TxPool.m_SizeTotal == nSizeTotal);
+
+			NodeProcessor::BlockContext bcAsm(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+			bcAsm.m_Mode = NodeProcessor::BlockContext::Mode::Assemble;
+			verify_test(np.GenerateNewBlock(bcAsm));
+
 			NodeProcessor::BlockContext bc(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
 			verify_test(np.GenerateNewBlock(bc));
 
+			// full generation must select the same
+			verify_test(bc.m_Fees == bcAsm.m_Fees);
+
+			// pool unchanged - the template is reused as-is
+			NodeProcessor::BlockContext bc2(np.m_TxPool, 0, *np.m_Wallet.m_pKdf, *np.m_Wallet.m_pKdf);
+			verify_test(np.GenerateNewBlock(bc2));
+			verify_test(bc2.m_Fees == bc.m_Fees);
+			verify_test(bc2.m_Hdr.m_Definition == bc.m_Hdr.m_Definition);
+			verify_test(bc2.m_Block.m_vKernels.size() == bc.m_Block.m_vKernels.size());
+
 			np.OnState(bc.m_Hdr, PeerID());
 
 			Block::SystemState::ID id;
@@ -2654,6 +2783,19 @@ namespace beam
 
 		verify_test((p.m_SpendKeys.size() == 1) && (p.m_Spent == 1) && p.m_Utxos && p.m_Assets);
 
+		// same in parallel mode
+		{
+			beam::ExecutorMT_Std ex;
+			ex.m_Threads = 3;
+
+			MyParser p2;
+			p2.m_pOwner = p.m_pOwner;
+			p2.m_pExecutor = &ex;
+
+			p2.Proceed(beam::g_sz3);
+			verify_test((p2.m_Utxos == p.m_Utxos) && (p2.m_Assets == p.m_Assets));
+		}
+
 		auto logger = beam::Logger::create(LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG);
 		node.PrintTxos();
 	}
@@ -2936,6 +3078,58 @@ namespace beam
 		}
 	}
 
+	void TestTxPoolConflicts()
+	{
+		TxPool::Fluff txp;
+
+		ECC::Point pt0, pt1;
+		ZeroObject(pt0);
+		ZeroObject(pt1);
+		pt1.m_X.Inc();
+
+		struct Helper
+		{
+			static TxPool::Fluff::Element* Add(TxPool::Fluff& txp, const ECC::Point& pt, Amount fee)
+			{
+				Transaction::Ptr pTx(new Transaction);
+				pTx->m_vInputs.emplace_back(new Input);
+				pTx->m_vInputs.back()->m_Commitment = pt;
+
+				Transaction::Context::Params pars;
+				Transaction::Context ctx(pars);
+				ctx.m_Height.m_Min = Rules::HeightGenesis;
+				ctx.m_Stats.m_Fee = AmountBig::Type(fee);
+
+				Transaction::KeyType key;
+				ECC::GenRandom(key);
+
+				return txp.AddValidTx(std::move(pTx), ctx, key);
+			}
+		};
+
+		TxPool::Fluff::Element* pA = Helper::Add(txp, pt0, 200);
+		TxPool::Fluff::Element* pB = Helper::Add(txp, pt1, 100);
+		verify_test(&txp.get_Worst() == pB);
+
+		// spends the same input, less profitable than A, yet more than B
+		TxPool::Fluff::Element* pC = Helper::Add(txp, pt0, 150);
+		verify_test(&txp.get_Worst() == pC); // outbid
+
+		TxPool::Fluff::Element* pD = Helper::Add(txp, pt0, 300);
+		verify_test(&txp.get_Worst() == pC);
+		verify_test(pA->m_Outbid.m_Count == 1);
+		verify_test(pC->m_Outbid.m_Count == 2);
+
+		txp.Delete(*pD);
+		txp.Delete(*pC);
+		verify_test(!pA->m_Outbid.m_Count);
+		verify_test(&txp.get_Worst() == pB);
+
+		txp.Delete(*pA);
+		verify_test(txp.m_setSpends.size() == 1);
+		verify_test(txp.m_setOutbid.empty());
+	}
+
 }
 
 void TestAll()
@@ -2964,6 +3158,7 @@ void TestAll()
 	{
 		beam::TestHalving();
 		beam::TestChainworkProof();
+		beam::TestTxPoolConflicts();
 	}
 
 	// Make sure this test doesn't run in parallel. We have the following potential collisions for Nodes:
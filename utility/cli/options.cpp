@@ -130,12 +130,14 @@ namespace beam
         const char* PORT = "port";
         const char* PORT_FULL = "port,p";
         const char* STRATUM_PORT = "stratum_port";
+        const char* METRICS_PORT = "metrics_port";
         const char* STRATUM_SECRETS_PATH = "stratum_secrets_path";
         const char* STRATUM_USE_TLS = "stratum_use_tls";
         const char* STORAGE = "storage";
         const char* WALLET_STORAGE = "wallet_path";
         const char* MINING_THREADS = "mining_threads";
         const char* VERIFICATION_THREADS = "verification_threads";
+        const char* WORKER_THREADS = "worker_threads";
         const char* NONCEPREFIX_DIGITS = "nonceprefix_digits";
         const char* NODE_PEER = "peer";
         const char* PASS = "pass";
@@ -165,6 +167,9 @@ namespace beam
         const char* PRINT_TXO = "print_txo";
         const char* CHECKDB = "check_db";
         const char* VACUUM = "vacuum";
+        const char* DB_PROFILE = "db_profile";
+        const char* DB_SLOW_QUERY = "db_slow_query_ms";
+        const char* TX_POOL_SIZE = "tx_pool_size_mb";
         const char* CRASH = "crash";
         const char* INIT = "init";
         const char* RESTORE = "restore";
@@ -202,6 +207,8 @@ namespace beam
         const char* LOG_VERBOSE = "verbose";
         const char* LOG_CLEANUP_DAYS = "log_cleanup_days";
         const char* LOG_UTXOS = "log_utxos";
+        const char* LOG_ASYNC = "log_async";
+        const char* LOG_ASYNC_OVERFLOW = "log_async_overflow";
         const char* VERSION = "version";
         const char* VERSION_FULL = "version,v";
         const char* GIT_COMMIT_HASH = "git_commit_hash";
@@ -330,11 +337,17 @@ namespace beam
             (cli::STRATUM_PORT, po::value<uint16_t>()->default_value(0), "port to start stratum server on")
             (cli::STRATUM_SECRETS_PATH, po::value<string>()->default_value("."), "path to stratum server api keys file, and tls certificate and private key")
             (cli::STRATUM_USE_TLS, po::value<bool>()->default_value(true), "enable TLS on startum server")
+            (cli::METRICS_PORT, po::value<uint16_t>()->default_value(0), "port to serve the Prometheus metrics on (0 = disabled)")
+            (cli::LOG_ASYNC, po::value<bool>()->default_value(false), "write the log on a background thread")
+            (cli::LOG_ASYNC_OVERFLOW, po::value<string>()->default_value("drop"), "asynchronous log, when the queue is full [drop|block]")
             (cli::RESET_ID, po::value<bool>()->default_value(false), "Reset self ID (used for network authentication). Must do if the node is cloned")
             (cli::ERASE_ID, po::value<bool>()->default_value(false), "Reset self ID (used for network authentication) and stop before re-creating the new one.")
             (cli::PRINT_TXO, po::value<bool>()->default_value(false), "Print TXO movements (create/spend) recognized by the owner key.")
             (cli::CHECKDB, po::value<bool>()->default_value(false), "DB integrity check")
             (cli::VACUUM, po::value<bool>()->default_value(false), "DB vacuum (compact)")
+            (cli::DB_PROFILE, po::value<bool>()->default_value(false), "Profile the DB queries, the profile is logged on exit and served with the metrics")
+            (cli::DB_SLOW_QUERY, po::value<uint32_t>()->default_value(0), "Log the DB queries slower than this, in milliseconds (0 = disabled)")
+            (cli::TX_POOL_SIZE, po::value<uint32_t>()->default_value(100), "Maximum total size of the transactions pool, in megabytes")
             (cli::BBS_ENABLE, po::value<bool>()->default_value(true), "Enable SBBS messaging")
             (cli::CRASH, po::value<int>()->default_value(0), "Induce crash (test proper handling)")
             (cli::OWNER_KEY, po::value<string>(), "Owner viewer key")
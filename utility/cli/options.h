@@ -29,12 +29,14 @@ namespace beam
         extern const char* PORT;
         extern const char* PORT_FULL;
         extern const char* STRATUM_PORT;
+        extern const char* METRICS_PORT;
         extern const char* STRATUM_SECRETS_PATH;
         extern const char* STRATUM_USE_TLS;
         extern const char* STORAGE;
         extern const char* WALLET_STORAGE;
         extern const char* MINING_THREADS;
         extern const char* VERIFICATION_THREADS;
+        extern const char* WORKER_THREADS;
         extern const char* NONCEPREFIX_DIGITS;
         extern const char* NODE_PEER;
         extern const char* PASS;
@@ -66,6 +68,9 @@ namespace beam
         extern const char* PRINT_TXO;
         extern const char* CHECKDB;
         extern const char* VACUUM;
+        extern const char* DB_PROFILE;
+        extern const char* DB_SLOW_QUERY;
+        extern const char* TX_POOL_SIZE;
         extern const char* CRASH;
         extern const char* INIT;
         extern const char* RESTORE;
@@ -103,6 +108,8 @@ namespace beam
         extern const char* LOG_VERBOSE;
         extern const char* LOG_CLEANUP_DAYS;
         extern const char* LOG_UTXOS;
+        extern const char* LOG_ASYNC;
+        extern const char* LOG_ASYNC_OVERFLOW;
         extern const char* VERSION;
         extern const char* VERSION_FULL;
         extern const char* GIT_COMMIT_HASH;
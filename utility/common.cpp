@@ -14,6 +14,7 @@
 
 #include "common.h"
 #include "executor.h"
+#include "metrics.h"
 #include <exception>
 
 #ifndef WIN32
@@ -111,6 +112,21 @@ namespace beam
 	// Executor
 	thread_local Executor* Executor::s_pInstance = nullptr;
 
+	namespace
+	{
+		metrics::Gauge& get_QueueDepth()
+		{
+			static metrics::Gauge& s_Gauge = metrics::Registry::get().get_Gauge("beam_executor_queue_depth", "Tasks waiting in the executor queues");
+			return s_Gauge;
+		}
+
+		metrics::Histogram& get_TaskTime()
+		{
+			static metrics::Histogram& s_Hist = metrics::Registry::get().get_Histogram("beam_executor_task_seconds", "Executor task execution time");
+			return s_Hist;
+		}
+	}
+
 	void Executor::Context::get_Portion(uint32_t& i0, uint32_t& nCount, uint32_t nTotal)
 	{
 		uint32_t nThreads = m_pThis->get_Threads();
@@ -162,6 +178,7 @@ namespace beam
 
 		m_queTasks.push_back(*pTask.release());
 		m_InProgress++;
+		get_QueueDepth().Add(1);
 
 		m_NewTask.notify_one();
 	}
@@ -224,6 +241,7 @@ namespace beam
 		{
 			TaskAsync::Ptr pGuard(&m_queTasks.front());
 			m_queTasks.pop_front();
+			get_QueueDepth().Add(-1);
 		}
 	}
 
@@ -248,6 +266,7 @@ namespace beam
 						pGuard.reset(&m_queTasks.front());
 						pTask = pGuard.get();
 						m_queTasks.pop_front();
+						get_QueueDepth().Add(-1);
 						break;
 					}
 
@@ -262,7 +281,10 @@ namespace beam
 			}
 
 			assert(pTask && m_InProgress);
-			pTask->Exec(ctx);
+			{
+				metrics::Timer t(get_TaskTime());
+				pTask->Exec(ctx);
+			}
 
 			std::unique_lock<std::mutex> scope(m_Mutex);
 
@@ -290,6 +312,20 @@ namespace beam
 		}
 	}
 
+	uint32_t ExecutorMT_Std::get_Threads()
+	{
+		if (!m_Threads)
+			m_Threads = std::max(std::thread::hardware_concurrency(), 1U);
+		return m_Threads;
+	}
+
+	void ExecutorMT_Std::RunThread(uint32_t iThread)
+	{
+		Context ctx;
+		ctx.m_iThread = iThread;
+		RunThreadCtx(ctx);
+	}
+
 } // namespace beam
 
 namespace std
@@ -102,4 +102,18 @@ namespace beam
 		void InitSafe();
 		void FlushLocked(std::unique_lock<std::mutex>&, uint32_t nMaxTasks);
 	};
+
+	// ExecutorMT with the plain context
+	struct ExecutorMT_Std
+		:public ExecutorMT
+	{
+		uint32_t m_Threads = 0; // 0 - number of cores
+
+		~ExecutorMT_Std() { Stop(); }
+
+		virtual uint32_t get_Threads() override;
+
+	protected:
+		virtual void RunThread(uint32_t) override;
+	};
 }
@@ -59,6 +59,10 @@ public:
 		return _stream->state().unsent;
 	}
 
+	const io::TcpStream::State& get_State() const {
+		return _stream->state();
+	}
+
 protected:
     /// Ctor. Attaches connected tcp stream
     BaseConnection(Direction d, io::TcpStream::Ptr&& stream) :
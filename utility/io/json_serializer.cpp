@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "json_serializer.h"
+#include "json_writer.h"
 #include "nlohmann/json.hpp"
 #include "utility/logger.h"
 
@@ -55,6 +56,19 @@ bool serialize_json_msg(io::FragmentWriter& packer, const nlohmann::json& o) {
     return result;
 }
 
+bool write_json_msg(io::FragmentWriter& packer, const std::function<void(JsonWriter&)>& fn) {
+    try {
+        JsonWriter w(packer);
+        fn(w);
+        w.finalize();
+    } catch (const std::exception& e) {
+        LOG_ERROR() << "write json: " << e.what();
+        packer.finalize();
+        return false;
+    }
+    return true;
+}
+
 } //namespace
 
 
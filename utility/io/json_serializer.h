@@ -15,11 +15,17 @@
 #pragma once
 #include "utility/io/fragment_writer.h"
 #include "nlohmann/json_fwd.hpp"
+#include <functional>
 
 namespace beam {
 
+class JsonWriter;
+
 // appends json msg to out by fragment writer
 bool serialize_json_msg(io::FragmentWriter& packer, const nlohmann::json& o);
 
+// appends json msg written by the streaming writer, w/o building the DOM
+bool write_json_msg(io::FragmentWriter& packer, const std::function<void(JsonWriter&)>& fn);
+
 } //namespace
 
@@ -0,0 +1,245 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "json_writer.h"
+#include "nlohmann/json.hpp"
+#include <assert.h>
+#include <cmath>
+
+namespace beam {
+
+namespace {
+
+    // all the byte values, 2 chars each
+    struct HexTable {
+        char pairs[512];
+
+        HexTable() {
+            static const char digits[] = "0123456789abcdef";
+            for (int i = 0; i < 256; i++) {
+                pairs[i * 2] = digits[i >> 4];
+                pairs[i * 2 + 1] = digits[i & 0xf];
+            }
+        }
+    };
+
+    const HexTable g_Hex;
+
+    struct JsonOutputAdapter : nlohmann::detail::output_adapter_protocol<char> {
+        JsonOutputAdapter(io::FragmentWriter& _fw) : fw(_fw) {}
+
+        void write_character(char c) override {
+            fw.write(&c, 1);
+        }
+
+        void write_characters(const char* s, std::size_t length) override {
+            fw.write(s, length);
+        }
+
+        io::FragmentWriter& fw;
+    };
+
+} //namespace
+
+JsonWriter::JsonWriter(io::FragmentWriter& fw) : _fw(fw)
+{}
+
+void JsonWriter::separate() {
+    if (_afterKey) {
+        _afterKey = false;
+        return;
+    }
+
+    if (!_depth) return;
+
+    uint64_t msk = 1ULL << (_depth - 1);
+    if (_nonEmpty & msk) {
+        write(',');
+    } else {
+        _nonEmpty |= msk;
+    }
+}
+
+JsonWriter& JsonWriter::begin_object() {
+    separate();
+    write('{');
+
+    assert(_depth < s_MaxDepth);
+    _nonEmpty &= ~(1ULL << _depth);
+    _depth++;
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+    assert(_depth && !_afterKey);
+    _depth--;
+    write('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+    separate();
+    write('[');
+
+    assert(_depth < s_MaxDepth);
+    _nonEmpty &= ~(1ULL << _depth);
+    _depth++;
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+    assert(_depth && !_afterKey);
+    _depth--;
+    write(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    assert(_depth && !_afterKey);
+    separate();
+    write_string(name);
+    write(':');
+    _afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view s) {
+    separate();
+    write_string(s);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+    separate();
+    write(b ? std::string_view("true") : std::string_view("false"));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double d) {
+    separate();
+
+    if (!std::isfinite(d)) {
+        write("null");
+        return *this;
+    }
+
+    char buf[64];
+    char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), d);
+    write(std::string_view(buf, end - buf));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const nlohmann::json& j) {
+    separate();
+
+    nlohmann::detail::serializer<nlohmann::json> s(std::make_shared<JsonOutputAdapter>(_fw), ' ');
+    s.dump(j, false, false, 0);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value_uint(uint64_t n) {
+    separate();
+
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = '0' + static_cast<char>(n % 10);
+        n /= 10;
+    } while (n);
+
+    write(std::string_view(p, buf + sizeof(buf) - p));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value_int(int64_t n) {
+    if (n >= 0) return value_uint(static_cast<uint64_t>(n));
+
+    separate();
+    write('-');
+
+    _afterKey = true; // suppress the separator
+    return value_uint(0 - static_cast<uint64_t>(n));
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    write("null");
+    return *this;
+}
+
+JsonWriter& JsonWriter::hex(const void* p, size_t size) {
+    separate();
+    write('"');
+
+    const uint8_t* src = static_cast<const uint8_t*>(p);
+
+    char buf[128];
+    while (size) {
+        size_t n = std::min(size, sizeof(buf) / 2);
+        for (size_t i = 0; i < n; i++) {
+            const char* x = g_Hex.pairs + src[i] * 2;
+            buf[i * 2] = x[0];
+            buf[i * 2 + 1] = x[1];
+        }
+
+        _fw.write(buf, n * 2);
+        src += n;
+        size -= n;
+    }
+
+    write('"');
+    return *this;
+}
+
+void JsonWriter::write_string(std::string_view s) {
+    write('"');
+
+    size_t i0 = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        uint8_t c = static_cast<uint8_t>(s[i]);
+        if ((c >= 0x20) && (c != '"') && (c != '\\'))
+            continue;
+
+        _fw.write(s.data() + i0, i - i0);
+        i0 = i + 1;
+
+        switch (c) {
+        case '"': write("\\\""); break;
+        case '\\': write("\\\\"); break;
+        case '\b': write("\\b"); break;
+        case '\f': write("\\f"); break;
+        case '\n': write("\\n"); break;
+        case '\r': write("\\r"); break;
+        case '\t': write("\\t"); break;
+        default:
+            {
+                char buf[6] = { '\\', 'u', '0', '0' };
+                buf[4] = g_Hex.pairs[c * 2];
+                buf[5] = g_Hex.pairs[c * 2 + 1];
+                _fw.write(buf, sizeof(buf));
+            }
+        }
+    }
+
+    _fw.write(s.data() + i0, s.size() - i0);
+    write('"');
+}
+
+void JsonWriter::finalize() {
+    assert(!_depth);
+    write('\n'); // for stratum
+    _fw.finalize();
+}
+
+} //namespace
@@ -0,0 +1,87 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "utility/io/fragment_writer.h"
+#include "nlohmann/json_fwd.hpp"
+#include <string_view>
+#include <type_traits>
+
+namespace beam {
+
+/// Streaming (SAX-style) json writer. Appends straight into the fragments, w/o building the DOM.
+/// Commas and separators are inserted automatically, the structure is up to the caller.
+/// The output is the same as of the compact nlohmann dump
+class JsonWriter {
+public:
+    explicit JsonWriter(io::FragmentWriter& fw);
+
+    JsonWriter& begin_object();
+    JsonWriter& end_object();
+    JsonWriter& begin_array();
+    JsonWriter& end_array();
+
+    /// Object member name, must be followed by a value
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view s);
+    JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+    JsonWriter& value(const std::string& s) { return value(std::string_view(s)); }
+    JsonWriter& value(bool b);
+    JsonWriter& value(double d);
+    JsonWriter& value(const nlohmann::json& j); // for small nested documents
+
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>, JsonWriter&> value(T n) {
+        if constexpr (std::is_signed_v<T>)
+            return value_int(static_cast<int64_t>(n));
+        else
+            return value_uint(static_cast<uint64_t>(n));
+    }
+
+    JsonWriter& null();
+
+    /// Quoted lower-case hex
+    JsonWriter& hex(const void* p, size_t size);
+
+    template <typename T>
+    JsonWriter& hex(const T& x) { return hex(x.m_pData, x.nBytes); }
+
+    template <typename T>
+    JsonWriter& member(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    /// Ends the message the same way as serialize_json_msg does: eol, and the fragment is released
+    void finalize();
+
+private:
+    JsonWriter& value_int(int64_t n);
+    JsonWriter& value_uint(uint64_t n);
+
+    void separate();
+    void write(char c) { _fw.write(&c, 1); }
+    void write(std::string_view s) { _fw.write(s.data(), s.size()); }
+    void write_string(std::string_view s);
+
+    static const uint32_t s_MaxDepth = 64;
+
+    io::FragmentWriter& _fw;
+    uint64_t _nonEmpty = 0; // bit per nesting level
+    uint32_t _depth = 0;
+    bool _afterKey = false;
+};
+
+} //namespace
@@ -34,6 +34,10 @@
 #include <iostream>
 #include <fstream>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include <algorithm>
 
 namespace beam {
@@ -108,6 +112,10 @@ public:
         return level >= _minLevel;
     }
 
+    void write(const LogMessageHeader& header, const char* buf, size_t size) {
+        write_message(header, buf, size);
+    }
+
     void write_impl(int level, const char* header, size_t headerSize, const char* msg, size_t size) {
         if (!_sink) return; 
         lock_guard<mutex> lock(_mutex);
@@ -251,6 +259,300 @@ public:
     }
 };
 
+namespace {
+
+LoggerImpl* create_sink(int flushLevel, int consoleLevel, int fileLevel, const std::string& fileNamePrefix, const std::string& dstPath) {
+    int what = 0;
+
+    if (consoleLevel > 0) what += 1;
+    if (fileLevel > 0) what += 2;
+
+    switch (what) {
+        case 3:
+            return new CombinedLogger(flushLevel, consoleLevel, fileLevel, fileNamePrefix, dstPath);
+        case 2:
+            return new FileLogger(flushLevel, fileLevel, fileNamePrefix, dstPath);
+        case 1:
+            return new ConsoleLogger(flushLevel, consoleLevel);
+        default:
+            throw runtime_error("no logger sink configured");
+    }
+}
+
+/// Single producer (the thread that logs), single consumer (the writer thread).
+/// Records are [size][header][text], wrapped around the buffer
+class LogRing {
+public:
+    explicit LogRing(size_t minSize) {
+        size_t size = 4096;
+        while (size < minSize) size <<= 1;
+        _data.resize(size);
+        _mask = size - 1;
+    }
+
+    /// Producer. false if there's no room
+    bool push(const LogMessageHeader& header, const char* msg, size_t size) {
+        // a message that can't fit is truncated, so that it doesn't block forever
+        size_t maxSize = _data.size() / 4;
+        bool truncated = (size > maxSize);
+        if (truncated) size = maxSize;
+
+        uint32_t size32 = static_cast<uint32_t>(size);
+        size_t total = sizeof(size32) + sizeof(header) + size;
+
+        size_t head = _head.load(memory_order_relaxed);
+        if (_data.size() - (head - _tail.load(memory_order_acquire)) < total) return false;
+
+        copy_in(head, &size32, sizeof(size32));
+        head += sizeof(size32);
+        copy_in(head, &header, sizeof(header));
+        head += sizeof(header);
+
+        if (truncated) {
+            copy_in(head, msg, size - 1);
+            copy_in(head + size - 1, "\n", 1);
+        } else {
+            copy_in(head, msg, size);
+        }
+
+        _head.store(head + size, memory_order_release);
+        return true;
+    }
+
+    struct Record {
+        LogMessageHeader header;
+        size_t offset; // in the batch text
+        size_t size;
+    };
+
+    /// Consumer. Appends all the queued records
+    void pop_all(vector<Record>& records, string& text) {
+        size_t tail = _tail.load(memory_order_relaxed);
+        size_t head = _head.load(memory_order_acquire);
+
+        while (tail != head) {
+            uint32_t size32 = 0;
+            copy_out(tail, &size32, sizeof(size32));
+            tail += sizeof(size32);
+
+            alignas(LogMessageHeader) char header[sizeof(LogMessageHeader)];
+            copy_out(tail, header, sizeof(header));
+            tail += sizeof(header);
+
+            size_t offset = text.size();
+            text.resize(offset + size32);
+            copy_out(tail, &text[offset], size32);
+            tail += size32;
+
+            records.push_back(Record{ *reinterpret_cast<const LogMessageHeader*>(header), offset, size32 });
+        }
+
+        _tail.store(tail, memory_order_release);
+    }
+
+    bool empty() const {
+        return _head.load(memory_order_acquire) == _tail.load(memory_order_relaxed);
+    }
+
+    bool half_full() const {
+        return (_head.load(memory_order_relaxed) - _tail.load(memory_order_relaxed)) * 2 >= _data.size();
+    }
+
+    atomic<uint64_t> dropped{0};
+    atomic<bool> orphaned{false}; // the thread is gone
+
+private:
+    void copy_in(size_t pos, const void* p, size_t size) {
+        size_t i = pos & _mask;
+        size_t n = std::min(size, _data.size() - i);
+        memcpy(&_data[i], p, n);
+        memcpy(&_data[0], static_cast<const char*>(p) + n, size - n);
+    }
+
+    void copy_out(size_t pos, void* p, size_t size) const {
+        size_t i = pos & _mask;
+        size_t n = std::min(size, _data.size() - i);
+        memcpy(p, &_data[i], n);
+        memcpy(static_cast<char*>(p) + n, &_data[0], size - n);
+    }
+
+    vector<char> _data;
+    size_t _mask;
+    alignas(64) atomic<size_t> _head{0}; // written by the producer
+    alignas(64) atomic<size_t> _tail{0}; // consumed by the writer
+};
+
+atomic<uint64_t> g_lastAsyncLogger(0);
+
+struct LogRingRef {
+    uint64_t loggerId = 0;
+    shared_ptr<LogRing> ring;
+
+    ~LogRingRef() {
+        if (ring) ring->orphaned = true;
+    }
+};
+
+thread_local LogRingRef t_logRing;
+
+} //namespace
+
+/// Formats the headers and writes to the sink on its own thread, the messages are passed via per-thread rings
+class AsyncLogger : public Logger {
+    static const unsigned WRITE_PERIOD_MSEC = 100;
+
+    unique_ptr<Logger> _sinkHolder;
+    LoggerImpl* _sink;
+    const int _flushLevel;
+    const size_t _queueSize;
+    const LoggerConfig::Overflow _overflow;
+    const uint64_t _id;
+
+    mutex _mutex;
+    condition_variable _cv;
+    vector<shared_ptr<LogRing>> _rings;
+    atomic<bool> _signaled{false};
+    atomic<bool> _stop{false};
+    thread _thread;
+
+public:
+    AsyncLogger(LoggerImpl* sink, const LoggerConfig& cfg) :
+        _sinkHolder(sink),
+        _sink(sink),
+        _flushLevel(cfg.flushLevel),
+        _queueSize(cfg.asyncQueueSize),
+        _overflow(cfg.asyncOverflow),
+        _id(++g_lastAsyncLogger)
+    {
+        _thread = thread(&AsyncLogger::run, this);
+    }
+
+    ~AsyncLogger() {
+        if (this == g_logger) {
+            g_logger = 0;
+        }
+
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_one();
+        _thread.join();
+    }
+
+    void set_header_formatter(LogMessageHeaderFormatter formatter) override {
+        _sinkHolder->set_header_formatter(formatter);
+    }
+
+    void set_time_format(const char* format, bool printMilliseconds) override {
+        _sinkHolder->set_time_format(format, printMilliseconds);
+    }
+
+    const FileNameType& get_current_file_name() override {
+        return _sinkHolder->get_current_file_name();
+    }
+
+    // The file is switched right away, so that the caller gets the new name. The messages still queued go to the new file
+    void rotate() override {
+        _sink->rotate();
+    }
+
+protected:
+    bool level_accepted(int level) override {
+        return _sink->level_accepted(level);
+    }
+
+    void write_message(const LogMessageHeader& header, const char* buf, size_t size) override {
+        LogRing& ring = get_ring();
+
+        while (!ring.push(header, buf, size)) {
+            if (_overflow == LoggerConfig::drop || _stop) {
+                ring.dropped.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            wakeup();
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+
+        if (header.level >= _flushLevel || ring.half_full()) {
+            wakeup();
+        }
+    }
+
+private:
+    LogRing& get_ring() {
+        if (t_logRing.loggerId != _id) {
+            auto ring = make_shared<LogRing>(_queueSize);
+            {
+                lock_guard<mutex> lock(_mutex);
+                _rings.push_back(ring);
+            }
+            if (t_logRing.ring) t_logRing.ring->orphaned = true;
+            t_logRing.ring = std::move(ring);
+            t_logRing.loggerId = _id;
+        }
+        return *t_logRing.ring;
+    }
+
+    void wakeup() {
+        // no lock, a lost wakeup only delays the write until the next period
+        if (!_signaled.exchange(true, memory_order_relaxed)) {
+            _cv.notify_one();
+        }
+    }
+
+    void run() {
+        vector<shared_ptr<LogRing>> rings;
+        vector<LogRing::Record> records;
+        string text;
+
+        for (bool stop = false; !stop; ) {
+            {
+                unique_lock<mutex> lock(_mutex);
+                _cv.wait_for(lock, chrono::milliseconds(WRITE_PERIOD_MSEC), [this] {
+                    return _stop || _signaled.load(memory_order_relaxed);
+                });
+                _signaled.store(false, memory_order_relaxed);
+                stop = _stop;
+
+                _rings.erase(
+                    remove_if(_rings.begin(), _rings.end(), [](const shared_ptr<LogRing>& r) { return r->orphaned && r->empty(); }),
+                    _rings.end()
+                );
+                rings = _rings;
+            }
+
+            uint64_t dropped = 0;
+            for (const auto& r : rings) {
+                r->pop_all(records, text);
+                dropped += r->dropped.exchange(0, memory_order_relaxed);
+            }
+
+            // in order within a thread, by time (msec) across the threads
+            stable_sort(records.begin(), records.end(), [](const LogRing::Record& a, const LogRing::Record& b) {
+                return a.header.timestamp < b.header.timestamp;
+            });
+
+            for (const auto& rec : records) {
+                _sink->write(rec.header, text.data() + rec.offset, rec.size);
+            }
+
+            if (dropped) {
+                LogMessageHeader header(LOG_LEVEL_WARNING, 0, 0, 0);
+                string msg = "logger: " + to_string(dropped) + " messages dropped, queue overflow\n";
+                _sink->write(header, msg.data(), msg.size());
+            }
+
+            records.clear();
+            if (text.capacity() > 4 * _queueSize) {
+                string().swap(text);
+            } else {
+                text.clear();
+            }
+        }
+    }
+};
+
 std::shared_ptr<Logger> Logger::create(
     int flushLevel,
     int consoleLevel,
@@ -262,27 +564,26 @@ std::shared_ptr<Logger> Logger::create(
         throw runtime_error("logger already initialized");
     }
 
-    std::shared_ptr<Logger> logger;
+    std::shared_ptr<Logger> logger(static_cast<Logger*>(create_sink(flushLevel, consoleLevel, fileLevel, fileNamePrefix, dstPath)));
 
-    int what = 0;
+    g_logger = logger.get();
+    return logger;
+}
 
-    if (consoleLevel > 0) what += 1;
-    if (fileLevel > 0) what += 2;
+std::shared_ptr<Logger> Logger::create(const LoggerConfig& cfg) {
+    if (!cfg.async) {
+        return create(cfg.flushLevel, cfg.consoleLevel, cfg.fileLevel, cfg.filePrefix, cfg.filePath);
+    }
 
-    switch (what) {
-        case 3:
-            logger.reset(new CombinedLogger(flushLevel, consoleLevel, fileLevel, fileNamePrefix, dstPath));
-            break;
-        case 2:
-            logger.reset(new FileLogger(flushLevel, fileLevel, fileNamePrefix, dstPath));
-            break;
-        case 1:
-            logger.reset(new ConsoleLogger(flushLevel, consoleLevel));
-            break;
-        default:
-            throw runtime_error("no logger sink configured");
+    if (g_logger) {
+        throw runtime_error("logger already initialized");
     }
 
+    std::shared_ptr<Logger> logger(new AsyncLogger(
+        create_sink(cfg.flushLevel, cfg.consoleLevel, cfg.fileLevel, cfg.filePrefix, cfg.filePath),
+        cfg
+    ));
+
     g_logger = logger.get();
     return logger;
 }
@@ -95,6 +95,18 @@ struct LoggerConfig {
     int consoleLevel=LOG_LEVEL_DEBUG;
     int flushLevel=LOG_LEVEL_WARNING;
     std::string filePrefix;
+    std::string filePath;
+
+    // Asynchronous mode: the messages are queued per thread without locking and written by a background thread.
+    // Queued messages are written on a message with level >= flushLevel, when a queue is half full, or periodically
+    bool async=false;
+
+    // Queue size per thread that logs, bytes
+    size_t asyncQueueSize=256*1024;
+
+    // When a queue is full: drop the message (the writer reports the number dropped) or wait for the writer
+    enum Overflow { drop, block };
+    Overflow asyncOverflow=drop;
 
     // ~etc rotation
 };
@@ -147,6 +159,9 @@ public:
         const std::string& dstPath = std::string()
     );
 
+    /// RAII
+    static std::shared_ptr<Logger> create(const LoggerConfig& cfg);
+
     virtual ~Logger() {}
 
     /// Sets custom msg header formatter, default is def_header_formatter
@@ -0,0 +1,287 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "metrics.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace beam {
+namespace metrics
+{
+	namespace
+	{
+		std::atomic<bool> g_Enabled(false);
+		std::atomic<uint32_t> g_NextShard(0);
+	}
+
+	uint32_t get_Shard()
+	{
+		static thread_local uint32_t s_iShard = g_NextShard.fetch_add(1, std::memory_order_relaxed) % s_Shards;
+		return s_iShard;
+	}
+
+	bool IsEnabled()
+	{
+		return g_Enabled.load(std::memory_order_relaxed);
+	}
+
+	void Enable(bool b)
+	{
+		g_Enabled.store(b, std::memory_order_relaxed);
+	}
+
+	/////////////////////////////
+	// Counter
+	uint64_t Counter::get() const
+	{
+		uint64_t val = 0;
+		for (uint32_t i = 0; i < s_Shards; i++)
+			val += m_pShards[i].m_Value.load(std::memory_order_relaxed);
+		return val;
+	}
+
+	/////////////////////////////
+	// Histogram
+	Histogram::Shard::Shard()
+	{
+		for (uint32_t i = 0; i <= s_Buckets; i++)
+			m_pBuckets[i].store(0, std::memory_order_relaxed);
+		m_Sum.store(0, std::memory_order_relaxed);
+	}
+
+	uint32_t Histogram::get_Bucket(uint64_t x)
+	{
+		// smallest i such that x <= 2^i
+		uint32_t i = 0;
+		for (x = x ? (x - 1) : 0; x; x >>= 1)
+			i++;
+		return std::min(i, s_Buckets);
+	}
+
+	void Histogram::Observe(uint64_t x)
+	{
+		Shard& s = m_pShards[get_Shard()];
+		s.m_pBuckets[get_Bucket(x)].fetch_add(1, std::memory_order_relaxed);
+		s.m_Sum.fetch_add(x, std::memory_order_relaxed);
+	}
+
+	void Histogram::get(Snapshot& res) const
+	{
+		res.m_Count = 0;
+		res.m_Sum = 0;
+
+		for (uint32_t iBucket = 0; iBucket <= s_Buckets; iBucket++)
+		{
+			uint64_t val = 0;
+			for (uint32_t i = 0; i < s_Shards; i++)
+				val += m_pShards[i].m_pBuckets[iBucket].load(std::memory_order_relaxed);
+
+			res.m_pBuckets[iBucket] = val;
+			res.m_Count += val;
+		}
+
+		for (uint32_t i = 0; i < s_Shards; i++)
+			res.m_Sum += m_pShards[i].m_Sum.load(std::memory_order_relaxed);
+	}
+
+	uint64_t Timer::get_Elapsed() const
+	{
+		auto dt = std::chrono::steady_clock::now() - m_t0;
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(dt).count());
+	}
+
+	/////////////////////////////
+	// Writer
+	void Writer::Header(const char* szName, const char* szHelp, const char* szType)
+	{
+		m_Out += "# HELP ";
+		m_Out += szName;
+		m_Out += ' ';
+		m_Out += szHelp;
+		m_Out += "\n# TYPE ";
+		m_Out += szName;
+		m_Out += ' ';
+		m_Out += szType;
+		m_Out += '\n';
+	}
+
+	void Writer::Value(const char* szName, const std::string& sLabels, uint64_t x)
+	{
+		m_Out += szName;
+		if (!sLabels.empty())
+		{
+			m_Out += '{';
+			m_Out += sLabels;
+			m_Out += '}';
+		}
+		m_Out += ' ';
+		m_Out += std::to_string(x);
+		m_Out += '\n';
+	}
+
+	void Writer::Value(const char* szName, const std::string& sLabels, int64_t x)
+	{
+		if (x >= 0)
+			Value(szName, sLabels, static_cast<uint64_t>(x));
+		else
+			Value(szName, sLabels, static_cast<double>(x));
+	}
+
+	void Writer::Value(const char* szName, const std::string& sLabels, double x)
+	{
+		m_Out += szName;
+		if (!sLabels.empty())
+		{
+			m_Out += '{';
+			m_Out += sLabels;
+			m_Out += '}';
+		}
+
+		char sz[32];
+		snprintf(sz, sizeof(sz), " %.9g\n", x);
+		m_Out += sz;
+	}
+
+	void Writer::Write(const char* szName, const std::string& sLabels, const Histogram& h)
+	{
+		Histogram::Snapshot s;
+		h.get(s);
+
+		std::string sName = szName;
+		std::string sPrefix = sLabels.empty() ? sLabels : (sLabels + ',');
+
+		uint64_t nCumulative = 0;
+		for (uint32_t i = 0; i < Histogram::s_Buckets; i++)
+		{
+			nCumulative += s.m_pBuckets[i];
+
+			char sz[32];
+			snprintf(sz, sizeof(sz), "le=\"%.9g\"", static_cast<double>(uint64_t(1) << i) * h.m_kScale);
+			Value((sName + "_bucket").c_str(), sPrefix + sz, nCumulative);
+		}
+
+		Value((sName + "_bucket").c_str(), sPrefix + "le=\"+Inf\"", s.m_Count);
+		Value((sName + "_sum").c_str(), sLabels, static_cast<double>(s.m_Sum) * h.m_kScale);
+		Value((sName + "_count").c_str(), sLabels, s.m_Count);
+	}
+
+	std::string Writer::Label(const char* szKey, const std::string& sValue)
+	{
+		std::string sRes = szKey;
+		sRes += "=\"";
+
+		for (char c : sValue)
+		{
+			switch (c)
+			{
+			case '\\': sRes += "\\\\"; break;
+			case '"': sRes += "\\\""; break;
+			case '\n': sRes += "\\n"; break;
+			default: sRes += c;
+			}
+		}
+
+		sRes += '"';
+		return sRes;
+	}
+
+	/////////////////////////////
+	// Registry
+	Registry& Registry::get()
+	{
+		static Registry s_Instance;
+		return s_Instance;
+	}
+
+	Registry::Family& Registry::get_Family(const char* szName, const char* szHelp, const char* szType)
+	{
+		Family& f = m_Families[szName];
+		if (f.m_sHelp.empty())
+		{
+			f.m_sHelp = szHelp;
+			f.m_szType = szType;
+		}
+		return f;
+	}
+
+	Counter& Registry::get_Counter(const char* szName, const char* szHelp, const std::string& sLabels /* = "" */)
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+
+		auto& p = get_Family(szName, szHelp, "counter").m_Counters[sLabels];
+		if (!p)
+			p = std::make_unique<Counter>();
+		return *p;
+	}
+
+	Gauge& Registry::get_Gauge(const char* szName, const char* szHelp, const std::string& sLabels /* = "" */)
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+
+		auto& p = get_Family(szName, szHelp, "gauge").m_Gauges[sLabels];
+		if (!p)
+			p = std::make_unique<Gauge>();
+		return *p;
+	}
+
+	Histogram& Registry::get_Histogram(const char* szName, const char* szHelp, const std::string& sLabels /* = "" */, double kScale /* = 1e-6 */)
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+
+		auto& p = get_Family(szName, szHelp, "histogram").m_Histograms[sLabels];
+		if (!p)
+			p = std::make_unique<Histogram>(kScale);
+		return *p;
+	}
+
+	uint32_t Registry::AddCollector(Collector&& c)
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+
+		uint32_t id = ++m_LastCollector;
+		m_Collectors[id] = std::move(c);
+		return id;
+	}
+
+	void Registry::RemoveCollector(uint32_t id)
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+		m_Collectors.erase(id);
+	}
+
+	void Registry::Write(std::string& out)
+	{
+		Enable(true); // someone is interested
+
+		Writer w(out);
+		std::unique_lock<std::mutex> scope(m_Mutex);
+
+		for (const auto& [sName, f] : m_Families)
+		{
+			w.Header(sName.c_str(), f.m_sHelp.c_str(), f.m_szType);
+
+			for (const auto& [sLabels, p] : f.m_Counters)
+				w.Value(sName.c_str(), sLabels, p->get());
+			for (const auto& [sLabels, p] : f.m_Gauges)
+				w.Value(sName.c_str(), sLabels, p->get());
+			for (const auto& [sLabels, p] : f.m_Histograms)
+				w.Write(sName.c_str(), sLabels, *p);
+		}
+
+		for (const auto& [id, c] : m_Collectors)
+			c(w);
+	}
+
+} // namespace metrics
+} // namespace beam
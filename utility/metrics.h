@@ -0,0 +1,171 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace beam {
+namespace metrics
+{
+	// Counters and histograms are updated with relaxed atomics, sharded so that the threads don't share cache lines.
+	// The shards are summed only on a scrape. Timing (the clock reads) is off until the first scrape.
+
+	static const uint32_t s_Shards = 8;
+	uint32_t get_Shard(); // of the calling thread
+
+	bool IsEnabled();
+	void Enable(bool);
+
+	struct alignas(64) Counter
+	{
+		void Inc(uint64_t n = 1) {
+			m_pShards[get_Shard()].m_Value.fetch_add(n, std::memory_order_relaxed);
+		}
+
+		uint64_t get() const;
+
+	private:
+		struct alignas(64) Shard {
+			std::atomic<uint64_t> m_Value{ 0 };
+		};
+		Shard m_pShards[s_Shards];
+	};
+
+	struct alignas(64) Gauge
+	{
+		void Set(int64_t x) { m_Value.store(x, std::memory_order_relaxed); }
+		void Add(int64_t x) { m_Value.fetch_add(x, std::memory_order_relaxed); }
+		int64_t get() const { return m_Value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<int64_t> m_Value{ 0 };
+	};
+
+	// Power-of-2 buckets: i-th is for values up to 2^i, the last one is +Inf
+	struct alignas(64) Histogram
+	{
+		static const uint32_t s_Buckets = 28;
+
+		Histogram(double kScale = 1.) :m_kScale(kScale) {}
+
+		void Observe(uint64_t);
+
+		struct Snapshot
+		{
+			uint64_t m_pBuckets[s_Buckets + 1]; // not cumulative
+			uint64_t m_Count;
+			uint64_t m_Sum;
+		};
+
+		void get(Snapshot&) const;
+
+		const double m_kScale; // for the exposition, i.e. 1e-6 for values in microseconds and metric in seconds
+
+		static uint32_t get_Bucket(uint64_t);
+
+	private:
+		struct alignas(64) Shard {
+			std::atomic<uint64_t> m_pBuckets[s_Buckets + 1];
+			std::atomic<uint64_t> m_Sum;
+			Shard();
+		};
+		Shard m_pShards[s_Shards];
+	};
+
+	// Observes the elapsed microseconds, if enabled
+	struct Timer
+	{
+		Histogram& m_Hist;
+		std::chrono::steady_clock::time_point m_t0;
+		bool m_Active;
+
+		Timer(Histogram& h)
+			:m_Hist(h)
+			,m_Active(IsEnabled())
+		{
+			if (m_Active)
+				m_t0 = std::chrono::steady_clock::now();
+		}
+
+		~Timer() {
+			if (m_Active)
+				m_Hist.Observe(get_Elapsed());
+		}
+
+		uint64_t get_Elapsed() const; // microseconds
+	};
+
+	// Text exposition format
+	struct Writer
+	{
+		std::string& m_Out;
+		Writer(std::string& out) :m_Out(out) {}
+
+		void Header(const char* szName, const char* szHelp, const char* szType);
+		void Value(const char* szName, const std::string& sLabels, uint64_t);
+		void Value(const char* szName, const std::string& sLabels, int64_t);
+		void Value(const char* szName, const std::string& sLabels, double);
+		void Write(const char* szName, const std::string& sLabels, const Histogram&);
+
+		static std::string Label(const char* szKey, const std::string& sValue); // escaped
+	};
+
+	class Registry
+	{
+	public:
+		static Registry& get();
+
+		// Get-or-create. The metrics are never deleted, the references are stable.
+		// sLabels is the inner part of the label set, i.e. phase="commit"
+		Counter& get_Counter(const char* szName, const char* szHelp, const std::string& sLabels = "");
+		Gauge& get_Gauge(const char* szName, const char* szHelp, const std::string& sLabels = "");
+		Histogram& get_Histogram(const char* szName, const char* szHelp, const std::string& sLabels = "", double kScale = 1e-6);
+
+		// Called on each scrape, for the values that are cheaper to read than to track (pool sizes, peers).
+		// Invoked on the thread that serves the scrape, the owner must make sure it's safe. Must not register metrics
+		typedef std::function<void(Writer&)> Collector;
+		uint32_t AddCollector(Collector&&);
+		void RemoveCollector(uint32_t);
+
+		void Write(std::string& out);
+
+	private:
+		struct Family
+		{
+			std::string m_sHelp;
+			const char* m_szType;
+			std::map<std::string, std::unique_ptr<Counter> > m_Counters;
+			std::map<std::string, std::unique_ptr<Gauge> > m_Gauges;
+			std::map<std::string, std::unique_ptr<Histogram> > m_Histograms;
+		};
+
+		Family& get_Family(const char* szName, const char* szHelp, const char* szType);
+
+		std::mutex m_Mutex;
+		std::map<std::string, Family> m_Families;
+		std::map<uint32_t, Collector> m_Collectors;
+		uint32_t m_LastCollector = 0;
+	};
+
+} // namespace metrics
+} // namespace beam
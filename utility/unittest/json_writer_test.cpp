@@ -0,0 +1,248 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "utility/io/json_writer.h"
+#include "utility/io/json_serializer.h"
+#include "utility/test_helpers.h"
+#include "nlohmann/json.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <new>
+
+using namespace beam;
+using namespace std;
+using nlohmann::json;
+
+namespace {
+
+// allocations made by the test, for the benchmark
+std::atomic<uint64_t> g_Allocs(0);
+std::atomic<uint64_t> g_AllocBytes(0);
+
+int g_failures = 0;
+
+#define CHECK(x) if (!(x)) { cerr << "FAILED: " #x " at line " << __LINE__ << endl; ++g_failures; }
+
+const size_t FRAGMENT_SIZE = 4096;
+
+struct Output {
+    io::SerializedMsg sm;
+    io::FragmentWriter fw;
+
+    Output() : fw(FRAGMENT_SIZE, 0, [this](io::SharedBuffer&& fragment) { sm.push_back(std::move(fragment)); }) {}
+
+    string str() {
+        io::SharedBuffer buf = io::normalize(sm, false);
+        return string((const char*)buf.data, buf.size);
+    }
+};
+
+string write(const std::function<void(JsonWriter&)>& fn) {
+    Output out;
+    CHECK(write_json_msg(out.fw, fn));
+    return out.str();
+}
+
+string dump(const json& j) {
+    Output out;
+    CHECK(serialize_json_msg(out.fw, j));
+    return out.str();
+}
+
+void test_values() {
+    CHECK(write([](JsonWriter& w) { w.begin_object().end_object(); }) == "{}\n");
+    CHECK(write([](JsonWriter& w) { w.begin_array().end_array(); }) == "[]\n");
+
+    json j = {
+        { "i", -12345 },
+        { "min", numeric_limits<int64_t>::min() },
+        { "max", numeric_limits<uint64_t>::max() },
+        { "zero", 0 },
+        { "d", 0.1 },
+        { "d2", 1e300 },
+        { "d3", -3.0 },
+        { "t", true },
+        { "f", false },
+        { "n", nullptr },
+        { "s", "a\"b\\c\b\f\n\r\t\x01\x1f end" },
+        { "utf", "\xd0\xbf\xd1\x80\xd0\xb8" },
+        { "arr", { 1, json::array(), json::object(), "x" } },
+        { "obj", { { "a", { { "b", json::array({ 1, 2 }) } } } } }
+    };
+
+    string s = write([](JsonWriter& w) {
+        // in the alphabetical order, as the DOM dumps them
+        w.begin_object();
+        w.key("arr").begin_array().value(1).begin_array().end_array().begin_object().end_object().value("x").end_array();
+        w.member("d", 0.1);
+        w.member("d2", 1e300);
+        w.member("d3", -3.0);
+        w.member("f", false);
+        w.member("i", -12345);
+        w.member("max", numeric_limits<uint64_t>::max());
+        w.member("min", numeric_limits<int64_t>::min());
+        w.key("n").null();
+        w.key("obj").begin_object().key("a").begin_object().key("b").begin_array().value(1).value(2).end_array().end_object().end_object();
+        w.member("s", "a\"b\\c\b\f\n\r\t\x01\x1f end");
+        w.member("t", true);
+        w.member("utf", "\xd0\xbf\xd1\x80\xd0\xb8");
+        w.member("zero", 0u);
+        w.end_object();
+    });
+
+    CHECK(s == dump(j));
+
+    // embedded DOM
+    CHECK(write([&j](JsonWriter& w) { w.begin_array().value(j).value(j["obj"]).end_array(); }) == dump(json::array({ j, j["obj"] })));
+}
+
+void test_hex() {
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = static_cast<uint8_t>(i * 7);
+
+    string expected = "[\"";
+    static const char digits[] = "0123456789abcdef";
+    for (uint8_t x : data) {
+        expected += digits[x >> 4];
+        expected += digits[x & 0xf];
+    }
+    expected += "\",\"\"]\n";
+
+    CHECK(write([&data](JsonWriter& w) { w.begin_array().hex(data, sizeof(data)).hex(data, 0).end_array(); }) == expected);
+}
+
+// block-like document, with the hashes and commitments in hex
+const size_t N_ITEMS = 2000;
+
+void make_hash(uint8_t* p, size_t i) {
+    for (size_t k = 0; k < 32; k++)
+        p[k] = static_cast<uint8_t>(i * 31 + k);
+}
+
+string to_hex(const uint8_t* p, size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    string s;
+    s.reserve(n * 2);
+    for (size_t i = 0; i < n; i++) {
+        s += digits[p[i] >> 4];
+        s += digits[p[i] & 0xf];
+    }
+    return s;
+}
+
+void build_dom(io::FragmentWriter& fw) {
+    uint8_t hash[32];
+    json outputs = json::array();
+    for (size_t i = 0; i < N_ITEMS; i++) {
+        make_hash(hash, i);
+        outputs.push_back(json{
+            { "coinbase", (i & 1) != 0 },
+            { "commitment", to_hex(hash, sizeof(hash)) },
+            { "incubation", 0 },
+            { "maturity", 1000 + i }
+        });
+    }
+
+    make_hash(hash, N_ITEMS);
+    serialize_json_msg(fw, json{
+        { "found", true },
+        { "hash", to_hex(hash, sizeof(hash)) },
+        { "height", 1000 },
+        { "outputs", outputs }
+    });
+}
+
+void write_stream(io::FragmentWriter& fw) {
+    write_json_msg(fw, [](JsonWriter& w) {
+        uint8_t hash[32];
+
+        w.begin_object();
+        w.member("found", true);
+        make_hash(hash, N_ITEMS);
+        w.key("hash").hex(hash, sizeof(hash));
+        w.member("height", 1000);
+
+        w.key("outputs").begin_array();
+        for (size_t i = 0; i < N_ITEMS; i++) {
+            make_hash(hash, i);
+            w.begin_object();
+            w.member("coinbase", (i & 1) != 0);
+            w.key("commitment").hex(hash, sizeof(hash));
+            w.member("incubation", 0);
+            w.member("maturity", 1000 + i);
+            w.end_object();
+        }
+        w.end_array();
+        w.end_object();
+    });
+}
+
+void benchmark(const char* name, void(*fn)(io::FragmentWriter&), string& res) {
+    const int nRuns = 50;
+
+    Output warmup;
+    fn(warmup.fw);
+    res = warmup.str();
+
+    uint64_t nAllocs = g_Allocs, nBytes = g_AllocBytes;
+    helpers::StopWatch sw;
+    sw.start();
+
+    for (int i = 0; i < nRuns; i++) {
+        Output out;
+        fn(out.fw);
+    }
+
+    sw.stop();
+    nAllocs = g_Allocs - nAllocs;
+    nBytes = g_AllocBytes - nBytes;
+
+    cout << name << ": " << res.size() << " bytes, " << sw.microseconds() / nRuns << " us, "
+        << nAllocs / nRuns << " allocations, " << nBytes / nRuns << " bytes allocated per msg" << endl;
+}
+
+void test_benchmark() {
+    string a, b;
+    benchmark("dom   ", build_dom, a);
+    benchmark("stream", write_stream, b);
+    CHECK(a == b);
+}
+
+} //namespace
+
+void* operator new(size_t n) {
+    g_Allocs++;
+    g_AllocBytes += n;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+int main() {
+    test_values();
+    test_hex();
+    test_benchmark();
+    return g_failures;
+}
@@ -15,9 +15,18 @@
 #include "utility/logger_checkpoints.h"
 #include "utility/helpers.h"
 #include <thread>
+#include <vector>
+#include <fstream>
+#include <cstdio>
 
 using namespace beam;
 
+namespace {
+    int g_failures = 0;
+}
+
+#define CHECK(x) if (!(x)) { std::cerr << "FAILED: " #x " at line " << __LINE__ << std::endl; ++g_failures; }
+
 struct XXX {
     int z = 333;
 };
@@ -79,6 +88,63 @@ void test_ndc_2(bool exc)
     }
 }
 
+void test_async(const char* prefix, LoggerConfig::Overflow overflow, size_t queueSize) {
+    const int THREADS = 4;
+    const int MESSAGES = 3000;
+
+    Logger::FileNameType fileName;
+    {
+        LoggerConfig cfg;
+        cfg.consoleLevel = LOG_SINK_DISABLED;
+        cfg.fileLevel = LOG_LEVEL_INFO;
+        cfg.filePrefix = prefix;
+        cfg.async = true;
+        cfg.asyncQueueSize = queueSize;
+        cfg.asyncOverflow = overflow;
+
+        auto logger = Logger::create(cfg);
+        fileName = logger->get_current_file_name();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([t]() {
+                for (int i = 0; i < MESSAGES; i++) {
+                    LOG_INFO() << "thread " << t << " msg " << i;
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+    } // the queues are written on destruction
+
+    int received = 0;
+    int dropped = 0;
+    int last[THREADS];
+    std::fill(last, last + THREADS, -1);
+
+    std::ifstream f(fileName);
+    std::string line;
+    while (std::getline(f, line)) {
+        int t = 0, i = 0, n = 0;
+        size_t pos = line.find("thread ");
+        if (pos != std::string::npos && sscanf(line.c_str() + pos, "thread %d msg %d", &t, &i) == 2) {
+            CHECK(t >= 0 && t < THREADS);
+            CHECK(i > last[t]); // in order within a thread
+            last[t] = i;
+            received++;
+        } else if ((pos = line.find("logger: ")) != std::string::npos && sscanf(line.c_str() + pos, "logger: %d messages dropped", &n) == 1) {
+            dropped += n;
+        }
+    }
+    f.close();
+
+    CHECK(received + dropped == THREADS * MESSAGES);
+    if (overflow == LoggerConfig::block) {
+        CHECK(!dropped);
+    }
+
+    std::remove(std::string(fileName.begin(), fileName.end()).c_str());
+}
+
 int main() {
     test_logger_1();
     test_ndc_1();
@@ -87,4 +153,10 @@ int main() {
         test_ndc_2(true);
     }
     catch(...) {}
+
+    test_async("async_drop_", LoggerConfig::drop, 4096);
+    test_async("async_block_", LoggerConfig::block, 4096);
+    test_async("async_", LoggerConfig::drop, 1 << 20);
+
+    return g_failures ? 1 : 0;
 }
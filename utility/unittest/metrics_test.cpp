@@ -0,0 +1,109 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "utility/metrics.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace beam;
+using namespace std;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(x) if (!(x)) { cerr << "FAILED: " #x " at line " << __LINE__ << endl; ++g_failures; }
+
+bool contains(const string& s, const string& what) {
+    return s.find(what) != string::npos;
+}
+
+void test_buckets() {
+    CHECK(metrics::Histogram::get_Bucket(0) == 0);
+    CHECK(metrics::Histogram::get_Bucket(1) == 0);
+    CHECK(metrics::Histogram::get_Bucket(2) == 1);
+    CHECK(metrics::Histogram::get_Bucket(3) == 2);
+    CHECK(metrics::Histogram::get_Bucket(4) == 2);
+    CHECK(metrics::Histogram::get_Bucket(5) == 3);
+    CHECK(metrics::Histogram::get_Bucket(1024) == 10);
+    CHECK(metrics::Histogram::get_Bucket(uint64_t(-1)) == metrics::Histogram::s_Buckets);
+}
+
+void test_concurrent() {
+    auto& r = metrics::Registry::get();
+    metrics::Counter& c = r.get_Counter("test_events_total", "Test events");
+    metrics::Histogram& h = r.get_Histogram("test_values", "Test values", "", 1.);
+
+    CHECK(&c == &r.get_Counter("test_events_total", "Test events"));
+
+    const uint32_t nThreads = 4, nIterations = 100000;
+    vector<thread> threads;
+    for (uint32_t i = 0; i < nThreads; i++) {
+        threads.emplace_back([&c, &h]() {
+            for (uint32_t j = 0; j < nIterations; j++) {
+                c.Inc();
+                h.Observe(j % 8);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    CHECK(c.get() == nThreads * nIterations);
+
+    metrics::Histogram::Snapshot s;
+    h.get(s);
+    CHECK(s.m_Count == nThreads * nIterations);
+    CHECK(s.m_Sum == nThreads * (nIterations / 8) * 28);
+    CHECK(s.m_pBuckets[0] == nThreads * (nIterations / 8) * 2); // 0 and 1
+    CHECK(s.m_pBuckets[3] == nThreads * (nIterations / 8) * 3); // 5..7
+}
+
+void test_exposition() {
+    auto& r = metrics::Registry::get();
+    r.get_Gauge("test_depth", "Test depth", metrics::Writer::Label("kind", "a\"b")).Set(-5);
+    r.get_Histogram("test_seconds", "Test time", metrics::Writer::Label("phase", "x")).Observe(3);
+
+    uint32_t id = r.AddCollector([](metrics::Writer& w) {
+        w.Header("test_collected", "Collected on scrape", "gauge");
+        w.Value("test_collected", "", uint64_t(42));
+    });
+
+    string text;
+    r.Write(text);
+    r.RemoveCollector(id);
+
+    CHECK(metrics::IsEnabled());
+    CHECK(contains(text, "# TYPE test_events_total counter\ntest_events_total 400000\n"));
+    CHECK(contains(text, "test_depth{kind=\"a\\\"b\"} -5\n"));
+    CHECK(contains(text, "test_seconds_bucket{phase=\"x\",le=\"2e-06\"} 0\n"));
+    CHECK(contains(text, "test_seconds_bucket{phase=\"x\",le=\"4e-06\"} 1\n"));
+    CHECK(contains(text, "test_seconds_bucket{phase=\"x\",le=\"+Inf\"} 1\n"));
+    CHECK(contains(text, "test_seconds_sum{phase=\"x\"} 3e-06\n"));
+    CHECK(contains(text, "test_seconds_count{phase=\"x\"} 1\n"));
+    CHECK(contains(text, "test_collected 42\n"));
+
+    text.clear();
+    r.Write(text);
+    CHECK(!contains(text, "test_collected"));
+}
+
+} //namespace
+
+int main() {
+    test_buckets();
+    test_concurrent();
+    test_exposition();
+    return g_failures;
+}
@@ -694,6 +694,94 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
         getHandler().onMessage(id, send);
     }
 
+    void WalletApi::onSendBatchMessage(const JsonRpcId& id, const json& params)
+    {
+        checkJsonParam(params, "payouts", id);
+
+        const auto& payouts = params["payouts"];
+        if (!payouts.is_array() || payouts.empty())
+            throw jsonrpc_exception{ ApiError::InvalidParamsJsonRpc, "Payouts parameter must be a nonempty array.", id };
+
+        SendBatch batch;
+        batch.payouts.reserve(payouts.size());
+
+        for (const auto& p : payouts)
+        {
+            if (!p.is_object())
+                throw jsonrpc_exception{ ApiError::InvalidParamsJsonRpc, "Payout must be an object.", id };
+
+            checkJsonParam(p, "value", id);
+            checkJsonParam(p, "address", id);
+
+            if (!p["value"].is_number_unsigned() || p["value"] == 0)
+                throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Value must be non zero 64bit unsigned integer.", id };
+
+            if (!p["address"].is_string() || p["address"].empty())
+                throw jsonrpc_exception{ ApiError::InvalidAddress, "Address is empty.", id };
+
+            auto& payout = batch.payouts.emplace_back();
+            payout.value = p["value"];
+
+            auto txParams = ParseParameters(p["address"].get<std::string>());
+            if (!txParams)
+                throw jsonrpc_exception{ ApiError::InvalidAddress, "Invalid receiver address or token.", id };
+            payout.txParameters = *txParams;
+
+            if (auto peerID = payout.txParameters.GetParameter<WalletID>(TxParameterID::PeerID); peerID)
+                payout.address = *peerID;
+            else
+                throw jsonrpc_exception{ ApiError::InvalidAddress, "Invalid receiver address.", id };
+
+            if (existsJsonParam(p, "comment"))
+                payout.comment = p["comment"];
+
+            payout.txId = readTxIdParameter(id, p);
+        }
+
+        if (existsJsonParam(params, "from"))
+        {
+            WalletID from(Zero);
+            if (!from.FromHex(params["from"]))
+                throw jsonrpc_exception{ ApiError::InvalidAddress, "Invalid sender address.", id };
+            batch.from = from;
+        }
+
+        if (existsJsonParam(params, "fee"))
+        {
+            if (!params["fee"].is_number_unsigned() || params["fee"] == 0)
+                throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Invalid fee.", id };
+
+            batch.fee = params["fee"];
+        }
+
+        getHandler().onMessage(id, batch);
+    }
+
+    void WalletApi::onBatchStatusMessage(const JsonRpcId& id, const json& params)
+    {
+        checkJsonParam(params, "txIds", id);
+
+        const auto& txIds = params["txIds"];
+        if (!txIds.is_array() || txIds.empty())
+            throw jsonrpc_exception{ ApiError::InvalidParamsJsonRpc, "txIds parameter must be a nonempty array.", id };
+
+        BatchStatus batchStatus;
+        batchStatus.txIds.reserve(txIds.size());
+
+        for (const auto& val : txIds)
+        {
+            if (!val.is_string())
+                throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Transaction ID must be a hex string.", id };
+
+            auto txId = from_hex(val);
+            checkTxId(txId, id);
+
+            std::copy_n(txId.begin(), TxID().size(), batchStatus.txIds.emplace_back().begin());
+        }
+
+        getHandler().onMessage(id, batchStatus);
+    }
+
     void WalletApi::onStatusMessage(const JsonRpcId& id, const json& params)
     {
         checkJsonParam(params, "txId", id);
@@ -896,6 +984,19 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
             else throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Invalid 'skip' parameter.", id };
         }
 
+        if (existsJsonParam(params, "cursor"))
+        {
+            if (!params["cursor"].is_string())
+                throw jsonrpc_exception{ ApiError::InvalidJsonRpc, "Invalid 'cursor' parameter.", id };
+
+            auto txIdSrc = from_hex(params["cursor"]);
+            checkTxId(txIdSrc, id);
+
+            TxID txId;
+            std::copy_n(txIdSrc.begin(), txId.size(), txId.begin());
+            txList.cursor = txId;
+        }
+
         getHandler().onMessage(id, txList);
     }
 
@@ -911,6 +1012,43 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
         getHandler().onMessage(id, generateTxId);
     }
 
+    void WalletApi::onGetConsolidationPolicyMessage(const JsonRpcId& id, const json& params)
+    {
+        GetConsolidationPolicy data;
+        getHandler().onMessage(id, data);
+    }
+
+    void WalletApi::onSetConsolidationPolicyMessage(const JsonRpcId& id, const json& params)
+    {
+        SetConsolidationPolicy data;
+
+        if (existsJsonParam(params, "enabled"))
+        {
+            if (!params["enabled"].is_boolean())
+                throw jsonrpc_exception{ ApiError::InvalidParamsJsonRpc, "Invalid 'enabled' parameter.", id };
+            data.enabled = params["enabled"].get<bool>();
+        }
+
+        auto fnRead = [&](const char* name, auto& res)
+        {
+            if (existsJsonParam(params, name))
+            {
+                if (!params[name].is_number_unsigned())
+                    throw jsonrpc_exception{ ApiError::InvalidParamsJsonRpc, std::string("Invalid '") + name + "' parameter.", id };
+                res = params[name].get<typename std::decay_t<decltype(res)>::value_type>();
+            }
+        };
+
+        fnRead("min_inputs", data.minInputs);
+        fnRead("max_inputs", data.maxInputs);
+        fnRead("max_coin_value", data.maxCoinValue);
+        fnRead("fee", data.fee);
+        fnRead("fee_budget", data.feeBudget);
+        fnRead("interval", data.interval);
+
+        getHandler().onMessage(id, data);
+    }
+
 #ifdef BEAM_ATOMIC_SWAP_SUPPORT
 
     void WalletApi::onOffersListMessage(const JsonRpcId& id, const json& params)
@@ -1277,6 +1415,57 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
             res.tx, msg["result"], res.kernelProofHeight, res.systemHeight);
     }
 
+    void WalletApi::getResponse(const JsonRpcId& id, const SendBatch::Response& res, json& msg)
+    {
+        msg = json
+        {
+            {JsonRpcHrd, JsonRpcVerHrd},
+            {"id", id},
+            {"result", json::array()}
+        };
+
+        for (const auto& resItem : res.items)
+        {
+            json item = json::object();
+            if (resItem.txId)
+                item["txId"] = to_hex(resItem.txId->data(), resItem.txId->size());
+            else
+                item["error"] = resItem.error;
+
+            msg["result"].push_back(item);
+        }
+    }
+
+    void WalletApi::getResponse(const JsonRpcId& id, const BatchStatus::Response& res, json& msg)
+    {
+        msg = json
+        {
+            {JsonRpcHrd, JsonRpcVerHrd},
+            {"id", id},
+            {"result", json::array()}
+        };
+
+        for (const auto& resItem : res.items)
+        {
+            json item = json::object();
+            if (resItem.status)
+            {
+                GetStatusResponseJson(
+                    resItem.status->tx,
+                    item,
+                    resItem.status->kernelProofHeight,
+                    resItem.status->systemHeight);
+            }
+            else
+            {
+                item["txId"] = to_hex(resItem.txId.data(), resItem.txId.size());
+                item["error"] = "Unknown transaction ID.";
+            }
+
+            msg["result"].push_back(item);
+        }
+    }
+
     void WalletApi::getResponse(const JsonRpcId& id, const Split::Response& res, json& msg)
     {
         msg = json
@@ -1332,6 +1521,57 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
         }
     }
 
+    // the members are written in the alphabetical order, as the DOM dumps them
+    void WalletApi::getResponse(const JsonRpcId& id, const GetUtxo::Response& res, JsonWriter& w)
+    {
+        w.begin_object();
+        w.member("id", id);
+        w.member(JsonRpcHrd, JsonRpcVerHrd);
+        w.key("result").begin_array();
+
+        for (auto& utxo : res.utxos)
+        {
+            w.begin_object();
+            w.member("amount", utxo.m_ID.m_Value);
+            w.member("createTxId", utxo.m_createTxId.is_initialized() ? TxIDToString(*utxo.m_createTxId) : "");
+            w.member("id", utxo.toStringID());
+            w.member("maturity", utxo.get_Maturity());
+            w.member("session", utxo.m_sessionId);
+            w.member("spentTxId", utxo.m_spentTxId.is_initialized() ? TxIDToString(*utxo.m_spentTxId) : "");
+            w.member("status", static_cast<std::underlying_type_t<Coin::Status>>(utxo.m_status));
+            w.member("status_string", utxo.getStatusString());
+            w.member("type", (const char*)FourCC::Text(utxo.m_ID.m_Type));
+            w.end_object();
+        }
+
+        w.end_array();
+        w.end_object();
+    }
+
+    void WalletApi::getResponse(const JsonRpcId& id, const TxList::Response& res, JsonWriter& w)
+    {
+        w.begin_object();
+        w.member("id", id);
+        w.member(JsonRpcHrd, JsonRpcVerHrd);
+        w.key("result").begin_array();
+
+        // the items are small, only the list isn't kept in the DOM
+        json item;
+        for (const auto& resItem : res.resultList)
+        {
+            item = json::object();
+            GetStatusResponseJson(
+                resItem.tx,
+                item,
+                resItem.kernelProofHeight,
+                resItem.systemHeight);
+            w.value(item);
+        }
+
+        w.end_array();
+        w.end_object();
+    }
+
     void WalletApi::getResponse(const JsonRpcId& id, const WalletStatus::Response& res, json& msg)
     {
         msg = json
@@ -1363,6 +1603,33 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
         };
     }
 
+    void WalletApi::getResponse(const JsonRpcId& id, const GetConsolidationPolicy::Response& res, json& msg)
+    {
+        msg = json
+        {
+            {JsonRpcHrd, JsonRpcVerHrd},
+            {"id", id},
+            {"result",
+                {
+                    {"enabled", res.policy.m_Enabled},
+                    {"min_inputs", res.policy.m_MinInputs},
+                    {"max_inputs", res.policy.m_MaxInputs},
+                    {"max_inputs_limit", res.maxInputsLimit},
+                    {"max_coin_value", res.policy.m_MaxCoinValue},
+                    {"fee", res.policy.m_Fee},
+                    {"fee_budget", res.policy.m_FeeBudget},
+                    {"fee_spent", res.feeSpent},
+                    {"interval", res.policy.m_Interval},
+                }
+            }
+        };
+    }
+
+    void WalletApi::getResponse(const JsonRpcId& id, const SetConsolidationPolicy::Response& res, json& msg)
+    {
+        getResponse(id, static_cast<const GetConsolidationPolicy::Response&>(res), msg);
+    }
+
     void WalletApi::getResponse(const JsonRpcId& id, const Lock::Response& res, json& msg)
     {
         msg = json
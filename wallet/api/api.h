@@ -21,6 +21,7 @@
 #include "wallet/client/extensions/offers_board/swap_offer.h"
 #endif  // BEAM_ATOMIC_SWAP_SUPPORT
 #include "nlohmann/json.hpp"
+#include "utility/io/json_writer.h"
 
 namespace beam::wallet
 {
@@ -69,8 +70,10 @@ namespace beam::wallet
     macro(AddrList,         "addr_list",        API_READ_ACCESS)    \
     macro(ValidateAddress,  "validate_address", API_READ_ACCESS)    \
     macro(Send,             "tx_send",          API_WRITE_ACCESS)   \
+    macro(SendBatch,        "tx_send_batch",    API_WRITE_ACCESS)   \
     macro(Issue,            "tx_issue",         API_WRITE_ACCESS)   \
     macro(Status,           "tx_status",        API_READ_ACCESS)    \
+    macro(BatchStatus,      "tx_batch_status",  API_READ_ACCESS)    \
     macro(Split,            "tx_split",         API_WRITE_ACCESS)   \
     macro(TxCancel,         "tx_cancel",        API_WRITE_ACCESS)   \
     macro(TxDelete,         "tx_delete",        API_WRITE_ACCESS)   \
@@ -80,6 +83,8 @@ namespace beam::wallet
     macro(TxList,           "tx_list",          API_READ_ACCESS)    \
     macro(WalletStatus,     "wallet_status",    API_READ_ACCESS)    \
     macro(GenerateTxId,     "generate_tx_id",   API_READ_ACCESS)    \
+    macro(GetConsolidationPolicy, "get_consolidation_policy", API_READ_ACCESS)  \
+    macro(SetConsolidationPolicy, "set_consolidation_policy", API_WRITE_ACCESS) \
     SWAP_OFFER_API_METHODS(macro)
 
 #if defined(BEAM_ATOMIC_SWAP_SUPPORT)
@@ -271,6 +276,35 @@ namespace beam::wallet
         };
     };
 
+    // Many payouts at once. The transactions are still negotiated one per receiver,
+    // but the coins for all of them are selected in one go
+    struct SendBatch
+    {
+        struct Payout
+        {
+            Amount value = 0;
+            WalletID address;
+            std::string comment;
+            boost::optional<TxID> txId;
+            TxParameters txParameters;
+        };
+
+        std::vector<Payout> payouts;
+        Amount fee = DefaultFee; // per transaction
+        boost::optional<WalletID> from;
+
+        struct Response
+        {
+            struct Item
+            {
+                boost::optional<TxID> txId;
+                std::string error; // if the transaction wasn't started
+            };
+
+            std::vector<Item> items; // in the order of payouts
+        };
+    };
+
     struct Issue
     {
         Amount value;
@@ -299,6 +333,22 @@ namespace beam::wallet
         };
     };
 
+    struct BatchStatus
+    {
+        std::vector<TxID> txIds;
+
+        struct Response
+        {
+            struct Item
+            {
+                TxID txId;
+                boost::optional<Status::Response> status; // none if unknown
+            };
+
+            std::vector<Item> items;
+        };
+    };
+
     struct Split
     {
         Amount fee = DefaultFee;
@@ -375,6 +425,9 @@ namespace beam::wallet
         int count = 0;
         int skip = 0;
 
+        // txId of the last item of the previous page, the list is newest first. Stable while the new txs arrive, unlike skip
+        boost::optional<TxID> cursor;
+
         struct Response
         {
             std::vector<Status::Response> resultList;
@@ -404,6 +457,32 @@ namespace beam::wallet
         };
     };
 
+    struct GetConsolidationPolicy
+    {
+        struct Response
+        {
+            UtxoConsolidator::Policy policy;
+            Amount feeSpent = 0;
+            uint32_t maxInputsLimit = 0;
+        };
+    };
+
+    struct SetConsolidationPolicy
+    {
+        // only the specified values are changed
+        boost::optional<bool> enabled;
+        boost::optional<uint32_t> minInputs;
+        boost::optional<uint32_t> maxInputs;
+        boost::optional<Amount> maxCoinValue;
+        boost::optional<Amount> fee;
+        boost::optional<Amount> feeBudget;
+        boost::optional<Height> interval;
+
+        struct Response : public GetConsolidationPolicy::Response
+        {
+        };
+    };
+
     class IApiHandler
     {
     public:
@@ -472,6 +551,10 @@ namespace beam::wallet
 
 #undef RESPONSE_FUNC
 
+        // streaming versions of the potentially large responses, the output is the same
+        void getResponse(const JsonRpcId& id, const GetUtxo::Response& data, JsonWriter& w);
+        void getResponse(const JsonRpcId& id, const TxList::Response& data, JsonWriter& w);
+
     private:
         IWalletApiHandler& getHandler() const;
 
@@ -35,6 +35,7 @@
 
 #include "http/http_connection.h"
 #include "http/http_msg_creator.h"
+#include "http/http_json_serializer.h"
 
 #include "p2p/line_protocol.h"
 
@@ -452,6 +453,12 @@ private:
             serialize_json_msg(_lineProtocol, msg);
         }
 
+        bool streamMsg(const std::function<void(JsonWriter&)>& fn) override
+        {
+            write_json_msg(_lineProtocol, fn);
+            return true;
+        }
+
         void on_write(io::SharedBuffer&& msg)
         {
             _stream->write(msg);
@@ -526,6 +533,13 @@ private:
             _keepalive = send(_connection, 200, "OK");
         }
 
+        bool streamMsg(const std::function<void(JsonWriter&)>& fn) override
+        {
+            write_json_msg(_body, _packer, fn);
+            _keepalive = send(_connection, 200, "OK");
+            return true;
+        }
+
     private:
 
         bool on_request(uint64_t id, const HttpMsgReader::Message& msg)
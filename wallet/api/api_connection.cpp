@@ -151,6 +151,11 @@ ApiConnection::~ApiConnection()
 {
 }
 
+bool ApiConnection::streamMsg(const std::function<void(JsonWriter&)>& fn)
+{
+    return false;
+}
+
 void ApiConnection::doError(const JsonRpcId& id, ApiError code, const std::string& data)
 {
     json msg
@@ -285,48 +290,57 @@ void ApiConnection::doTxAlreadyExistsError(const JsonRpcId& id)
     doError(id, ApiError::InvalidTxId, "Provided transaction ID already exists in the wallet.");
 }
 
-void ApiConnection::onMessage(const JsonRpcId& id, const Send& data)
+bool ApiConnection::getSenderAddress(const JsonRpcId& id, const boost::optional<WalletID>& from, WalletID& res)
 {
-    LOG_DEBUG() << "Send(id = " << id << " amount = " << data.value << " fee = " << data.fee << " address = " << std::to_string(data.address) << ")";
-
-    try
+    auto walletDB = _walletData.getWalletDB();
+    if (from)
     {
-        WalletID from(Zero);
+        if (!from->IsValid())
+        {
+            doError(id, ApiError::InvalidAddress, "Invalid sender address.");
+            return false;
+        }
 
-        auto walletDB = _walletData.getWalletDB();
-        if (data.from)
+        auto addr = walletDB->getAddress(*from);
+        bool isMine = addr ? addr->isOwn() : false;
+
+        if (!isMine)
         {
-            if (!data.from->IsValid())
-            {
-                doError(id, ApiError::InvalidAddress, "Invalid sender address.");
-                return;
-            }
+            doError(id, ApiError::InvalidAddress, "It's not your own address.");
+            return false;
+        }
 
-            auto addr = walletDB->getAddress(*data.from);
-            bool isMine = addr ? addr->isOwn() : false;
+        if (addr->isExpired())
+        {
+            doError(id, ApiError::InvalidAddress, "Sender address is expired.");
+            return false;
+        }
 
-            if (!isMine)
-            {
-                doError(id, ApiError::InvalidAddress, "It's not your own address.");
-                return;
-            }
+        res = *from;
+    }
+    else
+    {
+        WalletAddress senderAddress;
+        walletDB->createAddress(senderAddress);
+        walletDB->saveAddress(senderAddress);
 
-            if (addr->isExpired())
-            {
-                doError(id, ApiError::InvalidAddress, "Sender address is expired.");
-                return;
-            }
+        res = senderAddress.m_walletID;
+    }
 
-            from = *data.from;
-        }
-        else
-        {
-            WalletAddress senderAddress;
-            walletDB->createAddress(senderAddress);
-            walletDB->saveAddress(senderAddress);
+    return true;
+}
 
-            from = senderAddress.m_walletID;
-        }
+void ApiConnection::onMessage(const JsonRpcId& id, const Send& data)
+{
+    LOG_DEBUG() << "Send(id = " << id << " amount = " << data.value << " fee = " << data.fee << " address = " << std::to_string(data.address) << ")";
+
+    try
+    {
+        WalletID from(Zero);
+        if (!getSenderAddress(id, data.from, from))
+            return;
+
+        auto walletDB = _walletData.getWalletDB();
 
         ByteBuffer message(data.comment.begin(), data.comment.end());
 
@@ -379,6 +393,190 @@ void ApiConnection::onMessage(const JsonRpcId& id, const Send& data)
     }
 }
 
+namespace
+{
+    // Distributes the coins selected for the whole batch between the payouts, the biggest payouts first.
+    // Each one gets the smallest coin that covers it, or else the biggest coins until covered.
+    // Payouts left partially covered are completed by the transaction's own selection.
+    std::vector<CoinIDList> distributeCoins(const std::vector<Coin>& coins, const std::vector<Amount>& needs)
+    {
+        std::multimap<Amount, Coin::ID> pool;
+        for (const auto& c : coins)
+            pool.emplace(c.m_ID.m_Value, c.m_ID);
+
+        std::vector<size_t> order(needs.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&needs](size_t a, size_t b) { return needs[a] > needs[b]; });
+
+        std::vector<CoinIDList> res(needs.size());
+        for (size_t i : order)
+        {
+            Amount need = needs[i];
+            while (need && !pool.empty())
+            {
+                auto it = pool.lower_bound(need);
+                if (pool.end() == it)
+                    --it; // the biggest one
+
+                res[i].push_back(it->second);
+                need -= std::min(need, it->first);
+                pool.erase(it);
+            }
+        }
+
+        return res;
+    }
+}
+
+void ApiConnection::onMessage(const JsonRpcId& id, const SendBatch& data)
+{
+    LOG_DEBUG() << "SendBatch(id = " << id << " payouts = " << data.payouts.size() << " fee = " << data.fee << ")";
+
+    try
+    {
+        WalletID from(Zero);
+        if (!getSenderAddress(id, data.from, from))
+            return;
+
+        auto minimumFee = std::max(wallet::GetMinimumFee(2), DefaultFee); // receivers's output + change
+        if (data.fee < minimumFee)
+        {
+            doError(id, ApiError::InvalidParamsJsonRpc, getMinimumFeeError(minimumFee));
+            return;
+        }
+
+        // Reject the whole batch before any of its transactions is started
+        std::vector<Amount> needs;
+        needs.reserve(data.payouts.size());
+        Amount total = 0;
+        for (size_t i = 0; i < data.payouts.size(); i++)
+        {
+            const auto& p = data.payouts[i];
+
+            auto txType = p.txParameters.GetParameter<TxType>(TxParameterID::TransactionType);
+            if (!p.address.IsValid() || (txType && *txType != TxType::Simple))
+            {
+                doError(id, ApiError::InvalidAddress, "Invalid receiver address of payout " + std::to_string(i) + ".");
+                return;
+            }
+
+            Amount need = p.value + data.fee;
+            if (need < p.value || total + need < total)
+            {
+                doError(id, ApiError::InvalidParamsJsonRpc, "Total amount of the batch is too big.");
+                return;
+            }
+
+            needs.push_back(need);
+            total += need;
+        }
+
+        auto walletDB = _walletData.getWalletDB();
+
+        auto coins = walletDB->selectCoins(total, Zero);
+        if (coins.empty())
+        {
+            doError(id, ApiError::InternalErrorJsonRpc, "There is not enough funds to complete the batch.");
+            return;
+        }
+
+        auto coinsPerPayout = distributeCoins(coins, needs);
+
+        // Start the fully covered payouts first, so that they lock their coins before the rest select the missing ones
+        std::vector<size_t> order;
+        order.reserve(needs.size());
+        for (int iPass = 0; iPass < 2; iPass++)
+        {
+            for (size_t i = 0; i < needs.size(); i++)
+            {
+                Amount covered = 0;
+                for (const auto& cid : coinsPerPayout[i])
+                    covered += cid.m_Value;
+
+                if ((covered >= needs[i]) == !iPass)
+                    order.push_back(i);
+            }
+        }
+
+        SendBatch::Response res;
+        res.items.resize(data.payouts.size());
+
+        for (size_t i : order)
+        {
+            const auto& p = data.payouts[i];
+            auto& item = res.items[i];
+
+            if (p.txId && walletDB->getTx(*p.txId))
+            {
+                item.error = "Provided transaction ID already exists in the wallet.";
+                continue;
+            }
+
+            try
+            {
+                auto params = CreateSimpleTransactionParameters(p.txId);
+                LoadReceiverParams(p.txParameters, params);
+
+                params.SetParameter(TxParameterID::MyID, from)
+                      .SetParameter(TxParameterID::Amount, p.value)
+                      .SetParameter(TxParameterID::Fee, data.fee)
+                      .SetParameter(TxParameterID::PreselectedCoins, coinsPerPayout[i])
+                      .SetParameter(TxParameterID::Message, ByteBuffer(p.comment.begin(), p.comment.end()));
+
+                item.txId = _walletData.getWallet().StartTransaction(params);
+            }
+            catch (const std::exception& e)
+            {
+                LOG_ERROR() << "SendBatch: payout " << i << " to " << std::to_string(p.address) << " failed: " << e.what();
+                item.error = "Transaction could not be created. Please look at logs.";
+            }
+        }
+
+        doResponse(id, res);
+    }
+    catch (...)
+    {
+        doError(id, ApiError::InternalErrorJsonRpc, "Transactions could not be created. Please look at logs.");
+    }
+}
+
+void ApiConnection::onMessage(const JsonRpcId& id, const BatchStatus& data)
+{
+    LOG_DEBUG() << "BatchStatus(id = " << id << " txIds = " << data.txIds.size() << ")";
+
+    auto walletDB = _walletData.getWalletDB();
+
+    Block::SystemState::ID stateID = {};
+    walletDB->getSystemStateID(stateID);
+
+    BatchStatus::Response res;
+    res.items.reserve(data.txIds.size());
+
+    for (const auto& txId : data.txIds)
+    {
+        auto& item = res.items.emplace_back();
+        item.txId = txId;
+
+        auto tx = walletDB->getTx(txId);
+        if (!tx)
+            continue;
+
+        item.status = Status::Response();
+        auto& status = *item.status;
+        status.tx = *tx;
+        status.kernelProofHeight = 0;
+        status.systemHeight = stateID.m_Height;
+        status.confirmations = 0;
+
+        storage::getTxParameter(*walletDB, txId, TxParameterID::KernelProofHeight, status.kernelProofHeight);
+        if (status.kernelProofHeight && status.systemHeight >= status.kernelProofHeight)
+            status.confirmations = status.systemHeight - status.kernelProofHeight;
+    }
+
+    doResponse(id, res);
+}
+
 void ApiConnection::onMessage(const JsonRpcId& id, const Issue& data)
 {
     LOG_DEBUG() << "Issue(id = " << id << " amount = " << data.value << " fee = " << data.fee;
@@ -563,7 +761,7 @@ void ApiConnection::onMessage(const JsonRpcId& id, const GetUtxo& data)
 
     doPagination(data.skip, data.count, response.utxos);
 
-    doResponse(id, response);
+    doStreamResponse(id, response);
 }
 
 void ApiConnection::onMessage(const JsonRpcId& id, const WalletStatus& data)
@@ -606,6 +804,54 @@ void ApiConnection::onMessage(const JsonRpcId& id, const GenerateTxId& data)
     doResponse(id, GenerateTxId::Response{ wallet::GenerateTxID() });
 }
 
+namespace
+{
+    void FillConsolidationPolicy(const UtxoConsolidator& consolidator, GetConsolidationPolicy::Response& res)
+    {
+        res.policy = consolidator.get_Policy();
+        res.feeSpent = consolidator.get_FeeSpent();
+        res.maxInputsLimit = UtxoConsolidator::get_MaxInputs();
+    }
+}
+
+void ApiConnection::onMessage(const JsonRpcId& id, const GetConsolidationPolicy& data)
+{
+    LOG_DEBUG() << "GetConsolidationPolicy(id = " << id << ")";
+
+    GetConsolidationPolicy::Response response;
+    FillConsolidationPolicy(_walletData.getWallet().GetConsolidator(), response);
+    doResponse(id, response);
+}
+
+void ApiConnection::onMessage(const JsonRpcId& id, const SetConsolidationPolicy& data)
+{
+    LOG_DEBUG() << "SetConsolidationPolicy(id = " << id << ")";
+
+    auto& consolidator = _walletData.getWallet().GetConsolidator();
+    auto policy = consolidator.get_Policy();
+
+    if (data.enabled)
+        policy.m_Enabled = *data.enabled;
+    if (data.minInputs)
+        policy.m_MinInputs = *data.minInputs;
+    if (data.maxInputs)
+        policy.m_MaxInputs = *data.maxInputs;
+    if (data.maxCoinValue)
+        policy.m_MaxCoinValue = *data.maxCoinValue;
+    if (data.fee)
+        policy.m_Fee = *data.fee;
+    if (data.feeBudget)
+        policy.m_FeeBudget = *data.feeBudget;
+    if (data.interval)
+        policy.m_Interval = *data.interval;
+
+    consolidator.set_Policy(policy);
+
+    SetConsolidationPolicy::Response response;
+    FillConsolidationPolicy(consolidator, response);
+    doResponse(id, response);
+}
+
 void ApiConnection::onMessage(const JsonRpcId& id, const Lock& data)
 {
     LOG_DEBUG() << "Lock(id = " << id << ")";
@@ -634,9 +880,31 @@ void ApiConnection::onMessage(const JsonRpcId& id, const TxList& data)
 
     TxList::Response res;
 
+    // status and the page are resolved by the tx summary index, the height is not indexed
+    bool pageInDB = !data.filter.height;
+
     {
         auto walletDB = _walletData.getWalletDB();
-        auto txList = walletDB->getTxHistory();
+
+        TxHistoryFilter filter;
+        filter.m_Type = TxType::Simple;
+        filter.m_Status = data.filter.status;
+
+        if (data.cursor)
+        {
+            auto tx = walletDB->getTx(*data.cursor);
+            if (!tx)
+            {
+                doError(id, ApiError::InvalidParamsJsonRpc, "Unknown 'cursor' transaction ID.");
+                return;
+            }
+
+            filter.m_After = TxHistoryFilter::Cursor{ tx->m_createTime, tx->m_txId };
+        }
+
+        auto txList = pageInDB && data.count > 0
+            ? walletDB->getTxHistory(filter, std::max(data.skip, 0), data.count)
+            : walletDB->getTxHistory(filter, 0, std::numeric_limits<int>::max());
 
         Block::SystemState::ID stateID = {};
         _walletData.getWalletDB()->getSystemStateID(stateID);
@@ -656,18 +924,6 @@ void ApiConnection::onMessage(const JsonRpcId& id, const TxList& data)
 
     using Result = decltype(res.resultList);
 
-    // filter transactions by status if provided
-    if (data.filter.status)
-    {
-        Result filteredList;
-
-        for (const auto& it : res.resultList)
-            if (it.tx.m_status == *data.filter.status)
-                filteredList.push_back(it);
-
-        res.resultList = filteredList;
-    }
-
     // filter transactions by height if provided
     if (data.filter.height)
     {
@@ -680,9 +936,12 @@ void ApiConnection::onMessage(const JsonRpcId& id, const TxList& data)
         res.resultList = filteredList;
     }
 
-    doPagination(data.skip, data.count, res.resultList);
+    if (!pageInDB)
+    {
+        doPagination(data.skip, data.count, res.resultList);
+    }
 
-    doResponse(id, res);
+    doStreamResponse(id, res);
 }
 
 #ifdef BEAM_ATOMIC_SWAP_SUPPORT
@@ -41,6 +41,9 @@ public:
 
     virtual void serializeMsg(const json& msg) = 0;
 
+    // writes the msg w/o building the DOM. Returns false if the transport doesn't support it
+    virtual bool streamMsg(const std::function<void(JsonWriter&)>& fn);
+
     template<typename T>
     void doResponse(const JsonRpcId& id, const T& response)
     {
@@ -49,6 +52,14 @@ public:
         serializeMsg(msg);
     }
 
+    // for the responses that have a streaming version, see WalletApi. Falls back to the DOM
+    template<typename T>
+    void doStreamResponse(const JsonRpcId& id, const T& response)
+    {
+        if (!streamMsg([&](JsonWriter& w) { _api.getResponse(id, response, w); }))
+            doResponse(id, response);
+    }
+
     void doError(const JsonRpcId& id, ApiError code, const std::string& data = "");
 
     void onInvalidJsonRpc(const json& msg) override;
@@ -64,6 +75,9 @@ public:
 
     void doTxAlreadyExistsError(const JsonRpcId& id);
 
+    // validates the sender's own address, or creates a new one. Replies with an error on failure
+    bool getSenderAddress(const JsonRpcId& id, const boost::optional<WalletID>& from, WalletID& res);
+
     template<typename T>
     static void doPagination(size_t skip, size_t count, std::vector<T>& res)
     {
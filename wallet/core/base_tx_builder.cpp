@@ -247,41 +247,28 @@ namespace beam::wallet
         {
             using KeyKeeperHandler::KeyKeeperHandler;
 
-            std::vector<IPrivateKeyKeeper2::Method::CreateOutput> m_vCalls;
-            std::vector<Output::Ptr> m_Outputs;
+            IPrivateKeyKeeper2::Method::CreateOutputs m_Method;
 
             virtual ~MyHandler() {} // auto
 
             virtual void OnSuccess(BaseTxBuilder& b) override
             {
-                size_t iDone = m_Outputs.size();
-                assert(iDone < m_vCalls.size());
-                assert(m_vCalls[iDone].m_pResult);
-
-                m_Outputs.push_back(std::move(m_vCalls[iDone].m_pResult));
+                assert(m_Method.m_vResults.size() == m_Method.m_vCids.size());
 
-                if (m_Outputs.size() == m_vCalls.size())
-                {
-                    // all done
-                    b.m_Outputs = std::move(m_Outputs);
-                    b.FinalizeOutputs();
-                    OnAllDone(b);
-                }
+                b.m_Outputs = std::move(m_Method.m_vResults);
+                b.FinalizeOutputs();
+                OnAllDone(b);
             }
         };
 
         KeyKeeperHandler::Ptr pHandler = std::make_shared<MyHandler>(*this, m_CreatingOutputs);
         MyHandler& x = Cast::Up<MyHandler>(*pHandler);
 
-        x.m_vCalls.resize(m_OutputCoins.size());
-        x.m_Outputs.reserve(m_OutputCoins.size());
-        for (size_t i = 0; i < m_OutputCoins.size(); i++)
-        {
-            x.m_vCalls[i].m_hScheme = m_MinHeight;
-            x.m_vCalls[i].m_Cid = m_OutputCoins[i];
+        // all at once, the key keeper may create them in parallel
+        x.m_Method.m_hScheme = m_MinHeight;
+        x.m_Method.m_vCids = m_OutputCoins;
 
-            m_Tx.get_KeyKeeperStrict()->InvokeAsync(x.m_vCalls[i], pHandler);
-        }
+        m_Tx.get_KeyKeeperStrict()->InvokeAsync(x.m_Method, pHandler);
 
         return true;// true if async
     }
@@ -70,6 +70,80 @@ namespace beam::wallet
 	KEY_KEEPER_METHODS(THE_MACRO)
 #undef THE_MACRO
 
+	IPrivateKeyKeeper2::Status::Type IPrivateKeyKeeper2::InvokeSync(Method::CreateOutputs& m)
+	{
+		m.m_vResults.resize(m.m_vCids.size());
+
+		for (size_t i = 0; i < m.m_vCids.size(); i++)
+		{
+			Method::CreateOutput m2;
+			m2.m_hScheme = m.m_hScheme;
+			m2.m_Cid = m.m_vCids[i];
+
+			Status::Type ret = InvokeSync(m2);
+			if (Status::Success != ret)
+				return ret;
+
+			m.m_vResults[i] = std::move(m2.m_pResult);
+		}
+
+		return Status::Success;
+	}
+
+	void IPrivateKeyKeeper2::InvokeAsync(Method::CreateOutputs& m, const Handler::Ptr& pHandler)
+	{
+		struct MyHandler
+			:public Handler
+		{
+			Method::CreateOutputs* m_pM;
+			Handler::Ptr m_pHandler; // reset once the result is reported
+			std::vector<Method::CreateOutput> m_vCalls;
+			size_t m_Pending;
+
+			virtual ~MyHandler() {}
+
+			virtual void OnDone(Status::Type n) override
+			{
+				if (!m_pHandler)
+					return; // one of the previous has failed
+
+				if (Status::Success == n)
+				{
+					assert(m_Pending);
+					if (--m_Pending)
+						return;
+
+					m_pM->m_vResults.resize(m_vCalls.size());
+					for (size_t i = 0; i < m_vCalls.size(); i++)
+						m_pM->m_vResults[i] = std::move(m_vCalls[i].m_pResult);
+				}
+
+				Handler::Ptr p = std::move(m_pHandler);
+				p->OnDone(n);
+			}
+		};
+
+		if (m.m_vCids.empty())
+		{
+			m.m_vResults.clear();
+			pHandler->OnDone(Status::Success);
+			return;
+		}
+
+		std::shared_ptr<MyHandler> pMy = std::make_shared<MyHandler>();
+		pMy->m_pM = &m;
+		pMy->m_pHandler = pHandler;
+		pMy->m_Pending = m.m_vCids.size();
+		pMy->m_vCalls.resize(m.m_vCids.size());
+
+		for (size_t i = 0; i < m.m_vCids.size(); i++)
+		{
+			pMy->m_vCalls[i].m_hScheme = m.m_hScheme;
+			pMy->m_vCalls[i].m_Cid = m.m_vCids[i];
+			InvokeAsync(pMy->m_vCalls[i], pMy);
+		}
+	}
+
 	////////////////////////////////
 	// misc
 	IPrivateKeyKeeper2::Status::Type IPrivateKeyKeeper2::get_Commitment(ECC::Point::Native& res, const CoinID& cid)
@@ -277,6 +351,7 @@ namespace beam::wallet
 	}
 
 	KEY_KEEPER_METHODS(THE_MACRO)
+	THE_MACRO(CreateOutputs)
 #undef THE_MACRO
 
 
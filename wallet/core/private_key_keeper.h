@@ -215,6 +215,12 @@ namespace beam::wallet
                 Output::Ptr m_pResult;
             };
 
+            struct CreateOutputs {
+                Height m_hScheme;
+                std::vector<CoinID> m_vCids;
+                std::vector<Output::Ptr> m_vResults; // in the same order
+            };
+
             struct InOuts
             {
                 std::vector<CoinID> m_vInputs;
@@ -269,6 +275,11 @@ namespace beam::wallet
         KEY_KEEPER_METHODS(THE_MACRO)
 #undef THE_MACRO
 
+        // Batch of outputs. By default it's expressed via CreateOutput, all the requests are issued at once.
+        // Implementations that can do better (in parallel, in a single roundtrip) should override both
+        virtual Status::Type InvokeSync(Method::CreateOutputs&);
+        virtual void InvokeAsync(Method::CreateOutputs&, const Handler::Ptr&);
+
         virtual ~IPrivateKeyKeeper2() {}
 
         // synthetic functions (in terms of underlying ones)
@@ -368,6 +379,7 @@ namespace beam::wallet
 		void InvokeAsync(Method::method& m, const Handler::Ptr& pHandler) override;
 
 		KEY_KEEPER_METHODS(THE_MACRO)
+		THE_MACRO(CreateOutputs)
 #undef THE_MACRO
 
 	};
@@ -0,0 +1,168 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "utxo_consolidator.h"
+#include "wallet.h"
+#include "simple_transaction.h"
+#include "utility/logger.h"
+
+namespace beam::wallet
+{
+    const char UtxoConsolidator::s_szPolicy[] = "ConsolidationPolicy";
+    const char UtxoConsolidator::s_szFeeSpent[] = "ConsolidationFeeSpent";
+    const char UtxoConsolidator::s_szLastHeight[] = "ConsolidationHeight";
+    const char UtxoConsolidator::s_szTxID[] = "ConsolidationTxID";
+    const char UtxoConsolidator::s_szAddress[] = "ConsolidationAddress";
+
+    UtxoConsolidator::UtxoConsolidator(Wallet& wallet, IWalletDB::Ptr walletDB)
+        : m_Wallet(wallet)
+        , m_WalletDB(walletDB)
+    {
+        ByteBuffer buf;
+        if (m_WalletDB->getBlob(s_szPolicy, buf))
+        {
+            Deserializer der;
+            der.reset(buf);
+            der & m_Policy;
+        }
+    }
+
+    void UtxoConsolidator::set_Policy(const Policy& policy)
+    {
+        m_Policy = policy;
+
+        Serializer ser;
+        ser & m_Policy;
+        m_WalletDB->setVarRaw(s_szPolicy, ser.buffer().first, ser.buffer().second);
+    }
+
+    Amount UtxoConsolidator::get_FeeSpent() const
+    {
+        Amount fee = 0;
+        storage::getVar(*m_WalletDB, s_szFeeSpent, fee);
+        return fee;
+    }
+
+    uint32_t UtxoConsolidator::get_MaxInputs()
+    {
+        static uint32_t s_nMax = 0;
+        if (!s_nMax)
+        {
+            Input inp;
+            inp.m_Commitment = Zero;
+
+            SerializerSizeCounter ssc;
+            ssc & inp;
+
+            // leave the room for other transactions
+            s_nMax = static_cast<uint32_t>(Rules::get().MaxBodySize / 2 / ssc.m_Counter.m_Value);
+        }
+        return s_nMax;
+    }
+
+    bool UtxoConsolidator::IsTxActive()
+    {
+        TxID txID;
+        if (!storage::getVar(*m_WalletDB, s_szTxID, txID))
+            return false;
+
+        TxStatus status = TxStatus::Failed; // the tx may be deleted
+        storage::getTxParameter(*m_WalletDB, txID, TxParameterID::Status, status);
+
+        switch (status)
+        {
+        case TxStatus::Completed:
+            {
+                Amount fee = 0;
+                storage::getTxParameter(*m_WalletDB, txID, TxParameterID::Fee, fee);
+                storage::setVar(*m_WalletDB, s_szFeeSpent, get_FeeSpent() + fee);
+            }
+            // no break
+
+        case TxStatus::Failed:
+        case TxStatus::Canceled:
+            m_WalletDB->removeVarRaw(s_szTxID);
+            return false;
+
+        default:
+            return true;
+        }
+    }
+
+    WalletID UtxoConsolidator::get_Address()
+    {
+        WalletID wid;
+        if (storage::getVar(*m_WalletDB, s_szAddress, wid) && m_WalletDB->getAddress(wid))
+            return wid;
+
+        WalletAddress addr;
+        m_WalletDB->createAddress(addr);
+        addr.m_label = "consolidation";
+        addr.m_duration = WalletAddress::AddressExpirationNever;
+        m_WalletDB->saveAddress(addr);
+
+        storage::setVar(*m_WalletDB, s_szAddress, addr.m_walletID);
+        return addr.m_walletID;
+    }
+
+    void UtxoConsolidator::OnSynced()
+    {
+        if (!m_Policy.m_Enabled || IsTxActive())
+            return;
+
+        Block::SystemState::ID id;
+        m_WalletDB->getSystemStateID(id);
+
+        Height hLast = 0;
+        if (storage::getVar(*m_WalletDB, s_szLastHeight, hLast) && (id.m_Height < hLast + m_Policy.m_Interval))
+            return;
+
+        Amount fee = std::max(m_Policy.m_Fee, GetMinimumFee(1));
+        if (m_Policy.m_FeeBudget && (get_FeeSpent() + fee > m_Policy.m_FeeBudget))
+            return;
+
+        uint32_t nMax = std::min(m_Policy.m_MaxInputs, get_MaxInputs());
+        auto coins = m_WalletDB->selectSmallestCoins(nMax, m_Policy.m_MaxCoinValue, Zero);
+        if ((coins.size() < 2) || (coins.size() < m_Policy.m_MinInputs))
+            return;
+
+        Amount sum = 0;
+        CoinIDList ids;
+        ids.reserve(coins.size());
+        for (const auto& c : coins)
+        {
+            sum += c.m_ID.m_Value;
+            ids.push_back(c.m_ID);
+        }
+
+        if (sum <= fee)
+            return; // dust, not worth it yet
+
+        try
+        {
+            auto txID = m_Wallet.StartTransaction(CreateSplitTransactionParameters(get_Address(), AmountList{ sum - fee })
+                .SetParameter(TxParameterID::Fee, fee)
+                .SetParameter(TxParameterID::PreselectedCoins, ids));
+
+            storage::setVar(*m_WalletDB, s_szTxID, txID);
+            storage::setVar(*m_WalletDB, s_szLastHeight, id.m_Height);
+
+            LOG_INFO() << txID << " Consolidating " << coins.size() << " coins, " << PrintableAmount(sum) << ", fee: " << PrintableAmount(fee);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR() << "Failed to start consolidation: " << e.what();
+        }
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "wallet_db.h"
+
+namespace beam::wallet
+{
+    class Wallet;
+
+    // Merges the smallest available coins by self transactions, one transaction at a time.
+    // Meant for the payout wallets, which collect lots of tiny coins
+    class UtxoConsolidator
+    {
+    public:
+        struct Policy
+        {
+            bool m_Enabled = false;
+            uint32_t m_MinInputs = 100; // don't bother merging less
+            uint32_t m_MaxInputs = 500; // per transaction, also limited by get_MaxInputs()
+            Amount m_MaxCoinValue = 0; // merge only smaller coins, 0 - any
+            Amount m_Fee = 0; // per transaction, 0 - the minimal one
+            Amount m_FeeBudget = 0; // all the transactions together, 0 - unlimited
+            Height m_Interval = 1; // blocks since the previous transaction
+
+            template <typename Archive>
+            void serialize(Archive& ar)
+            {
+                ar
+                    & m_Enabled
+                    & m_MinInputs
+                    & m_MaxInputs
+                    & m_MaxCoinValue
+                    & m_Fee
+                    & m_FeeBudget
+                    & m_Interval;
+            }
+        };
+
+        UtxoConsolidator(Wallet&, IWalletDB::Ptr);
+
+        const Policy& get_Policy() const { return m_Policy; }
+        void set_Policy(const Policy&);
+
+        Amount get_FeeSpent() const;
+
+        // Inputs that a transaction may have to fit well within a block
+        static uint32_t get_MaxInputs();
+
+        // Should be called once the wallet is in sync with the tip
+        void OnSynced();
+
+    private:
+        Wallet& m_Wallet;
+        IWalletDB::Ptr m_WalletDB;
+        Policy m_Policy;
+
+        static const char s_szPolicy[];
+        static const char s_szFeeSpent[];
+        static const char s_szLastHeight[];
+        static const char s_szTxID[];
+        static const char s_szAddress[];
+
+        bool IsTxActive();
+        WalletID get_Address();
+    };
+}
@@ -97,6 +97,7 @@ namespace beam::wallet
 
     Wallet::Wallet(IWalletDB::Ptr walletDB, TxCompletedAction&& action, UpdateCompletedAction&& updateCompleted)
         : m_WalletDB{ walletDB }
+        , m_Consolidator(*this, walletDB)
         , m_TxCompletedAction{ move(action) }
         , m_UpdateCompleted{ move(updateCompleted) }
         , m_LastSyncTotal(0)
@@ -714,13 +715,113 @@ namespace beam::wallet
             DeleteReq(*m_PendingEvents.begin());
     }
 
+    struct Wallet::UtxoEventsBatch
+    {
+        // Events are applied to the coins in memory. The coins are saved at once
+        Wallet& m_This;
+
+        struct CoinIDLess
+        {
+            bool operator()(const CoinID& a, const CoinID& b) const
+            {
+                int n = a.cmp(b);
+                if (n)
+                    return n < 0;
+                if (a.m_Value != b.m_Value)
+                    return a.m_Value < b.m_Value;
+                return a.m_AssetID < b.m_AssetID;
+            }
+        };
+
+        std::vector<Coin> m_vCoins;
+        std::map<CoinID, size_t, CoinIDLess> m_mapCoins; // index in m_vCoins
+
+        std::map<Key::ID, TxID> m_mapActiveInputs; // coins being spent by the active txs
+        bool m_ActiveInputsReady = false;
+
+        UtxoEventsBatch(Wallet& x) :m_This(x) {}
+
+        void InitActiveInputs()
+        {
+            m_ActiveInputsReady = true;
+
+            for (const auto& [txid, txptr] : m_This.m_ActiveTransactions)
+            {
+                std::vector<Coin::ID> icoins;
+                txptr->GetParameter(TxParameterID::InputCoins, icoins);
+
+                for (const auto& cid : icoins)
+                    m_mapActiveInputs[cid] = txid;
+            }
+        }
+
+        void Add(const CoinID& cid, Height h, Height hMaturity, bool bAdd)
+        {
+            bool bExists = true;
+
+            auto itC = m_mapCoins.find(cid);
+            if (m_mapCoins.end() == itC)
+            {
+                Coin c;
+                c.m_ID = cid;
+                bExists = m_This.m_WalletDB->findCoin(c);
+
+                itC = m_mapCoins.emplace(cid, m_vCoins.size()).first;
+                m_vCoins.push_back(std::move(c));
+            }
+
+            Coin& c = m_vCoins[itC->second];
+            c.m_maturity = hMaturity;
+
+            LOG_INFO() << "CoinID: " << c.m_ID << " Maturity=" << hMaturity << (bAdd ? " Confirmed" : " Spent") << ", Height=" << h;
+
+            if (bAdd)
+            {
+                std::setmin(c.m_confirmHeight, h); // in case of std utxo proofs - the event height may be bigger than actual utxo height
+
+                // Check if this Coin participates in any active transaction
+                // if it does and mark it as outgoing (bug: ux_504)
+                if (!m_ActiveInputsReady)
+                    InitActiveInputs();
+
+                auto itTx = m_mapActiveInputs.find(c.m_ID);
+                if (m_mapActiveInputs.end() != itTx)
+                {
+                    c.m_status = Coin::Status::Outgoing;
+                    c.m_spentTxId = itTx->second;
+                    LOG_INFO() << "CoinID: " << c.m_ID << " marked as Outgoing";
+                }
+            }
+            else
+            {
+                if (!bExists)
+                {
+                    // should alert!
+                    m_vCoins.pop_back();
+                    m_mapCoins.erase(itC);
+                    return;
+                }
+
+                std::setmin(c.m_spentHeight, h); // reported spend height may be bigger than it actuall was (in case of macroblocks)
+            }
+        }
+
+        void Flush()
+        {
+            m_This.m_WalletDB->saveCoins(m_vCoins);
+            m_vCoins.clear();
+            m_mapCoins.clear();
+        }
+    };
+
     void Wallet::OnRequestComplete(MyRequestEvents& r)
     {
         struct MyParser
             :public proto::Event::IGroupParser
         {
             Wallet& m_This;
-            MyParser(Wallet& x) :m_This(x) {}
+            UtxoEventsBatch m_Batch;
+            MyParser(Wallet& x) :m_This(x), m_Batch(x) {}
 
             virtual void OnEvent(proto::Event::Base& evt_) override
             {
@@ -735,11 +836,12 @@ namespace beam::wallet
                     return;
 
                 bool bAdd = 0 != (proto::Event::Flags::Add & evt.m_Flags);
-                m_This.ProcessEventUtxo(evt.m_Cid, m_Height, evt.m_Maturity, bAdd);
+                m_Batch.Add(evt.m_Cid, m_Height, evt.m_Maturity, bAdd);
             }
         } p(*this);
         
         uint32_t nCount = p.Proceed(r.m_Res.m_Events);
+        p.m_Batch.Flush(); // all the coins are saved at once, with a single notification
 
         if (nCount < proto::Event::s_Max)
         {
@@ -775,41 +877,9 @@ namespace beam::wallet
 
     void Wallet::ProcessEventUtxo(const CoinID& cid, Height h, Height hMaturity, bool bAdd)
     {
-        Coin c;
-        c.m_ID = cid;
-
-        bool bExists = m_WalletDB->findCoin(c);
-        c.m_maturity = hMaturity;
-
-        LOG_INFO() << "CoinID: " << c.m_ID << " Maturity=" << hMaturity << (bAdd ? " Confirmed" : " Spent") << ", Height=" << h;
-
-        if (bAdd)
-        {
-            std::setmin(c.m_confirmHeight, h); // in case of std utxo proofs - the event height may be bigger than actual utxo height
-
-            // Check if this Coin participates in any active transaction
-            // if it does and mark it as outgoing (bug: ux_504)
-            for (const auto& [txid, txptr] : m_ActiveTransactions)
-            {
-                std::vector<Coin::ID> icoins;
-                txptr->GetParameter(TxParameterID::InputCoins, icoins);
-                if (std::find(icoins.begin(), icoins.end(), c.m_ID) != icoins.end())
-                {
-                    c.m_status = Coin::Status::Outgoing;
-                    c.m_spentTxId = txid;
-                    LOG_INFO() << "CoinID: " << c.m_ID << " marked as Outgoing";
-                }
-            }
-        }
-        else
-        {
-            if (!bExists)
-                return; // should alert!
-
-            std::setmin(c.m_spentHeight, h); // reported spend height may be bigger than it actuall was (in case of macroblocks)
-        }
-
-        m_WalletDB->saveCoin(c);
+        UtxoEventsBatch b(*this);
+        b.Add(cid, h, hMaturity, bAdd);
+        b.Flush();
     }
 
     void Wallet::OnRolledBack()
@@ -930,6 +1000,9 @@ namespace beam::wallet
         m_LastSyncTotal = 0;
 
         saveKnownState();
+
+        if (IsWalletInSync())
+            m_Consolidator.OnSynced();
     }
 
     void Wallet::saveKnownState()
@@ -17,6 +17,7 @@
 #include "wallet_db.h"
 #include "common.h"
 #include "base_transaction.h"
+#include "utxo_consolidator.h"
 #include "core/fly_client.h"
 
 namespace beam::wallet
@@ -128,6 +129,8 @@ namespace beam::wallet
 
         // Count of active transactions which are not in safe state, negotiation are not finished or data is not sent to node
         size_t GetUnsafeActiveTransactionsCount() const;
+
+        UtxoConsolidator& GetConsolidator() { return m_Consolidator; }
     protected:
         void SendTransactionToNode(const TxID& txId, Transaction::Ptr, SubTxID subTxID);
     private:
@@ -180,6 +183,7 @@ namespace beam::wallet
         void RequestEvents();
         void AbortEvents();
         void ProcessEventUtxo(const CoinID&, Height h, Height hMaturity, bool bAdd);
+        struct UtxoEventsBatch;
         void SetEventsHeight(Height);
         Height GetEventsHeightNext();
 
@@ -286,6 +290,8 @@ namespace beam::wallet
 
 
         IWalletDB::Ptr m_WalletDB; 
+
+        UtxoConsolidator m_Consolidator;
         
         std::shared_ptr<proto::FlyClient::INetwork> m_NodeEndpoint;
 
@@ -67,6 +67,7 @@
 #define VARIABLES_NAME "variables"
 #define ADDRESSES_NAME "addresses"
 #define TX_PARAMS_NAME "txparams"
+#define TX_SUMMARY_NAME "txsummary"
 #define PRIVATE_VARIABLES_NAME "PrivateVariables"
 #define WALLET_MESSAGE_NAME "WalletMessages"
 #define INCOMING_WALLET_MESSAGE_NAME "IncomingWalletMessages"
@@ -101,6 +102,15 @@
 
 #define TX_PARAMS_FIELDS ENUM_TX_PARAMS_FIELDS(LIST, COMMA, )
 
+// indexed columns of the tx parameters, mirrored by setTxParameter
+#define ENUM_TX_SUMMARY_FIELDS(each, sep, obj) \
+    each(txID,           txID,           BLOB NOT NULL PRIMARY KEY, obj) sep \
+    each(txType,         txType,         INTEGER, obj) sep \
+    each(status,         status,         INTEGER, obj) sep \
+    each(createTime,     createTime,     INTEGER, obj) sep \
+    each(amount,         amount,         INTEGER, obj) sep \
+    each(assetID,        assetID,        INTEGER, obj)
+
 #define ENUM_WALLET_MESSAGE_FIELDS(each, sep, obj) \
     each(ID,  ID,  INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, obj) sep \
     each(PeerID, PeerID,   BLOB, obj) sep \
@@ -219,6 +229,7 @@ namespace beam::wallet
             }
 
             static const uint32_t s_Factor = 16;
+            static const size_t s_MaxCoins = 1000; // bigger sets are cut to the largest coins, once they cover the amount
 
             struct Partial
             {
@@ -766,7 +777,8 @@ namespace beam::wallet
         const char* SystemStateIDName = "SystemStateID";
         const char* LastUpdateTimeName = "LastUpdateTime";
         const int BusyTimeoutMs = 5000;
-        const int DbVersion   = 19;
+        const int DbVersion   = 20;
+        const int DbVersion19 = 19;
         const int DbVersion18 = 18;
         const int DbVersion17 = 17;
         const int DbVersion16 = 16;
@@ -977,6 +989,16 @@ namespace beam::wallet
             throwIfError(ret, db);
         }
 
+        void CreateTxSummaryTable(sqlite3* db)
+        {
+            const char* req = "CREATE TABLE " TX_SUMMARY_NAME " (" ENUM_TX_SUMMARY_FIELDS(LIST_WITH_TYPES, COMMA, ) ") WITHOUT ROWID;"
+                              "CREATE INDEX TxSummaryTimeIndex ON " TX_SUMMARY_NAME "(createTime DESC, txID);"
+                              "CREATE INDEX TxSummaryTypeIndex ON " TX_SUMMARY_NAME "(txType, createTime DESC, txID);"
+                              "CREATE INDEX TxSummaryStatusIndex ON " TX_SUMMARY_NAME "(status, createTime DESC, txID);";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
         void CreateStatesTable(sqlite3* db)
         {
             const char* req = "CREATE TABLE [" TblStates "] ("
@@ -1122,6 +1144,7 @@ namespace beam::wallet
         CreateVariablesTable(db);
         CreateAddressesTable(db);
         CreateTxParamsTable(db);
+        CreateTxSummaryTable(db);
         CreateStatesTable(db);
         CreateLaserTables(db);
         CreateAssetsTable(db);
@@ -1581,6 +1604,12 @@ namespace beam::wallet
                 case DbVersion18:
                     LOG_INFO() << "Converting DB from format 18...";
                     CreateNotificationsTable(walletDB->_db);
+                    // no break
+
+                case DbVersion19:
+                    LOG_INFO() << "Converting DB from format 19...";
+                    CreateTxSummaryTable(walletDB->_db);
+                    walletDB->fillTxSummary();
                     storage::setVar(*walletDB, Version, DbVersion);
                     // no break
 
@@ -1850,6 +1879,22 @@ namespace beam::wallet
         {
             IWalletDB& m_This;
             IRecoveryProgress& m_Progr;
+            std::vector<Coin> m_vCoins; // recognized, saved in bulk
+
+            struct CoinIDLess
+            {
+                bool operator()(const CoinID& a, const CoinID& b) const
+                {
+                    int n = a.cmp(b);
+                    if (n)
+                        return n < 0;
+                    if (a.m_Value != b.m_Value)
+                        return a.m_Value < b.m_Value;
+                    return a.m_AssetID < b.m_AssetID;
+                }
+            };
+
+            std::map<CoinID, size_t, CoinIDLess> m_mapCoins; // index in m_vCoins
 
             MyParser(IWalletDB& db, IRecoveryProgress& progr)
                 :m_This(db)
@@ -1859,7 +1904,11 @@ namespace beam::wallet
 
             virtual bool OnProgress(uint64_t nPos, uint64_t nTotal) override
             {
-                return m_Progr.OnProgress(nPos, nTotal);
+                if (m_Progr.OnProgress(nPos, nTotal))
+                    return true;
+
+                Flush(); // stopped, keep what's recognized
+                return false;
             }
 
             virtual bool OnStates(std::vector<Block::SystemState::Full>& vec) override
@@ -1874,26 +1923,54 @@ namespace beam::wallet
             {
                 if (m_This.IsRecoveredMatch(cid, outp.m_Commitment))
                 {
-                    Coin c;
-                    c.m_ID = cid;
-                    m_This.findCoin(c); // in case it exists already - fill its parameters
+                    // in case it exists already (pending or in the DB) - fill its parameters
+                    std::map<CoinID, size_t, CoinIDLess>::iterator it = m_mapCoins.find(cid);
+                    if (m_mapCoins.end() == it)
+                    {
+                        Coin c;
+                        c.m_ID = cid;
+                        m_This.findCoin(c);
+
+                        it = m_mapCoins.emplace(cid, m_vCoins.size()).first;
+                        m_vCoins.push_back(std::move(c));
+                    }
 
+                    Coin& c = m_vCoins[it->second];
                     c.m_maturity = outp.get_MinMaturity(h);
                     c.m_confirmHeight = h;
 
                     LOG_INFO() << "CoinID: " << c.m_ID << " Maturity=" << c.m_maturity << " Recovered";
 
-                    m_This.saveCoin(c);
+                    if (m_vCoins.size() >= 1024)
+                        Flush();
                 }
 
                 return true;
             }
+
+            void Flush()
+            {
+                if (m_vCoins.empty())
+                    return;
+
+                m_This.saveCoins(m_vCoins);
+                m_vCoins.clear();
+                m_mapCoins.clear();
+            }
         };
 
+        // Outputs are recognized in parallel. The coins are written within the same pending DB transaction,
+        // which isn't committed before the reactor gets control back
+        ExecutorMT_Std ex;
+
         MyParser p(*this, prog);
         p.m_pOwner = get_OwnerKdf();
+        p.m_pExecutor = &ex;
+
+        bool bRet = p.Proceed(path.c_str());
+        p.Flush();
 
-        return p.Proceed(path.c_str());
+        return bRet;
 	}
 
     void IWalletDB::get_SbbsPeerID(ECC::Scalar::Native& sk, PeerID& pid, uint64_t ownID)
@@ -1951,35 +2028,118 @@ namespace beam::wallet
         pid = ECC::Point(pt).m_X;
     }
 
-    vector<Coin> WalletDB::selectCoins(Amount amount, Asset::ID assetId)
+    bool WalletDB::CoinIndex::IsCandidate(const Coin& c)
     {
-        vector<Coin> coins, coinsSel;
-        Block::SystemState::ID stateID = {};
-        getSystemStateID(stateID);
+        return (c.m_maturity != MaxHeight) && (c.m_spentHeight == MaxHeight);
+    }
+
+    void WalletDB::CoinIndex::Reset()
+    {
+        m_Assets.clear();
+        m_Loaded = false;
+    }
+
+    void WalletDB::CoinIndex::Update(const Coin& c)
+    {
+        Coins& coins = m_Assets[c.m_ID.m_AssetID];
+        if (IsCandidate(c))
+            coins[c.m_ID] = c;
+        else
+            coins.erase(c.m_ID);
+    }
+
+    void WalletDB::CoinIndex::Remove(const Coin::ID& cid)
+    {
+        auto it = m_Assets.find(cid.m_AssetID);
+        if (m_Assets.end() != it)
+            it->second.erase(cid);
+    }
 
+    const WalletDB::CoinIndex::Coins& WalletDB::get_CoinIndex(Asset::ID assetId)
+    {
+        if (!m_CoinIndex.m_Loaded)
         {
-            sqlite::Statement stm(this, "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " WHERE maturity>=0 AND maturity<=?1 AND spentHeight<0 ORDER BY amount ASC");
-            stm.bind(1, stateID.m_Height);
+            m_CoinIndex.Reset();
 
+            sqlite::Statement stm(this, "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " WHERE maturity>=0 AND spentHeight<0;");
             while (stm.step())
             {
-                auto& coin = coins.emplace_back();
+                Coin coin;
                 int colIdx = 0;
                 ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+                m_CoinIndex.m_Assets[coin.m_ID.m_AssetID].emplace(coin.m_ID, coin);
+            }
 
-                storage::DeduceStatus(*this, coin, stateID.m_Height);
-                if (Coin::Status::Available != coin.m_status)
-                    coins.pop_back();
-                else if (coin.m_ID.m_AssetID != assetId)
-                    coins.pop_back();
-                else
-                {
-                    if (coin.m_ID.m_Value >= amount)
-                        break;
-                }
+            m_CoinIndex.m_Loaded = true;
+        }
+
+        return m_CoinIndex.m_Assets[assetId];
+    }
+
+    vector<Coin> WalletDB::selectCoins(Amount amount, Asset::ID assetId)
+    {
+        vector<Coin> coins, coinsSel;
+        Block::SystemState::ID stateID = {};
+        getSystemStateID(stateID);
+
+        auto fnAdd = [&](const Coin& c)
+        {
+            if (!c.m_ID.m_Value || (c.m_maturity > stateID.m_Height))
+                return false;
+
+            auto& coin = coins.emplace_back(c);
+
+            storage::DeduceStatus(*this, coin, stateID.m_Height);
+            if (Coin::Status::Available == coin.m_status)
+                return true;
+
+            coins.pop_back();
+            return false;
+        };
+
+        const CoinIndex::Coins& index = get_CoinIndex(assetId);
+
+        Coin::ID cidCover(Zero);
+        cidCover.m_Value = amount;
+        auto itCover = index.lower_bound(cidCover);
+
+        // the smallest coin that covers the amount alone
+        for (auto it = itCover; index.end() != it; ++it)
+            if (fnAdd(it->second))
+                break;
+
+        // smaller coins, from the largest
+        Amount sum = 0;
+        Amount vPrev = 0;
+        Amount nSame = 0;
+        for (auto it = itCover; index.begin() != it; )
+        {
+            const Coin& c = (--it)->second;
+            Amount v = c.m_ID.m_Value;
+
+            if (v != vPrev)
+            {
+                vPrev = v;
+                nSame = 0;
+            }
+            else
+            {
+                if (nSame > amount / v)
+                    continue; // more equal coins than the amount may ever need
             }
+
+            if (!fnAdd(c))
+                continue;
+
+            nSame++;
+            sum += v;
+
+            if ((coins.size() > CoinSelector3::s_MaxCoins) && (sum >= amount))
+                break;
         }
 
+        std::reverse(coins.begin(), coins.end());
+
         CoinSelector3 csel(coins);
         CoinSelector3::Result res = csel.Select(amount);
 
@@ -1994,6 +2154,34 @@ namespace beam::wallet
         return coinsSel;
     }
 
+    vector<Coin> WalletDB::selectSmallestCoins(uint32_t nMax, Amount maxValue, Asset::ID assetId)
+    {
+        vector<Coin> coins;
+        Block::SystemState::ID stateID = {};
+        getSystemStateID(stateID);
+
+        for (const auto& x : get_CoinIndex(assetId))
+        {
+            if (coins.size() >= nMax)
+                break;
+
+            const Coin& c = x.second;
+            if (maxValue && (c.m_ID.m_Value >= maxValue))
+                break;
+
+            if (c.m_maturity > stateID.m_Height)
+                continue;
+
+            auto& coin = coins.emplace_back(c);
+
+            storage::DeduceStatus(*this, coin, stateID.m_Height);
+            if (Coin::Status::Available != coin.m_status)
+                coins.pop_back();
+        }
+
+        return coins;
+    }
+
     std::vector<Coin> WalletDB::getCoinsCreatedByTx(const TxID& txId) const
     {
         // select all coins for TxID
@@ -2437,65 +2625,142 @@ namespace beam::wallet
 
     vector<TxDescription> WalletDB::getTxHistory(wallet::TxType txType, uint64_t start, int count) const
     {
-        // TODO this is temporary solution
-        int txCount = 0;
-        {
-            std::string req = "SELECT COUNT(DISTINCT txID) FROM " TX_PARAMS_NAME " WHERE paramID = ?1";
-            req += (txType != wallet::TxType::ALL) ? " AND value = ?2 ;" : " ;";
-
-            sqlite::Statement stm(this, req.c_str());
-            stm.bind(1, wallet::TxParameterID::TransactionType);
+        TxHistoryFilter filter;
+        filter.m_Type = txType;
+        return getTxHistory(filter, start, count);
+    }
+
+    vector<TxDescription> WalletDB::getTxHistory(const TxHistoryFilter& filter, uint64_t start, int count) const
+    {
+        // txs deleted by deleteTx keep the type only, they have no create time
+        std::string req = "SELECT txID FROM " TX_SUMMARY_NAME " WHERE createTime IS NOT NULL";
+        if (filter.m_Type != wallet::TxType::ALL)
+            req += " AND txType=?1";
+        if (filter.m_Status)
+            req += " AND status=?2";
+        if (filter.m_AssetID)
+            req += " AND assetID=?3";
+        if (filter.m_MinCreateTime)
+            req += " AND createTime>=?4";
+        if (filter.m_MaxCreateTime)
+            req += " AND createTime<=?5";
+        if (filter.m_After)
+            req += " AND (createTime<?6 OR (createTime=?6 AND txID>?7))";
+        req += " ORDER BY createTime DESC, txID LIMIT ?8 OFFSET ?9;";
 
-            ByteBuffer typeBlob;
-            if (txType != wallet::TxType::ALL)
-            {
-                typeBlob = toByteBuffer(txType);
-                stm.bind(2, typeBlob);
-            }
-
-            stm.step();
-            stm.get(0, txCount);
-        }
+        sqlite::Statement stm(this, req.c_str());
+        if (filter.m_Type != wallet::TxType::ALL)
+            stm.bind(1, filter.m_Type);
+        if (filter.m_Status)
+            stm.bind(2, *filter.m_Status);
+        if (filter.m_AssetID)
+            stm.bind(3, *filter.m_AssetID);
+        if (filter.m_MinCreateTime)
+            stm.bind(4, *filter.m_MinCreateTime);
+        if (filter.m_MaxCreateTime)
+            stm.bind(5, *filter.m_MaxCreateTime);
+        if (filter.m_After)
+        {
+            stm.bind(6, filter.m_After->m_CreateTime);
+            stm.bind(7, filter.m_After->m_TxID);
+        }
+        stm.bind(8, count);
+        stm.bind(9, start);
 
         vector<TxDescription> res;
-        if (txCount > 0)
+        while (stm.step())
         {
-            res.reserve(static_cast<size_t>(min(txCount, count)));
-            std::string req = "SELECT DISTINCT txID FROM " TX_PARAMS_NAME;
-
-            if (txType != wallet::TxType::ALL)
+            TxID txID;
+            stm.get(0, txID);
+            auto t = getTx(txID);
+            if (t.is_initialized())
             {
-                req += " WHERE paramID = ?3 AND value = ?4";
+                res.emplace_back(*t);
             }
+        }
 
-            req += " LIMIT ?1 OFFSET ?2 ;";
+        return res;
+    }
 
-            sqlite::Statement stm(this, req.c_str());
-            stm.bind(1, count);
-            stm.bind(2, start);
+    void WalletDB::updateTxSummary(const TxID& txID, TxParameterID paramID, const ByteBuffer& blob)
+    {
+        const char* req = nullptr;
+        uint64_t value = 0;
+        bool ok = false;
 
-            ByteBuffer typeBlob;
-            if (txType != wallet::TxType::ALL)
+        switch (paramID)
+        {
+        case TxParameterID::TransactionType:
             {
-                stm.bind(3, wallet::TxParameterID::TransactionType);
-                typeBlob = toByteBuffer(txType);
-                stm.bind(4, typeBlob);
+                TxType x;
+                ok = fromByteBuffer(blob, x);
+                value = static_cast<uint64_t>(x);
+                req = "UPDATE " TX_SUMMARY_NAME " SET txType=?2 WHERE txID=?1;";
             }
-
-            while (stm.step())
+            break;
+        case TxParameterID::Status:
             {
-                TxID txID;
-                stm.get(0, txID);
-                auto t = getTx(txID);
-                if (t.is_initialized())
-                {
-                    res.emplace_back(*t);
-                }
+                TxStatus x;
+                ok = fromByteBuffer(blob, x);
+                value = static_cast<uint64_t>(x);
+                req = "UPDATE " TX_SUMMARY_NAME " SET status=?2 WHERE txID=?1;";
+            }
+            break;
+        case TxParameterID::CreateTime:
+            ok = fromByteBuffer(blob, value);
+            req = "UPDATE " TX_SUMMARY_NAME " SET createTime=?2 WHERE txID=?1;";
+            break;
+        case TxParameterID::Amount:
+            ok = fromByteBuffer(blob, value);
+            req = "UPDATE " TX_SUMMARY_NAME " SET amount=?2 WHERE txID=?1;";
+            break;
+        case TxParameterID::AssetID:
+            {
+                Asset::ID x;
+                ok = fromByteBuffer(blob, x);
+                value = x;
+                req = "UPDATE " TX_SUMMARY_NAME " SET assetID=?2 WHERE txID=?1;";
             }
-            sort(res.begin(), res.end(), [](const auto& left, const auto& right) {return left.m_createTime > right.m_createTime; });
+            break;
+        default:
+            return; // not indexed
         }
 
-        return res;
+        if (!ok)
+            return;
+
+        {
+            sqlite::Statement stm(this, "INSERT OR IGNORE INTO " TX_SUMMARY_NAME " (txID) VALUES(?1);");
+            stm.bind(1, txID);
+            stm.step();
+        }
+
+        sqlite::Statement stm(this, req);
+        stm.bind(1, txID);
+        stm.bind(2, value);
+        stm.step();
+    }
+
+    void WalletDB::fillTxSummary()
+    {
+        sqlite::Statement stm(this, "SELECT txID, paramID, value FROM " TX_PARAMS_NAME " WHERE subTxID=?1 AND paramID IN (?2, ?3, ?4, ?5, ?6);");
+        stm.bind(1, kDefaultSubTxID);
+        stm.bind(2, TxParameterID::TransactionType);
+        stm.bind(3, TxParameterID::Status);
+        stm.bind(4, TxParameterID::CreateTime);
+        stm.bind(5, TxParameterID::Amount);
+        stm.bind(6, TxParameterID::AssetID);
+
+        while (stm.step())
+        {
+            TxID txID;
+            int paramID = 0;
+            ByteBuffer blob;
+            stm.get(0, txID);
+            stm.get(1, paramID);
+            stm.get(2, blob);
+            updateTxSummary(txID, static_cast<TxParameterID>(paramID), blob);
+        }
     }
     
     boost::optional<TxDescription> WalletDB::getTx(const TxID& txId) const
@@ -2632,6 +2897,11 @@ namespace beam::wallet
             stm.bind(2, TxParameterID::TransactionType);
 
             stm.step();
+
+            sqlite::Statement stm2(this, "UPDATE " TX_SUMMARY_NAME " SET status=NULL, createTime=NULL, amount=NULL, assetID=NULL WHERE txID=?1;");
+            stm2.bind(1, txId);
+            stm2.step();
+
             deleteParametersFromCache(txId);
             notifyTransactionChanged(ChangeAction::Removed, { *tx });
         }
@@ -3117,6 +3387,11 @@ namespace beam::wallet
                 stm2.bind(4, blob);
                 stm2.step();
 
+                if (subTxID == kDefaultSubTxID)
+                {
+                    updateTxSummary(txID, paramID, blob);
+                }
+
                 if (shouldNotifyAboutChanges)
                 {
                     auto tx = getTx(txID);
@@ -3139,6 +3414,10 @@ namespace beam::wallet
         int colIdx = 0;
         ENUM_TX_PARAMS_FIELDS(STM_BIND_LIST, NOSEP, parameter);
         stm.step();
+        if (subTxID == kDefaultSubTxID)
+        {
+            updateTxSummary(txID, paramID, blob);
+        }
         if (shouldNotifyAboutChanges)
         {
             auto tx = getTx(txID);
@@ -3251,6 +3530,7 @@ namespace beam::wallet
                 m_DbTransaction->rollback();
                 m_DbTransaction.reset();
             }
+            m_CoinIndex.Reset(); // may contain the rolled back changes
         }
     }
 
@@ -3291,6 +3571,25 @@ namespace beam::wallet
 
     void WalletDB::notifyCoinsChanged(ChangeAction action, const vector<Coin>& items)
     {
+        if (m_CoinIndex.m_Loaded)
+        {
+            switch (action)
+            {
+            case ChangeAction::Reset:
+                m_CoinIndex.Reset();
+                break;
+
+            case ChangeAction::Removed:
+                for (const auto& c : items)
+                    m_CoinIndex.Remove(c.m_ID);
+                break;
+
+            default:
+                for (const auto& c : items)
+                    m_CoinIndex.Update(c);
+            }
+        }
+
         if (items.empty() && action != ChangeAction::Reset)
             return;
 
@@ -3380,6 +3679,11 @@ namespace beam::wallet
 
         stm.step();
 
+        for (auto& x : m_CoinIndex.m_Assets)
+            for (auto& y : x.second)
+                if (y.second.m_sessionId == session)
+                    y.second.m_sessionId = 0;
+
         return sqlite3_changes(_db) > 0;
     }
 
@@ -191,6 +191,24 @@ namespace beam::wallet
         ByteBuffer m_value;
     };
 
+    // Selection of the indexed tx history, the result is ordered by create time, newest first.
+    // For keyset pagination pass the last tx of the previous page in m_After
+    struct TxHistoryFilter
+    {
+        struct Cursor
+        {
+            Timestamp m_CreateTime;
+            TxID m_TxID;
+        };
+
+        TxType m_Type = TxType::ALL;
+        boost::optional<TxStatus> m_Status;
+        boost::optional<Asset::ID> m_AssetID;
+        boost::optional<Timestamp> m_MinCreateTime;
+        boost::optional<Timestamp> m_MaxCreateTime;
+        boost::optional<Cursor> m_After;
+    };
+
     // Outgoing wallet messages sent through SBBS (used in Cold Wallet)
     struct OutgoingWalletMessage
     {
@@ -327,6 +345,8 @@ namespace beam::wallet
         // Selection logic will optimize for number of UTXOs and minimize change
         // Uses greedy algorithm up to a point and follows by some heuristics
         virtual std::vector<Coin> selectCoins(Amount amount, Asset::ID) = 0;
+        // Returns up to nMax smallest available coins, below maxValue if it's not zero
+        virtual std::vector<Coin> selectSmallestCoins(uint32_t nMax, Amount maxValue, Asset::ID) = 0;
 
         // Some getters to get lists of coins by some input parameters
         virtual std::vector<Coin> getCoinsCreatedByTx(const TxID& txId) const = 0;
@@ -364,6 +384,7 @@ namespace beam::wallet
         // /////////////////////////////////////////////
         // Transaction management
         virtual std::vector<TxDescription> getTxHistory(wallet::TxType txType = wallet::TxType::Simple, uint64_t start = 0, int count = std::numeric_limits<int>::max()) const = 0;
+        virtual std::vector<TxDescription> getTxHistory(const TxHistoryFilter& filter, uint64_t start, int count) const = 0;
         virtual boost::optional<TxDescription> getTx(const TxID& txId) const = 0;
         virtual void saveTx(const TxDescription& p) = 0;
         virtual void deleteTx(const TxID& txId) = 0;
@@ -454,6 +475,7 @@ namespace beam::wallet
 
         uint64_t AllocateKidRange(uint64_t nCount) override;
         std::vector<Coin> selectCoins(Amount amount, Asset::ID) override;
+        std::vector<Coin> selectSmallestCoins(uint32_t nMax, Amount maxValue, Asset::ID) override;
 
         std::vector<Coin> getCoinsCreatedByTx(const TxID& txId) const override;
         std::vector<Coin> getCoinsByTx(const TxID& txId) const override;
@@ -482,6 +504,7 @@ namespace beam::wallet
         void rollbackConfirmedUtxo(Height minHeight) override;
 
         std::vector<TxDescription> getTxHistory(wallet::TxType txType, uint64_t start, int count) const override;
+        std::vector<TxDescription> getTxHistory(const TxHistoryFilter& filter, uint64_t start, int count) const override;
         boost::optional<TxDescription> getTx(const TxID& txId) const override;
         void saveTx(const TxDescription& p) override;
         void deleteTx(const TxID& txId) override;
@@ -562,6 +585,8 @@ namespace beam::wallet
         void insertParameterToCache(const TxID& txID, SubTxID subTxID, TxParameterID paramID, const boost::optional<ByteBuffer>& blob) const;
         void deleteParametersFromCache(const TxID& txID);
         bool hasTransaction(const TxID& txID) const;
+        void updateTxSummary(const TxID& txID, TxParameterID paramID, const ByteBuffer& blob);
+        void fillTxSummary();
         void insertAddressToCache(const WalletID& id, const boost::optional<WalletAddress>& address) const;
         void deleteAddressFromCache(const WalletID& id);
         void flushDB();
@@ -600,6 +625,33 @@ namespace beam::wallet
         mutable ParameterCache m_TxParametersCache;
         mutable std::map<WalletID, boost::optional<WalletAddress>> m_AddressesCache;
 
+        // Confirmed unspent coins, per asset, in ascending order of value. Used by selectCoins.
+        // Loaded on first use, then follows the coin changes reported to the observers
+        struct CoinIndex
+        {
+            struct ByValue
+            {
+                bool operator()(const Coin::ID& a, const Coin::ID& b) const
+                {
+                    if (a.m_Value != b.m_Value)
+                        return a.m_Value < b.m_Value;
+                    return a.cmp(b) < 0;
+                }
+            };
+
+            typedef std::map<Coin::ID, Coin, ByValue> Coins;
+
+            std::map<Asset::ID, Coins> m_Assets;
+            bool m_Loaded = false;
+
+            static bool IsCandidate(const Coin&);
+            void Reset();
+            void Update(const Coin&);
+            void Remove(const Coin::ID&);
+        } m_CoinIndex;
+
+        const CoinIndex::Coins& get_CoinIndex(Asset::ID);
+
         struct LocalKeyKeeper;
         LocalKeyKeeper* m_pLocalKeyKeeper = nullptr;
     };
@@ -69,6 +69,9 @@ namespace beam::wallet {
         Addr::Channel key;
         key.m_Value = channel;
 
+        proto::Bbs::Decryptor dec(msg.empty() ? nullptr : &msg.front(), static_cast<uint32_t>(msg.size()));
+        ByteBuffer buf;
+
         for (ChannelSet::iterator it = m_Channels.lower_bound(key); ; ++it)
         {
             if (m_Channels.end() == it)
@@ -85,11 +88,7 @@ namespace beam::wallet {
                 return;
             }
 
-            ByteBuffer buf = msg; // duplicate
-            uint8_t* pMsg = &buf.front();
-            uint32_t nSize = static_cast<uint32_t>(buf.size());
-
-            if (!proto::Bbs::Decrypt(pMsg, nSize, it->get_ParentObj().m_sk))
+            if (!dec.Decrypt(buf, it->get_ParentObj().m_sk, it->get_ParentObj().m_Pk))
                 continue;
 
             SetTxParameter msgWallet;
@@ -97,7 +96,7 @@ namespace beam::wallet {
 
             try {
                 Deserializer der;
-                der.reset(pMsg, nSize);
+                der.reset(buf);
                 der& msgWallet;
                 bValid = true;
             }
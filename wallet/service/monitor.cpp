@@ -202,13 +202,12 @@ namespace
 
             auto range = m_Channels.lower_bound_range(msg.m_Channel);
 
+            proto::Bbs::Decryptor dec(&msg.m_Message.front(), static_cast<uint32_t>(msg.m_Message.size()));
+            ByteBuffer buf;
+
             for (auto it = range.first; it != range.second; ++it)
             {
-                ByteBuffer buf = msg.m_Message; // duplicate
-                uint8_t* pMsg = &buf.front();
-                uint32_t nSize = static_cast<uint32_t>(buf.size());
-
-                if (!proto::Bbs::Decrypt(pMsg, nSize, it->m_PrivateKey))
+                if (!dec.Decrypt(buf, it->m_PrivateKey, it->m_Address.m_Pk))
                     continue;
 
                 SetTxParameter msgWallet;
@@ -217,7 +216,7 @@ namespace
                 try 
                 {
                     Deserializer der;
-                    der.reset(pMsg, nSize);
+                    der.reset(buf);
                     der& msgWallet;
                     bValid = true;
                 }
@@ -23,6 +23,10 @@
 #include <map>
 #include <queue>
 #include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "utility/message_queue.h"
 
 #include "utility/cli/options.h"
 #include "utility/helpers.h"
@@ -44,6 +48,7 @@
 
 #include "keykeeper/wasm_key_keeper.h"
 #include "pipe.h"
+#include "shared_network.h"
 
 #include "websocket_server.h"
 
@@ -171,18 +176,96 @@ namespace
         LOG_ERROR() << what << ": " << ec.message();
     }
 
+    // Runs its own reactor in a dedicated thread. Sessions are pinned to the workers,
+    // so the wallets (with their db and node network) are isolated from the ones of the other workers
+    class ServiceWorker
+    {
+    public:
+        using Ptr = std::unique_ptr<ServiceWorker>;
+
+        explicit ServiceWorker(const SharedNodeNetwork::Config& cfg)
+            : _reactor(io::Reactor::create())
+            , _nodeNetwork(cfg)
+            , _tasks(*_reactor, [](std::function<void()>&& task) { task(); task = nullptr; })
+            , _tasksTx(_tasks.get_tx())
+        {
+        }
+
+        ~ServiceWorker()
+        {
+            stop();
+        }
+
+        void start()
+        {
+            _thread = std::thread([this] () { run(); });
+        }
+
+        void stop()
+        {
+            if (_thread.joinable())
+            {
+                // after the tasks posted so far, the wallets of the closed sessions are destroyed by them
+                post([this] () { _reactor->stop(); });
+                _thread.join();
+            }
+        }
+
+        // runs the task on the worker thread, may be called from any thread
+        void post(std::function<void()>&& task)
+        {
+            _tasksTx.send(std::move(task));
+        }
+
+        io::Reactor::Ptr getReactor() const
+        {
+            return _reactor;
+        }
+
+        SharedNodeNetwork& getNodeNetwork()
+        {
+            return _nodeNetwork;
+        }
+
+    private:
+        void run()
+        {
+            io::Reactor::Scope scope(*_reactor);
+            _nodeNetwork.Connect();
+            _reactor->run();
+        }
+
+        io::Reactor::Ptr _reactor;
+        SharedNodeNetwork _nodeNetwork;
+        RX<std::function<void()>> _tasks;
+        TX<std::function<void()>> _tasksTx;
+        std::thread _thread;
+    };
+
+    using ServiceWorkers = std::vector<ServiceWorker::Ptr>;
+
     class WalletApiServer : public WebSocketServer
     {
         static const int SyncFileDescriptor      = 3;
         static const int HeartbeatFileDescriptor = 4;
         static const int HeartbeatInterval       = 5000;
 
+        struct WalletMap;
+
     public:
 
-        WalletApiServer(io::Reactor::Ptr reactor, uint16_t port)
-            : WebSocketServer(reactor, port,
-            [this, reactor] (auto&& func) {
-                return std::make_unique<ServiceApiConnection>(func, reactor, _walletMap);
+        WalletApiServer(io::Reactor::Ptr reactor, uint16_t port, ServiceWorkers& workers)
+            : WalletApiServer(reactor, port, workers, std::make_shared<WalletMap>())
+        {
+        }
+
+    private:
+        WalletApiServer(io::Reactor::Ptr reactor, uint16_t port, ServiceWorkers& workers, std::shared_ptr<WalletMap> walletMap)
+            : WebSocketServer(getWorkers(workers), port,
+            [walletMap, &workers] (auto&& func, io::Reactor::Ptr workerReactor) {
+                auto it = std::find_if(workers.begin(), workers.end(), [&](const auto& w) { return w->getReactor() == workerReactor; });
+                assert(it != workers.end());
+                return std::make_unique<ServiceApiConnection>(func, workerReactor, walletMap, (*it)->getNodeNetwork());
             },
             [] () {
                 Pipe syncPipe(SyncFileDescriptor);
@@ -196,7 +279,17 @@ namespace
             });
         }
 
-    private:
+        static std::vector<WorkerReactor> getWorkers(const ServiceWorkers& workers)
+        {
+            std::vector<WorkerReactor> res;
+            for (const auto& w : workers)
+            {
+                auto& worker = *w;
+                res.push_back({ worker.getReactor(), [&worker] (std::function<void()>&& task) { worker.post(std::move(task)); } });
+            }
+            return res;
+        }
+
         io::Timer::Ptr _heartbeatTimer;
         Pipe _heartbeatPipe;
 
@@ -206,6 +299,7 @@ namespace
             std::string ownerKey;
             std::weak_ptr<Wallet> wallet;
             std::weak_ptr<IWalletDB> walletDB;
+            io::Reactor* reactor = nullptr; // the wallet is pinned to
 
             WalletInfo(const std::string& ownerKey, Wallet::Ptr wallet, IWalletDB::Ptr walletDB)
                 : ownerKey(ownerKey)
@@ -215,13 +309,17 @@ namespace
             WalletInfo() = default;
         };
 
-        using WalletMap = std::unordered_map<std::string, WalletInfo>;
-
-        WalletMap _walletMap;
+        // shared by the workers. Held by the sessions, that may outlive the server until their workers destroy them
+        struct WalletMap
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, WalletInfo> wallets;
+        };
 
         struct IApiConnectionHandler
         {
             virtual void serializeMsg(const json& msg) = 0;
+            virtual void sendText(const std::string& text) = 0;
             using KeyKeeperFunc = std::function<void(const json&)>;
             virtual void sendAsync(const json& msg, KeyKeeperFunc func) = 0;
         };
@@ -470,6 +568,19 @@ namespace
                 _handler->serializeMsg(msg);
             }
 
+            bool streamMsg(const std::function<void(JsonWriter&)>& fn) override
+            {
+                // the websocket message is sent as a whole
+                std::string text;
+                io::FragmentWriter fw(4096, 0, [&text](io::SharedBuffer&& fragment) { text.append(reinterpret_cast<const char*>(fragment.data), fragment.size); });
+
+                if (!write_json_msg(fw, fn))
+                    return false;
+
+                _handler->sendText(text);
+                return true;
+            }
+
         private:
             IApiConnectionHandler* _handler;
         };
@@ -481,12 +592,13 @@ namespace
             , public IApiConnectionHandler
         {
         public:
-            ServiceApiConnection(WebSocketServer::SendMessageFunc sendFunc, io::Reactor::Ptr reactor, WalletMap& walletMap)
+            ServiceApiConnection(WebSocketServer::SendMessageFunc sendFunc, io::Reactor::Ptr reactor, std::shared_ptr<WalletMap> walletMap, SharedNodeNetwork& nodeNetwork)
                 : _apiConnection(this, *this, boost::none)
                 , _sendFunc(sendFunc)
                 , _reactor(reactor)
                 , _api(*this)
                 , _walletMap(walletMap)
+                , _nodeNetwork(nodeNetwork)
             {
                 assert(_sendFunc);
             }
@@ -517,7 +629,12 @@ namespace
 
             void serializeMsg(const json& msg) override
             {
-                _sendFunc(msg.dump());
+                sendText(msg.dump());
+            }
+
+            void sendText(const std::string& text) override
+            {
+                _sendFunc(text);
             }
 
             void sendAsync(const json& msg, KeyKeeperFunc func) override
@@ -592,7 +709,12 @@ namespace
 
                     if(walletDB)
                     {
-                        _walletMap[dbName] = WalletInfo(data.ownerKey, {}, walletDB);
+                        {
+                            std::unique_lock<std::mutex> lock(_walletMap->mutex);
+                            auto& info = _walletMap->wallets[dbName];
+                            info = WalletInfo(data.ownerKey, {}, walletDB);
+                            info.reactor = _reactor.get();
+                        }
                         // generate default address
                         WalletAddress address;
                         walletDB->createAddress(address);
@@ -611,8 +733,34 @@ namespace
             {
                 LOG_DEBUG() << "OpenWallet(id = " << id << ")";
 
-                auto it = _walletMap.find(data.id);
-                if (it == _walletMap.end())
+                std::string ownerKey;
+                {
+                    std::unique_lock<std::mutex> lock(_walletMap->mutex);
+                    auto it = _walletMap->wallets.find(data.id);
+                    if (it != _walletMap->wallets.end())
+                    {
+                        ownerKey = it->second.ownerKey;
+
+                        if (auto wdb = it->second.walletDB.lock(); wdb)
+                        {
+                            if (it->second.reactor != _reactor.get())
+                            {
+                                lock.unlock();
+                                _apiConnection.doError(id, ApiError::InternalErrorJsonRpc, "Wallet is opened in another session.");
+                                return;
+                            }
+
+                            _walletDB = wdb;
+                            _wallet = it->second.wallet.lock();
+                        }
+                    }
+                }
+
+                if (_walletDB)
+                {
+                    // already opened on this worker
+                }
+                else if (ownerKey.empty())
                 {
                     _walletDB = WalletDB::open(data.id + ".db", SecString(data.pass), createKeyKeeperFromDB(data.id, data.pass));
                     _wallet = std::make_shared<Wallet>(_walletDB);
@@ -622,17 +770,11 @@ namespace
                     ks.SetPassword(Blob(data.pass.data(), static_cast<uint32_t>(data.pass.size())));
                     ks.m_sMeta = std::to_string(0);
                     ks.ExportP(*pKey);
-                    _walletMap[data.id].ownerKey = ks.m_sRes;
-
-                }
-                else if (auto wdb = it->second.walletDB.lock(); wdb)
-                {
-                    _walletDB = wdb;
-                    _wallet = it->second.wallet.lock();
+                    ownerKey = ks.m_sRes;
                 }
                 else
                 {
-                    _walletDB = WalletDB::open(data.id + ".db", SecString(data.pass), createKeyKeeper(data.pass, it->second.ownerKey));
+                    _walletDB = WalletDB::open(data.id + ".db", SecString(data.pass), createKeyKeeper(data.pass, ownerKey));
                     _wallet = std::make_shared<Wallet>(_walletDB);
                 }
                 
@@ -642,36 +784,36 @@ namespace
                     return;
                 }
 
-                _walletMap[data.id].walletDB = _walletDB;
-                _walletMap[data.id].wallet = _wallet;
+                {
+                    std::unique_lock<std::mutex> lock(_walletMap->mutex);
+                    auto& info = _walletMap->wallets[data.id];
+
+                    if (auto wdb = info.walletDB.lock(); wdb && (wdb != _walletDB))
+                    {
+                        // opened concurrently by another session
+                        lock.unlock();
+                        _wallet.reset();
+                        _walletDB.reset();
+                        _apiConnection.doError(id, ApiError::InternalErrorJsonRpc, "Wallet is opened in another session.");
+                        return;
+                    }
+
+                    info.ownerKey = ownerKey;
+                    info.walletDB = _walletDB;
+                    info.wallet = _wallet;
+                    info.reactor = _reactor.get();
+                }
 
                 LOG_INFO() << "wallet sucessfully opened...";
 
                 _wallet->ResumeAllTransactions();
 
-                auto nnet = std::make_shared<proto::FlyClient::NetworkStd>(*_wallet);
-                nnet->m_Cfg.m_PollPeriod_ms = 0;//options.pollPeriod_ms.value;
-            
-                if (nnet->m_Cfg.m_PollPeriod_ms)
-                {
-                    LOG_INFO() << "Node poll period = " << nnet->m_Cfg.m_PollPeriod_ms << " ms";
-                    uint32_t timeout_ms = std::max(Rules::get().DA.Target_s * 1000, nnet->m_Cfg.m_PollPeriod_ms);
-                    if (timeout_ms != nnet->m_Cfg.m_PollPeriod_ms)
-                    {
-                        LOG_INFO() << "Node poll period has been automatically rounded up to block rate: " << timeout_ms << " ms";
-                    }
-                }
-                uint32_t responceTime_s = Rules::get().DA.Target_s * wallet::kDefaultTxResponseTime;
-                if (nnet->m_Cfg.m_PollPeriod_ms >= responceTime_s * 1000)
-                {
-                    LOG_WARNING() << "The \"--node_poll_period\" parameter set to more than " << uint32_t(responceTime_s / 3600) << " hours may cause transaction problems.";
-                }
-                nnet->m_Cfg.m_vNodes.push_back(node_addr);
-                nnet->Connect();
+                auto nnet = _nodeNetwork.CreateEndpoint(*_wallet);
 
                 auto wnet = std::make_shared<WalletNetworkViaBbs>(*_wallet, nnet, _walletDB);
                 _wallet->AddMessageEndpoint(wnet);
                 _wallet->SetNodeEndpoint(nnet);
+                nnet->Connect(); // the wallet is synced with the shared chain right away
 
                 // !TODO: not sure, do we need this id in the future
                 auto session = generateUid();
@@ -752,7 +894,8 @@ namespace
             IWalletDB::Ptr _walletDB;
             Wallet::Ptr _wallet;
             WalletServiceApi _api;
-            WalletMap& _walletMap;
+            std::shared_ptr<WalletMap> _walletMap;
+            SharedNodeNetwork& _nodeNetwork;
         };
 
     };
@@ -774,6 +917,7 @@ int main(int argc, char* argv[])
             std::string nodeURI;
             Nonnegative<uint32_t> pollPeriod_ms;
             uint32_t logCleanupPeriod;
+            uint32_t workerThreads;
 
         } options;
 
@@ -784,6 +928,7 @@ int main(int argc, char* argv[])
                 (cli::PORT_FULL, po::value(&options.port)->default_value(8080), "port to start server on")
                 (cli::NODE_ADDR_FULL, po::value<std::string>(&options.nodeURI), "address of node")
                 (cli::LOG_CLEANUP_DAYS, po::value<uint32_t>(&options.logCleanupPeriod)->default_value(5), "old logfiles cleanup period(days)")
+                (cli::WORKER_THREADS, po::value<uint32_t>(&options.workerThreads)->default_value(0), "number of threads to run the wallets on (0 = number of cores)")
                 (cli::NODE_POLL_PERIOD, po::value<Nonnegative<uint32_t>>(&options.pollPeriod_ms)->default_value(Nonnegative<uint32_t>(0)), "Node poll period in milliseconds. Set to 0 to keep connection. Anyway poll period would be no less than the expected rate of blocks if it is less then it will be rounded up to block rate value.")
             ;
 
@@ -838,9 +983,28 @@ int main(int argc, char* argv[])
 
         LogRotation logRotation(*reactor, LOG_ROTATION_PERIOD, 5);//options.logCleanupPeriod);
 
-        LOG_INFO() << "Starting server on port " << options.port;
-        WalletApiServer server(reactor, options.port);
-        reactor->run();
+        SharedNodeNetwork::Config nodeCfg;
+        nodeCfg.m_NodeAddr = node_addr;
+
+        uint32_t workerThreads = options.workerThreads ? options.workerThreads : std::max(std::thread::hardware_concurrency(), 1U);
+        LOG_INFO() << "Starting " << workerThreads << " worker threads";
+
+        ServiceWorkers workers;
+        for (uint32_t i = 0; i < workerThreads; i++)
+        {
+            workers.push_back(std::make_unique<ServiceWorker>(nodeCfg));
+            workers.back()->start();
+        }
+
+        {
+            LOG_INFO() << "Starting server on port " << options.port;
+            WalletApiServer server(reactor, options.port, workers);
+            reactor->run();
+        }
+
+        // the server is gone, its sessions have posted the destruction of their wallets to the workers
+        for (auto& w : workers)
+            w->stop();
 
         LOG_INFO() << "Done";
     }
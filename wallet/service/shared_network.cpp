@@ -0,0 +1,505 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "shared_network.h"
+
+#include "utility/logger.h"
+
+namespace beam::wallet
+{
+    using namespace proto;
+
+    namespace
+    {
+        FlyClient::Request::Ptr CloneRequest(FlyClient::Request& r)
+        {
+            switch (r.get_Type())
+            {
+#define THE_MACRO(type, msgOut, msgIn) \
+            case FlyClient::Request::Type::type: \
+                { \
+                    FlyClient::Request##type::Ptr pVal(new FlyClient::Request##type); \
+                    pVal->m_Msg = Cast::Up<FlyClient::Request##type>(r).m_Msg; \
+                    return pVal; \
+                }
+
+            REQUEST_TYPES_All(THE_MACRO)
+#undef THE_MACRO
+
+            default: // suppress warning
+                break;
+            }
+
+            return nullptr;
+        }
+
+        void MoveResult(FlyClient::Request& rDst, FlyClient::Request& rSrc)
+        {
+            assert(rDst.get_Type() == rSrc.get_Type());
+
+            switch (rSrc.get_Type())
+            {
+#define THE_MACRO(type, msgOut, msgIn) \
+            case FlyClient::Request::Type::type: \
+                Cast::Up<FlyClient::Request##type>(rDst).m_Res = std::move(Cast::Up<FlyClient::Request##type>(rSrc).m_Res); \
+                break;
+
+            REQUEST_TYPES_All(THE_MACRO)
+#undef THE_MACRO
+
+            default: // suppress warning
+                break;
+            }
+        }
+    }
+
+    SharedNodeNetwork::SharedNodeNetwork(const Config& cfg)
+        : m_Cfg(cfg)
+    {
+        m_pNet.reset(new FlyClient::NetworkStd(*this));
+        for (uint32_t i = 0; i < std::max(m_Cfg.m_Connections, 1U); i++)
+            m_pNet->m_Cfg.m_vNodes.push_back(m_Cfg.m_NodeAddr);
+    }
+
+    SharedNodeNetwork::~SharedNodeNetwork()
+    {
+        m_pNet.reset();
+
+        while (!m_lstRelays.empty())
+        {
+            Relay& x = m_lstRelays.front();
+            m_lstRelays.pop_front();
+            delete &x;
+        }
+
+        assert(m_lstEndpoints.empty()); // must outlive the wallets
+    }
+
+    void SharedNodeNetwork::Connect()
+    {
+        m_pNet->Connect();
+    }
+
+    FlyClient::INetwork::Ptr SharedNodeNetwork::CreateEndpoint(FlyClient& client)
+    {
+        return std::make_shared<Endpoint>(*this, client);
+    }
+
+    void SharedNodeNetwork::PostRequest(Endpoint& ep, Request& r)
+    {
+        ep.m_Queue.push_back(&r);
+        if (!ep.m_hookSchedule.is_linked())
+            m_lstSchedule.push_back(ep);
+
+        Dispatch();
+    }
+
+    void SharedNodeNetwork::Dispatch()
+    {
+        while ((m_lstRelays.size() < m_Cfg.m_MaxInFlight) && !m_lstSchedule.empty())
+        {
+            Endpoint& ep = m_lstSchedule.front();
+            m_lstSchedule.pop_front();
+
+            assert(!ep.m_Queue.empty());
+            Request::Ptr pReq = std::move(ep.m_Queue.front());
+            ep.m_Queue.pop_front();
+
+            if (!ep.m_Queue.empty())
+                m_lstSchedule.push_back(ep); // next one on the next round
+
+            if (!pReq->m_pTrg)
+                continue; // aborted while queued
+
+            Request::Ptr pCopy = CloneRequest(*pReq);
+            if (!pCopy)
+                continue;
+
+            Relay* pRelay = new Relay(*this);
+            m_lstRelays.push_back(*pRelay);
+            pRelay->m_pOrig = std::move(pReq);
+            pRelay->m_pCopy = std::move(pCopy);
+
+            m_pNet->PostRequest(*pRelay->m_pCopy, *pRelay);
+        }
+    }
+
+    void SharedNodeNetwork::Relay::OnComplete(Request& r)
+    {
+        assert(&r == m_pCopy.get());
+
+        if (m_pOrig->m_pTrg)
+        {
+            MoveResult(*m_pOrig, r);
+            m_pOrig->m_pTrg->OnComplete(*m_pOrig);
+        }
+
+        SharedNodeNetwork& x = m_This;
+        if (m_pOwner)
+        {
+            // not limited by m_MaxInFlight
+            m_pOwner->m_lstRelays.erase(m_pOwner->m_lstRelays.iterator_to(*this));
+            delete this;
+            return;
+        }
+
+        x.m_lstRelays.erase(x.m_lstRelays.iterator_to(*this));
+        delete this;
+
+        x.Dispatch();
+    }
+
+    void SharedNodeNetwork::BbsSubscribe(Endpoint& ep, BbsChannel ch, Timestamp ts, proto::FlyClient::IBbsReceiver* p)
+    {
+        auto it = m_BbsSubscriptions.find(ch);
+
+        if (!p)
+        {
+            if (m_BbsSubscriptions.end() == it)
+                return;
+
+            it->second.erase(&ep);
+            if (it->second.empty())
+            {
+                m_BbsSubscriptions.erase(it);
+                m_BbsTimestamps.erase(ch);
+                m_pNet->BbsSubscribe(ch, 0, nullptr);
+            }
+            return;
+        }
+
+        if (m_BbsSubscriptions.end() == it)
+            it = m_BbsSubscriptions.emplace(ch, BbsReceivers()).first;
+
+        it->second[&ep] = p;
+
+        auto itTs = m_BbsTimestamps.find(ch);
+        if (m_BbsTimestamps.end() == itTs)
+        {
+            m_BbsTimestamps[ch] = ts;
+            m_pNet->BbsSubscribe(ch, ts, this);
+        }
+        else
+        {
+            if (ts < itTs->second)
+            {
+                // resubscribe to receive the older messages as well
+                itTs->second = ts;
+                m_pNet->BbsSubscribe(ch, 0, nullptr);
+                m_pNet->BbsSubscribe(ch, ts, this);
+            }
+        }
+    }
+
+    void SharedNodeNetwork::OnMsg(BbsMsg&& msg)
+    {
+        auto it = m_BbsSubscriptions.find(msg.m_Channel);
+        if (m_BbsSubscriptions.end() == it)
+            return;
+
+        m_BbsTimestamps[msg.m_Channel] = msg.m_TimePosted;
+
+        // copy the receivers, subscriptions may change during the handling
+        std::vector<proto::FlyClient::IBbsReceiver*> vRcv;
+        vRcv.reserve(it->second.size());
+        for (const auto& v : it->second)
+            vRcv.push_back(v.second);
+
+        for (size_t i = 0; i < vRcv.size(); i++)
+        {
+            if (i + 1 == vRcv.size())
+                vRcv[i]->OnMsg(std::move(msg));
+            else
+            {
+                BbsMsg msg2 = msg;
+                vRcv[i]->OnMsg(std::move(msg2));
+            }
+        }
+    }
+
+    void SharedNodeNetwork::SyncEndpoint(Endpoint& ep)
+    {
+        Block::SystemState::Full sTip;
+        if (!m_Hist.get_Tip(sTip))
+            return; // not synced yet
+
+        Block::SystemState::IHistory& h = ep.m_Client.get_History();
+
+        Block::SystemState::Full sMy;
+        h.get_Tip(sMy);
+
+        if ((sMy == sTip) || (sTip.m_ChainWork < sMy.m_ChainWork))
+        {
+            ep.m_Client.OnTipUnchanged();
+            return;
+        }
+
+        // erase the wallet states that are not in the shared chain. States below it are considered confirmed
+        struct Walker :public Block::SystemState::IHistory::IWalker
+        {
+            Block::SystemState::HistoryMap* m_pHist;
+            Height m_LowHeight;
+            Height m_LowErase = MaxHeight;
+
+            virtual bool OnState(const Block::SystemState::Full& s) override
+            {
+                if (s.m_Height < m_LowHeight)
+                    return false;
+
+                Block::SystemState::Full s2;
+                if (m_pHist->get_At(s2, s.m_Height) && (s2 == s))
+                    return false;
+
+                m_LowErase = s.m_Height;
+                return true;
+            }
+        } w;
+
+        w.m_pHist = &m_Hist;
+        w.m_LowHeight = m_Hist.m_Map.begin()->first;
+
+        h.Enum(w, nullptr);
+
+        if (w.m_LowErase != MaxHeight)
+        {
+            h.DeleteFrom(w.m_LowErase);
+            ep.m_Client.OnRolledBack();
+        }
+
+        h.get_Tip(sMy);
+
+        std::vector<Block::SystemState::Full> vStates;
+        for (auto it = m_Hist.m_Map.upper_bound(sMy.m_Height); m_Hist.m_Map.end() != it; ++it)
+            vStates.push_back(it->second);
+
+        if (!vStates.empty())
+            h.AddStates(&vStates.front(), vStates.size());
+
+        ep.m_Client.OnNewTip();
+    }
+
+    void SharedNodeNetwork::SyncAll()
+    {
+        m_Hist.ShrinkToWindow(Rules::get().MaxRollback);
+
+        for (auto it = m_lstEndpoints.begin(); m_lstEndpoints.end() != it; )
+            SyncEndpoint(*it++);
+    }
+
+    void SharedNodeNetwork::AttachOwner(Endpoint& ep)
+    {
+        Key::IPKdf::Ptr pKdf;
+        ep.m_Client.get_OwnerKdf(pKdf);
+        if (!pKdf)
+        {
+            Key::IKdf::Ptr pMaster;
+            ep.m_Client.get_Kdf(pMaster);
+            pKdf = std::move(pMaster);
+        }
+
+        if (!pKdf)
+            return; // no events for this wallet
+
+        // the same way as Key::IPKdf::IsSame() compares the keys
+        ECC::Hash::Value hv = Zero;
+        ECC::Scalar::Native k;
+        pKdf->DerivePKey(k, hv);
+
+        ECC::Hash::Processor()
+            << k
+            >> hv;
+
+        auto it = m_Owners.find(hv);
+        bool bNew = (m_Owners.end() == it);
+        if (bNew)
+            it = m_Owners.emplace(hv, std::make_unique<Owner>(*this, hv, pKdf)).first;
+
+        Owner& x = *it->second;
+        x.m_Endpoints.insert(&ep);
+        ep.m_pOwner = &x;
+
+        if (bNew)
+            x.m_Net.Connect();
+        else
+        {
+            if (x.m_Owned)
+                ep.m_Client.OnOwnedNode(x.m_NodeID, true);
+        }
+    }
+
+    void SharedNodeNetwork::DetachOwner(Endpoint& ep)
+    {
+        if (!ep.m_pOwner)
+            return;
+
+        Owner& x = *ep.m_pOwner;
+        ep.m_pOwner = nullptr;
+        x.m_Endpoints.erase(&ep);
+
+        if (x.m_Owned)
+            ep.m_Client.OnOwnedNode(x.m_NodeID, false);
+
+        if (x.m_Endpoints.empty())
+        {
+            ECC::Hash::Value hv = x.m_Key;
+            m_Owners.erase(hv);
+        }
+    }
+
+    void SharedNodeNetwork::OnNewTip()
+    {
+        SyncAll();
+    }
+
+    void SharedNodeNetwork::OnTipUnchanged()
+    {
+        SyncAll();
+    }
+
+    void SharedNodeNetwork::OnRolledBack()
+    {
+        // endpoints are updated on the following OnNewTip
+        Block::SystemState::ID id;
+        Block::SystemState::Full sTip;
+        m_Hist.get_Tip(sTip);
+        sTip.get_ID(id);
+        LOG_INFO() << "Shared node network rolled back to " << id;
+    }
+
+    Block::SystemState::IHistory& SharedNodeNetwork::get_History()
+    {
+        return m_Hist;
+    }
+
+    /////////////////////////
+    // Endpoint
+    SharedNodeNetwork::Endpoint::Endpoint(SharedNodeNetwork& x, FlyClient& client)
+        : m_This(x)
+        , m_Client(client)
+    {
+        m_This.m_lstEndpoints.push_back(*this);
+    }
+
+    SharedNodeNetwork::Endpoint::~Endpoint()
+    {
+        m_This.DetachOwner(*this);
+
+        if (is_linked())
+            m_This.m_lstEndpoints.erase(m_This.m_lstEndpoints.iterator_to(*this));
+        if (m_hookSchedule.is_linked())
+            m_This.m_lstSchedule.erase(m_This.m_lstSchedule.iterator_to(*this));
+
+        for (auto it = m_This.m_BbsSubscriptions.begin(); m_This.m_BbsSubscriptions.end() != it; )
+        {
+            BbsChannel ch = (it++)->first;
+            m_This.BbsSubscribe(*this, ch, 0, nullptr);
+        }
+    }
+
+    void SharedNodeNetwork::Endpoint::Connect()
+    {
+        if (!m_pOwner)
+            m_This.AttachOwner(*this);
+        m_This.SyncEndpoint(*this);
+    }
+
+    void SharedNodeNetwork::Endpoint::Disconnect()
+    {
+        m_This.DetachOwner(*this);
+    }
+
+    void SharedNodeNetwork::Endpoint::PostRequestInternal(Request& r)
+    {
+        assert(r.m_pTrg);
+
+        if (!m_pOwner || (Request::Type::Events != r.get_Type()))
+        {
+            m_This.PostRequest(*this, r);
+            return;
+        }
+
+        // requires the owned connection
+        Request::Ptr pCopy = CloneRequest(r);
+
+        Relay* pRelay = new Relay(m_This);
+        m_pOwner->m_lstRelays.push_back(*pRelay);
+        pRelay->m_pOwner = m_pOwner;
+        pRelay->m_pOrig = &r;
+        pRelay->m_pCopy = std::move(pCopy);
+
+        m_pOwner->m_Net.PostRequest(*pRelay->m_pCopy, *pRelay);
+    }
+
+    void SharedNodeNetwork::Endpoint::BbsSubscribe(BbsChannel ch, Timestamp ts, proto::FlyClient::IBbsReceiver* p)
+    {
+        m_This.BbsSubscribe(*this, ch, ts, p);
+    }
+
+    /////////////////////////
+    // Owner
+    SharedNodeNetwork::Owner::Owner(SharedNodeNetwork& x, const ECC::Hash::Value& key, const Key::IPKdf::Ptr& pKdf)
+        : m_This(x)
+        , m_Key(key)
+        , m_pKdf(pKdf)
+        , m_Net(*this)
+    {
+        m_Net.m_Cfg.m_vNodes.push_back(m_This.m_Cfg.m_NodeAddr);
+    }
+
+    SharedNodeNetwork::Owner::~Owner()
+    {
+        assert(m_Endpoints.empty());
+        m_Net.Disconnect();
+
+        while (!m_lstRelays.empty())
+        {
+            Relay& x = m_lstRelays.front();
+            m_lstRelays.pop_front();
+            delete &x;
+        }
+    }
+
+    void SharedNodeNetwork::Owner::OnNewTip()
+    {
+        // the shared chain was extended via the owned connection
+        m_This.SyncAll();
+    }
+
+    void SharedNodeNetwork::Owner::OnRolledBack()
+    {
+        m_This.OnRolledBack();
+    }
+
+    void SharedNodeNetwork::Owner::get_OwnerKdf(Key::IPKdf::Ptr& pKdf)
+    {
+        // the viewer login is enough for the events, the master key is not used
+        pKdf = m_pKdf;
+    }
+
+    Block::SystemState::IHistory& SharedNodeNetwork::Owner::get_History()
+    {
+        return m_This.m_Hist;
+    }
+
+    void SharedNodeNetwork::Owner::OnOwnedNode(const PeerID& id, bool bUp)
+    {
+        m_Owned = bUp;
+        m_NodeID = id;
+
+        // copy the endpoints, they may detach during the handling
+        std::vector<Endpoint*> vEps(m_Endpoints.begin(), m_Endpoints.end());
+        for (Endpoint* pEp : vEps)
+            if (m_Endpoints.count(pEp))
+                pEp->m_Client.OnOwnedNode(id, bUp);
+    }
+}
@@ -0,0 +1,149 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "core/fly_client.h"
+#include <boost/intrusive/list.hpp>
+#include <deque>
+#include <map>
+#include <set>
+
+namespace beam::wallet
+{
+    // Node connectivity shared by all the wallets hosted by the service.
+    // There's a single verified header chain and a small pool of anonymous connections to the node.
+    // Wallet requests are queued per wallet and forwarded round-robin, with a limit on the requests in flight.
+    // Events are the exception: the node reports them only to a connection logged-in with the wallet's owner key.
+    // Those connections are shared by the wallets of the same owner key, and follow the shared header chain.
+    // A connection proves a single key, so the wallets of distinct owners still can't share one.
+    class SharedNodeNetwork
+        : private proto::FlyClient
+        , private proto::FlyClient::IBbsReceiver
+    {
+    public:
+        struct Config
+        {
+            io::Address m_NodeAddr;
+            uint32_t m_Connections = 2;
+            uint32_t m_MaxInFlight = 256;
+        };
+
+        explicit SharedNodeNetwork(const Config&);
+        ~SharedNodeNetwork();
+
+        void Connect();
+
+        // node endpoint for a wallet, should be used instead of FlyClient::NetworkStd
+        proto::FlyClient::INetwork::Ptr CreateEndpoint(proto::FlyClient& client);
+
+    private:
+        struct Owner;
+
+        struct Endpoint
+            : public proto::FlyClient::INetwork
+            , public boost::intrusive::list_base_hook<>
+        {
+            SharedNodeNetwork& m_This;
+            proto::FlyClient& m_Client;
+
+            std::deque<Request::Ptr> m_Queue;
+            boost::intrusive::list_member_hook<> m_hookSchedule;
+
+            Owner* m_pOwner = nullptr; // events connection
+
+            Endpoint(SharedNodeNetwork&, proto::FlyClient&);
+            ~Endpoint();
+
+            // INetwork
+            void Connect() override;
+            void Disconnect() override;
+            void PostRequestInternal(Request&) override;
+            void BbsSubscribe(BbsChannel, Timestamp, proto::FlyClient::IBbsReceiver*) override;
+        };
+
+        struct Relay final
+            : public Request::IHandler
+            , public boost::intrusive::list_base_hook<>
+        {
+            SharedNodeNetwork& m_This;
+            Request::Ptr m_pOrig;
+            Request::Ptr m_pCopy;
+            Owner* m_pOwner = nullptr; // if relayed via the events connection
+
+            Relay(SharedNodeNetwork& x) :m_This(x) {}
+            void OnComplete(Request&) override;
+        };
+
+        // connection logged-in with the owner key, for events only
+        struct Owner
+            : public proto::FlyClient
+        {
+            SharedNodeNetwork& m_This;
+            ECC::Hash::Value m_Key;
+            Key::IPKdf::Ptr m_pKdf;
+            proto::FlyClient::NetworkStd m_Net;
+
+            std::set<Endpoint*> m_Endpoints;
+            boost::intrusive::list<Relay> m_lstRelays; // in flight
+
+            bool m_Owned = false;
+            PeerID m_NodeID;
+
+            Owner(SharedNodeNetwork&, const ECC::Hash::Value&, const Key::IPKdf::Ptr&);
+            ~Owner();
+
+            // FlyClient
+            void OnNewTip() override;
+            void OnRolledBack() override;
+            void get_OwnerKdf(Key::IPKdf::Ptr&) override;
+            Block::SystemState::IHistory& get_History() override;
+            void OnOwnedNode(const PeerID&, bool bUp) override;
+        };
+
+        Config m_Cfg;
+        Block::SystemState::HistoryMap m_Hist;
+        std::unique_ptr<proto::FlyClient::NetworkStd> m_pNet;
+
+        boost::intrusive::list<Endpoint> m_lstEndpoints;
+
+        typedef boost::intrusive::member_hook<Endpoint, boost::intrusive::list_member_hook<>, &Endpoint::m_hookSchedule> ScheduleHook;
+        boost::intrusive::list<Endpoint, ScheduleHook> m_lstSchedule; // endpoints with pending requests, in round-robin order
+
+        boost::intrusive::list<Relay> m_lstRelays; // in flight
+
+        // all the subscribers of each channel
+        typedef std::map<Endpoint*, proto::FlyClient::IBbsReceiver*> BbsReceivers;
+        std::map<BbsChannel, BbsReceivers> m_BbsSubscriptions;
+        std::map<BbsChannel, Timestamp> m_BbsTimestamps;
+
+        std::map<ECC::Hash::Value, std::unique_ptr<Owner>> m_Owners;
+
+        void PostRequest(Endpoint&, Request&);
+        void Dispatch();
+        void BbsSubscribe(Endpoint&, BbsChannel, Timestamp, proto::FlyClient::IBbsReceiver*);
+        void SyncEndpoint(Endpoint&);
+        void SyncAll();
+        void AttachOwner(Endpoint&);
+        void DetachOwner(Endpoint&);
+
+        // FlyClient
+        void OnNewTip() override;
+        void OnTipUnchanged() override;
+        void OnRolledBack() override;
+        Block::SystemState::IHistory& get_History() override;
+
+        // IBbsReceiver
+        void OnMsg(proto::BbsMsg&&) override;
+    };
+}
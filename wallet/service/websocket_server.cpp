@@ -15,7 +15,7 @@
 #include "websocket_server.h"
 
 #include "utility/logger.h"
-#include "utility/io/asyncevent.h"
+#include "utility/message_queue.h"
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
@@ -24,6 +24,7 @@
 #include <thread>
 #include <mutex>
 #include <queue>
+#include <atomic>
 
 using namespace beam;
 using tcp = boost::asio::ip::tcp;               // from <boost/asio/ip/tcp.hpp>
@@ -45,29 +46,74 @@ namespace beam::wallet
             throw std::runtime_error(ec.message());
         }
 
-        
+        struct Worker
+        {
+            io::Reactor::Ptr m_reactor;
+            WebSocketServer::PostFunc m_post;
+            std::atomic<size_t> m_sessions = 0;
+
+            // guards the sessions against the writes of their handlers
+            std::mutex m_mutex;
+            bool m_stopped = false;
+        };
+
+        using Workers = std::vector<std::shared_ptr<Worker>>;
+        using HandlerCreatorPtr = std::shared_ptr<WebSocketServer::WorkerHandlerCreator>;
+
+        class Session;
+
+        // What the worker thread knows of the session. The handler is used and destroyed on the worker thread only
+        struct SessionLink
+        {
+            Session* m_session = nullptr; // under the worker mutex, reset once the session is gone
+            WebSocketServer::IHandler::Ptr m_handler;
+        };
 
         class Session : public std::enable_shared_from_this<Session>
         {
         public:
             // Take ownership of the socket
-            explicit Session(tcp::socket socket, io::Reactor::Ptr reactor, WebSocketServer::HandlerCreator& creator)
+            explicit Session(tcp::socket socket, const std::shared_ptr<Worker>& worker, const HandlerCreatorPtr& creator)
                 : m_webSocket(std::move(socket))
-                , m_newDataEvent(io::AsyncEvent::create(*reactor, [this]() { process_new_data(); }))
-                , m_handler(creator([this](const auto& msg) { do_write(msg); }))
-                
+                , m_worker(worker)
+                , m_handlerCreator(creator)
+                , m_link(std::make_shared<SessionLink>())
             {
-
+                m_link->m_session = this;
+                ++m_worker->m_sessions;
             }
 
             ~Session()
             {
+                {
+                    std::unique_lock<std::mutex> lock(m_worker->m_mutex);
+                    m_link->m_session = nullptr;
+                }
+
+                // the handler goes with the last reference to the link, on the worker thread
+                m_worker->m_post([link = std::move(m_link)]() {});
+
+                --m_worker->m_sessions;
                 LOG_DEBUG() << "Session destroyed.";
             }
 
             // Start the asynchronous operation
             void run()
             {
+                // posted before any data, so the handler is there when the data arrives
+                m_worker->m_post([link = m_link, reactor = m_worker->m_reactor, weakWorker = std::weak_ptr<Worker>(m_worker), creator = m_handlerCreator]() {
+                    link->m_handler = (*creator)([weakWorker, weakLink = std::weak_ptr<SessionLink>(link)](const std::string& msg) {
+                        auto worker = weakWorker.lock();
+                        auto link = weakLink.lock();
+                        if (!worker || !link)
+                            return;
+
+                        std::unique_lock<std::mutex> lock(worker->m_mutex);
+                        if (link->m_session && !worker->m_stopped)
+                            link->m_session->post_write(msg);
+                    }, reactor);
+                });
+
                 // Accept the websocket handshake
                 m_webSocket.async_accept(
                     [sp = shared_from_this()](boost::system::error_code ec)
@@ -183,43 +229,34 @@ namespace beam::wallet
                 });
             }
 
-            void process_new_data()
+            // called by the handler on the worker thread, the stream is used on the ioc thread only
+            void post_write(const std::string& msg)
             {
-                while (!m_dataQueue.empty())
+                if (auto sp = weak_from_this().lock())
                 {
-                    std::string data;
+                    boost::asio::post(m_webSocket.get_executor(), [sp, msg]()
                     {
-                        std::unique_lock<std::mutex> lock(m_queueMutex);
-                        data = m_dataQueue.front();
-                        m_dataQueue.pop();
-                    }
-
-                    process_data(data);
+                        sp->do_write(msg);
+                    });
                 }
             }
 
             void process_data_async(std::string&& data)
             {
-                {
-                    std::unique_lock<std::mutex> lock(m_queueMutex);
-                    m_dataQueue.push(std::move(data));
-                }
-                m_newDataEvent->post();
-            }
-
-            void process_data(const std::string& data)
-            {
-                m_handler->processData(data);
+                m_worker->m_post([link = m_link, data = std::move(data)]() {
+                    if (link->m_handler)
+                        link->m_handler->processData(data);
+                });
             }
 
         private:
             websocket::stream<tcp::socket> m_webSocket;
+            std::shared_ptr<Worker> m_worker;
+            HandlerCreatorPtr m_handlerCreator;
             boost::beast::multi_buffer m_buffer;
-            io::AsyncEvent::Ptr m_newDataEvent;
-            WebSocketServer::IHandler::Ptr m_handler;
+            std::shared_ptr<SessionLink> m_link;
 
             std::mutex m_queueMutex;
-            std::queue<std::string> m_dataQueue;
             std::queue<std::string> m_writeQueue;
 
             //std::queue<KeyKeeperFunc> m_keeperCallbacks;
@@ -229,10 +266,10 @@ namespace beam::wallet
         class Listener : public std::enable_shared_from_this<Listener>
         {
         public:
-            Listener(boost::asio::io_context& ioc, tcp::endpoint endpoint, io::Reactor::Ptr reactor, WebSocketServer::HandlerCreator& creator)
+            Listener(boost::asio::io_context& ioc, tcp::endpoint endpoint, Workers& workers, const HandlerCreatorPtr& creator)
                 : m_acceptor(ioc)
                 , m_socket(ioc)
-                , m_reactor(reactor)
+                , m_workers(workers)
                 , m_handlerCreator(creator)
             {
                 boost::system::error_code ec;
@@ -295,7 +332,7 @@ namespace beam::wallet
                 else
                 {
                     // Create the Session and run it
-                    auto s = std::make_shared<Session>(std::move(m_socket), m_reactor, m_handlerCreator);
+                    auto s = std::make_shared<Session>(std::move(m_socket), select_worker(), m_handlerCreator);
                     s->run();
                 }
 
@@ -303,28 +340,70 @@ namespace beam::wallet
                 do_accept();
             }
 
+            const std::shared_ptr<Worker>& select_worker()
+            {
+                assert(!m_workers.empty());
+                auto res = m_workers.begin();
+                for (auto it = m_workers.begin(); it != m_workers.end(); ++it)
+                {
+                    if ((*it)->m_sessions < (*res)->m_sessions)
+                        res = it;
+                }
+                return *res;
+            }
+
         private:
             tcp::acceptor m_acceptor;
             tcp::socket m_socket;
-            io::Reactor::Ptr m_reactor;
-            WebSocketServer::HandlerCreator& m_handlerCreator;
+            Workers& m_workers;
+            HandlerCreatorPtr m_handlerCreator;
         };
     }
 
     struct WebSocketServer::WebSocketServerImpl
     {
-        WebSocketServerImpl(io::Reactor::Ptr reactor, uint16_t port, HandlerCreator&& creator, StartAction&& startAction)
-            : m_ioc{ 1 }
-            , m_reactor(reactor)
-            , m_handlerCreator(std::move(creator))
-            , m_startAction(startAction)
+        using Tasks = RX<std::function<void()>>;
+
+        // the sessions are served on the given reactor, the server is created and destroyed on its thread
+        WebSocketServerImpl(io::Reactor::Ptr reactor, uint16_t port, WorkerHandlerCreator&& creator, StartAction&& startAction)
+            : m_tasks(std::make_unique<Tasks>(*reactor, [](std::function<void()>&& task) { task(); task = nullptr; }))
+            , m_handlerCreator(std::make_shared<WorkerHandlerCreator>(std::move(creator)))
+            , m_startAction(std::move(startAction))
+            , m_ioc{ 1 }
         {
+            add_worker(reactor, [tx = m_tasks->get_tx()](std::function<void()>&& task) mutable { tx.send(std::move(task)); });
+            start(port);
+        }
+
+        WebSocketServerImpl(const std::vector<WorkerReactor>& workers, uint16_t port, WorkerHandlerCreator&& creator, StartAction&& startAction)
+            : m_handlerCreator(std::make_shared<WorkerHandlerCreator>(std::move(creator)))
+            , m_startAction(std::move(startAction))
+            , m_ioc{ 1 }
+        {
+            for (const auto& w : workers)
+            {
+                add_worker(w.reactor, w.post);
+            }
             start(port);
         }
 
         ~WebSocketServerImpl()
         {
             stop();
+
+            // the handlers may outlive the server until their workers get to destroy them
+            for (const auto& w : m_workers)
+            {
+                std::unique_lock<std::mutex> lock(w->m_mutex);
+                w->m_stopped = true;
+            }
+        }
+
+        void add_worker(io::Reactor::Ptr reactor, PostFunc post)
+        {
+            m_workers.push_back(std::make_shared<Worker>());
+            m_workers.back()->m_reactor = reactor;
+            m_workers.back()->m_post = std::move(post);
         }
 
         void start(uint16_t port)
@@ -334,7 +413,7 @@ namespace beam::wallet
 
         void iocThreadFunc(uint16_t port)
         {
-            std::make_shared<Listener>(m_ioc, tcp::endpoint{ boost::asio::ip::make_address("0.0.0.0"), port }, m_reactor, m_handlerCreator)->run();
+            std::make_shared<Listener>(m_ioc, tcp::endpoint{ boost::asio::ip::make_address("0.0.0.0"), port }, m_workers, m_handlerCreator)->run();
             if (m_startAction)
             {
                 m_startAction();
@@ -345,18 +424,31 @@ namespace beam::wallet
         void stop()
         {
             m_ioc.stop();
+            if (m_iocThread && m_iocThread->joinable())
+            {
+                m_iocThread->join();
+            }
         }
 
+        // destroyed in reverse: the sessions go with the io context, before the workers they post to
+        std::unique_ptr<Tasks> m_tasks;
+        Workers m_workers;
+        HandlerCreatorPtr m_handlerCreator;
+        StartAction m_startAction;
         boost::asio::io_context m_ioc;
         std::shared_ptr<std::thread> m_iocThread;
-        io::Reactor::Ptr m_reactor;
-        HandlerCreator m_handlerCreator;
-        StartAction m_startAction;
     };
 
 
     WebSocketServer::WebSocketServer(io::Reactor::Ptr reactor, uint16_t port, HandlerCreator&& creator, StartAction&& startAction)
-        : m_impl(std::make_unique<WebSocketServerImpl>(reactor, port, std::move(creator), std::move(startAction)))
+        : m_impl(std::make_unique<WebSocketServerImpl>(reactor, port,
+            [creator = std::move(creator)](SendMessageFunc&& func, io::Reactor::Ptr) { return creator(std::move(func)); },
+            std::move(startAction)))
+    {
+    }
+
+    WebSocketServer::WebSocketServer(const std::vector<WorkerReactor>& workers, uint16_t port, WorkerHandlerCreator&& creator, StartAction&& startAction)
+        : m_impl(std::make_unique<WebSocketServerImpl>(workers, port, std::move(creator), std::move(startAction)))
     {
     }
 
@@ -18,6 +18,7 @@
 #include <functional>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace beam::wallet
 {
@@ -35,9 +36,23 @@ namespace beam::wallet
 
         using SendMessageFunc = std::function<void(const std::string&)>;
         using HandlerCreator = std::function<IHandler::Ptr (SendMessageFunc&&)>;
+        using WorkerHandlerCreator = std::function<IHandler::Ptr (SendMessageFunc&&, beam::io::Reactor::Ptr)>; // handler is created for the given reactor
         using StartAction = std::function<void()>;
 
+        // Runs the task on the reactor thread, in the order posted. May be called from any thread
+        using PostFunc = std::function<void(std::function<void()>&&)>;
+
+        struct WorkerReactor
+        {
+            beam::io::Reactor::Ptr reactor;
+            PostFunc post;
+        };
+
         WebSocketServer(beam::io::Reactor::Ptr reactor, uint16_t port, HandlerCreator&& creator, StartAction&& startAction = {});
+
+        // Each session is pinned to one of the workers, the one with the fewest sessions. Its handler is created,
+        // fed and destroyed by the tasks posted to that worker, so the workers must run until the server is destroyed
+        WebSocketServer(const std::vector<WorkerReactor>& workers, uint16_t port, WorkerHandlerCreator&& creator, StartAction&& startAction = {});
         ~WebSocketServer();
 
     private:
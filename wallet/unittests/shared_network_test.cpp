@@ -0,0 +1,192 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <boost/filesystem.hpp>
+
+#include "test_helpers.h"
+#include "wallet/core/common.h"
+#include "wallet/core/simple_transaction.h"
+#include "wallet/core/wallet_network.h"
+#include "wallet/service/shared_network.h"
+#include "keykeeper/local_private_key_keeper.h"
+// for wallet_test_environment.cpp
+#include "core/unittest/mini_blockchain.h"
+#include "core/radixtree.h"
+#include "utility/test_helpers.h"
+#include "node/node.h"
+
+WALLET_TEST_INIT
+#include "wallet_test_environment.cpp"
+
+using namespace beam;
+using namespace beam::wallet;
+using namespace std;
+
+namespace
+{
+    const uint32_t RequestsPerClient = 20;
+
+    struct Client
+        : public proto::FlyClient
+        , public proto::FlyClient::Request::IHandler
+    {
+        Block::SystemState::HistoryMap m_Hist;
+        proto::FlyClient::INetwork::Ptr m_pNet;
+        std::vector<Request::Ptr> m_Requests;
+        std::set<Request*> m_Pending;
+        uint32_t m_Completed = 0;
+        uint8_t m_Tag;
+        std::function<void()> m_OnDone;
+
+        Key::IKdf::Ptr m_pKdf;
+        Request::Ptr m_pEvents;
+        bool m_EventsDone = false;
+
+        explicit Client(uint8_t tag) :m_Tag(tag) {}
+
+        Block::SystemState::IHistory& get_History() override
+        {
+            return m_Hist;
+        }
+
+        void get_Kdf(Key::IKdf::Ptr& pKdf) override
+        {
+            pKdf = m_pKdf;
+        }
+
+        void OnOwnedNode(const PeerID&, bool bUp) override
+        {
+            if (!bUp || m_pEvents)
+                return;
+
+            RequestEvents::Ptr pReq(new RequestEvents);
+            m_pEvents = pReq;
+            m_Pending.insert(pReq.get());
+            m_pNet->PostRequest(*pReq, *this);
+        }
+
+        void OnNewTip() override
+        {
+            if (!m_Requests.empty())
+                return;
+
+            // distinct kernel IDs per client, none of them exist
+            for (uint32_t i = 0; i < RequestsPerClient; i++)
+            {
+                RequestKernel::Ptr pReq(new RequestKernel);
+                pReq->m_Msg.m_ID = i;
+                pReq->m_Msg.m_ID.m_pData[0] = m_Tag;
+
+                m_Requests.push_back(pReq);
+                m_Pending.insert(pReq.get());
+                m_pNet->PostRequest(*pReq, *this);
+            }
+        }
+
+        void OnComplete(Request& r) override
+        {
+            // must be routed back to the wallet that posted it, once
+            WALLET_CHECK(m_Pending.erase(&r) == 1);
+
+            if (&r == m_pEvents.get())
+            {
+                WALLET_CHECK(r.get_Type() == Request::Type::Events);
+                m_EventsDone = true;
+            }
+            else
+            {
+                WALLET_CHECK(r.get_Type() == Request::Type::Kernel);
+                WALLET_CHECK(static_cast<RequestKernel&>(r).m_Res.m_Proof.empty());
+                m_Completed++;
+            }
+
+            if (m_Pending.empty() && m_OnDone)
+                m_OnDone();
+        }
+    };
+
+    void TestSharedNetwork()
+    {
+        cout << "\nTesting shared node network...\n";
+
+        io::Reactor::Ptr mainReactor(io::Reactor::create());
+        io::Reactor::Scope scope(*mainReactor);
+
+        auto db = createSenderWalletDB();
+        auto treasury = createTreasury(db);
+
+        Node node;
+        InitNodeToTest(node, treasury, nullptr, 32125, 200, "shared_network_node.db");
+
+        SharedNodeNetwork::Config cfg;
+        cfg.m_NodeAddr.resolve("127.0.0.1");
+        cfg.m_NodeAddr.port(32125);
+        cfg.m_MaxInFlight = 3; // less than the requests, so that they're queued and scheduled round-robin
+
+        SharedNodeNetwork net(cfg);
+
+        Client c1(1), c2(2);
+
+        // both wallets of the node's owner, should share the events connection
+        ECC::HKdf::Create(c1.m_pKdf, ECC::uintBig(345U));
+        ECC::HKdf::Create(c2.m_pKdf, ECC::uintBig(345U));
+
+        auto onDone = [&]() {
+            if (c1.m_Pending.empty() && c2.m_Pending.empty() && !c1.m_Requests.empty() && !c2.m_Requests.empty() &&
+                c1.m_EventsDone && c2.m_EventsDone)
+                mainReactor->stop();
+        };
+        c1.m_OnDone = onDone;
+        c2.m_OnDone = onDone;
+
+        c1.m_pNet = net.CreateEndpoint(c1);
+        c2.m_pNet = net.CreateEndpoint(c2);
+
+        net.Connect();
+        c1.m_pNet->Connect();
+        c2.m_pNet->Connect();
+
+        io::Timer::Ptr timer = io::Timer::create(*mainReactor);
+        timer->start(30000, false, [&]() { mainReactor->stop(); });
+
+        mainReactor->run();
+
+        WALLET_CHECK(c1.m_Completed == RequestsPerClient);
+        WALLET_CHECK(c2.m_Completed == RequestsPerClient);
+        WALLET_CHECK(c1.m_EventsDone);
+        WALLET_CHECK(c2.m_EventsDone);
+
+        // both follow the shared header chain
+        Block::SystemState::Full s1, s2;
+        WALLET_CHECK(c1.m_Hist.get_Tip(s1));
+        WALLET_CHECK(c2.m_Hist.get_Tip(s2));
+
+        // endpoints must go before the network
+        c1.m_pNet.reset();
+        c2.m_pNet.reset();
+    }
+}
+
+int main()
+{
+    int logLevel = LOG_LEVEL_DEBUG;
+    auto logger = beam::Logger::create(logLevel, logLevel);
+
+    Rules::get().FakePoW = true;
+    Rules::get().UpdateChecksum();
+
+    TestSharedNetwork();
+
+    return WALLET_CHECK_RESULT;
+}
@@ -149,6 +149,21 @@ namespace
         }
     }
 
+    // the streaming response must be byte-exact with the DOM one
+    template<typename T>
+    void testStreamResponse(WalletApi& api, const T& response, const json& res)
+    {
+        io::SerializedMsg sm;
+        io::FragmentWriter fw(64, 0, [&sm](io::SharedBuffer&& fragment) { sm.push_back(std::move(fragment)); });
+
+        JsonWriter w(fw);
+        api.getResponse(123, response, w);
+        w.finalize();
+
+        io::SharedBuffer buf = io::normalize(sm, false);
+        WALLET_CHECK(std::string((const char*)buf.data, buf.size) == res.dump() + "\n");
+    }
+
     void testGetUtxoJsonRpc(const std::string& msg)
     {
         class WalletApiHandler : public WalletApiHandlerBase
@@ -204,6 +219,12 @@ namespace
                 WALLET_CHECK(result[i]["type"] == "norm");
                 WALLET_CHECK(result[i]["maturity"] == 60);
             }
+
+            getUtxo.utxos[1].m_createTxId = TxID{ {1, 2, 3} };
+            getUtxo.utxos[1].m_sessionId = 77;
+            res.clear();
+            api.getResponse(123, getUtxo, res);
+            testStreamResponse(api, getUtxo, res);
         }
     }
 
@@ -508,6 +529,22 @@ namespace
             testResultHeader(res);
 
             WALLET_CHECK(res["id"] == 123);
+            testStreamResponse(api, txList, res);
+
+            for (int i = 0; i < 3; i++)
+            {
+                Status::Response item;
+                item.tx.m_txId = TxID{ {uint8_t(i + 1)} };
+                item.tx.m_amount = 100 + i;
+                item.tx.m_message = { 'q', '"', '\n' };
+                item.kernelProofHeight = 10 + i;
+                item.systemHeight = 20;
+                txList.resultList.push_back(item);
+            }
+
+            res.clear();
+            api.getResponse(123, txList, res);
+            testStreamResponse(api, txList, res);
         }
     }
 
@@ -539,6 +576,36 @@ namespace
         WALLET_CHECK(api.parse(msg.data(), msg.size()));
     }
 
+    void testTxListCursorJsonRpc(const std::string& msg, bool valid)
+    {
+        class WalletApiHandler : public WalletApiHandlerBase
+        {
+        public:
+            WalletApiHandler(bool valid_) : _valid(valid_)
+            {}
+
+            void onInvalidJsonRpc(const json& msg) override
+            {
+                WALLET_CHECK(!_valid);
+            }
+
+            void onMessage(const JsonRpcId& id, const TxList& data) override
+            {
+                WALLET_CHECK(_valid);
+                WALLET_CHECK(data.count == 10);
+                WALLET_CHECK(data.cursor);
+                WALLET_CHECK(to_hex(data.cursor->data(), data.cursor->size()) == "10c4b760c842433cb58339a0fafef3db");
+            }
+        private:
+            bool _valid;
+        };
+
+        WalletApiHandler handler(valid);
+        WalletApi api(handler);
+
+        api.parse(msg.data(), msg.size());
+    }
+
     void testValidateAddressJsonRpc(const std::string& msg, bool valid)
     {
         class WalletApiHandler : public WalletApiHandlerBase
@@ -767,6 +834,92 @@ int main()
         }
     }));
 
+    testJsonRpc<SendBatch>(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_send_batch",
+        "params" :
+        {
+            "fee" : 200,
+            "payouts" :
+            [
+                {
+                    "value" : 100,
+                    "address" : "472e17b0419055ffee3b3813b98ae671579b0ac0dcd6f1a23b11a75ab148cc67",
+                    "comment" : "first"
+                },
+                {
+                    "value" : 200,
+                    "address" : "19d0adff5f02787819d8df43b442a49b43e72a8b0d04a7cf995237a0422d2be83b6",
+                    "txId" : "10c4b760c842433cb58339a0fafef3db"
+                }
+            ]
+        }
+    }),
+    [](const json& msg)
+    {
+        WALLET_CHECK(!"invalid tx_send_batch api json!!!");
+    },
+    [](const JsonRpcId& id, const SendBatch& data)
+    {
+        WALLET_CHECK(data.fee == 200);
+        WALLET_CHECK(!data.from);
+        WALLET_CHECK(data.payouts.size() == 2);
+        WALLET_CHECK(data.payouts[0].value == 100);
+        WALLET_CHECK(data.payouts[0].comment == "first");
+        WALLET_CHECK(!data.payouts[0].txId);
+        WALLET_CHECK(to_string(data.payouts[0].address) == "472e17b0419055ffee3b3813b98ae671579b0ac0dcd6f1a23b11a75ab148cc67");
+        WALLET_CHECK(data.payouts[1].value == 200);
+        WALLET_CHECK(data.payouts[1].txId);
+    });
+
+    testJsonRpc<SendBatch>(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_send_batch",
+        "params" :
+        {
+            "payouts" :
+            [
+                {
+                    "value" : 100,
+                    "address" : "472e17b0419055ffee3b3813b98ae671579b0ac0dcd6f1a23b11a75ab148cc67"
+                },
+                {
+                    "value" : 0,
+                    "address" : "19d0adff5f02787819d8df43b442a49b43e72a8b0d04a7cf995237a0422d2be83b6"
+                }
+            ]
+        }
+    }),
+    [](const json& msg) {},
+    [](const JsonRpcId& id, const SendBatch& data)
+    {
+        WALLET_CHECK(!"The value is invalid!!!");
+    });
+
+    testJsonRpc<BatchStatus>(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_batch_status",
+        "params" :
+        {
+            "txIds" : ["10c4b760c842433cb58339a0fafef3db", "20c4b760c842433cb58339a0fafef3db"]
+        }
+    }),
+    [](const json& msg)
+    {
+        WALLET_CHECK(!"invalid tx_batch_status api json!!!");
+    },
+    [](const JsonRpcId& id, const BatchStatus& data)
+    {
+        WALLET_CHECK(data.txIds.size() == 2);
+        WALLET_CHECK(to_hex(data.txIds[1].data(), data.txIds[1].size()) == "20c4b760c842433cb58339a0fafef3db");
+    });
+
     testJsonRpc<Send>(JSON_CODE(
     {
         "jsonrpc": "2.0",
@@ -1022,6 +1175,30 @@ int main()
         }
     }));
 
+    testTxListCursorJsonRpc(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_list",
+        "params" :
+        {
+            "cursor" : "10c4b760c842433cb58339a0fafef3db",
+            "count" : 10
+        }
+    }), true);
+
+    testTxListCursorJsonRpc(JSON_CODE(
+    {
+        "jsonrpc": "2.0",
+        "id" : 12345,
+        "method" : "tx_list",
+        "params" :
+        {
+            "cursor" : "10c4b760",
+            "count" : 10
+        }
+    }), false);
+
     testValidateAddressJsonRpc(JSON_CODE(
     {
         "jsonrpc": "2.0",
@@ -1213,6 +1213,55 @@ void TestSelect6()
     }
 }
 
+void TestSelectBenchmark()
+{
+    cout << "\nWallet database coin selection benchmark\n";
+
+    // mining-like wallets, lots of small coins
+    for (uint32_t count : { 10'000, 100'000, 1'000'000 })
+    {
+        auto db = createSqliteWalletDB();
+        {
+            vector<Coin> coins;
+            coins.reserve(count);
+
+            for (uint32_t i = 0; i < count; ++i)
+                coins.push_back(CreateAvailCoin(1'000'000 + rand() % 100'000));
+
+            db->storeCoins(coins);
+        }
+
+        helpers::StopWatch sw;
+        Amount amount = 45'678'910;
+
+        sw.start();
+        auto coins = db->selectCoins(amount, Zero);
+        sw.stop();
+        WALLET_CHECK(!coins.empty());
+        cout << count << " coins, first selection (index load): " << sw.microseconds() << " us\n";
+
+        const uint32_t nRounds = 10;
+        uint64_t us = 0;
+        for (uint32_t i = 0; i < nRounds; ++i)
+        {
+            // spend the selected coins, the index should follow
+            for (auto& c : coins)
+            {
+                WALLET_CHECK(c.m_status == Coin::Status::Available);
+                c.m_spentHeight = 5;
+            }
+            db->saveCoins(coins);
+
+            sw.start();
+            coins = db->selectCoins(amount, Zero);
+            sw.stop();
+            us += sw.microseconds();
+            WALLET_CHECK(!coins.empty());
+        }
+        cout << count << " coins, selection: " << us / nRounds << " us\n";
+    }
+}
+
 void TestWalletMessages()
 {
     cout << "\nWallet database wallet messages test\n";
@@ -1374,6 +1423,94 @@ void TestNotifications()
 
 }
 
+void TestTxHistoryPaging()
+{
+    cout << "\nWallet database tx history paging test\n";
+    auto walletDB = createSqliteWalletDB();
+
+    TxDescription tr(TxID{});
+    tr.m_amount = 10;
+    tr.m_myId.m_Pk = unsigned(42);
+    tr.m_sender = true;
+
+    const uint8_t N = 20;
+    for (uint8_t i = 0; i < N; ++i)
+    {
+        tr.m_txId = {};
+        tr.m_txId[0] = i;
+        tr.m_createTime = 1000 + i / 2; // pairs with the same time
+        tr.m_status = (i % 3) ? TxStatus::Completed : TxStatus::Failed;
+        tr.m_txType = (i % 5) ? TxType::Simple : TxType::AssetIssue;
+        tr.m_assetId = (i % 5) ? 0 : 7;
+        walletDB->saveTx(tr);
+    }
+
+    auto all = walletDB->getTxHistory(TxType::ALL);
+    WALLET_CHECK(all.size() == N);
+    for (size_t i = 1; i < all.size(); ++i)
+    {
+        WALLET_CHECK(all[i - 1].m_createTime > all[i].m_createTime ||
+            (all[i - 1].m_createTime == all[i].m_createTime && all[i - 1].m_txId < all[i].m_txId));
+    }
+
+    // keyset pages cover the whole history
+    {
+        TxHistoryFilter filter;
+        std::vector<TxDescription> res;
+        while (true)
+        {
+            auto page = walletDB->getTxHistory(filter, 0, 3);
+            if (page.empty())
+                break;
+            WALLET_CHECK(page.size() <= 3);
+            res.insert(res.end(), page.begin(), page.end());
+            filter.m_After = TxHistoryFilter::Cursor{ page.back().m_createTime, page.back().m_txId };
+        }
+        WALLET_CHECK(res.size() == N);
+        for (size_t i = 0; i < res.size(); ++i)
+            WALLET_CHECK(res[i].m_txId == all[i].m_txId);
+    }
+
+    {
+        TxHistoryFilter filter;
+        filter.m_Status = TxStatus::Failed;
+        auto res = walletDB->getTxHistory(filter, 0, N);
+        WALLET_CHECK(res.size() == 7);
+        for (const auto& t : res)
+            WALLET_CHECK(t.m_status == TxStatus::Failed);
+
+        filter.m_Type = TxType::AssetIssue;
+        filter.m_AssetID = 7;
+        res = walletDB->getTxHistory(filter, 0, N);
+        WALLET_CHECK(res.size() == 2); // 0 and 15
+    }
+
+    {
+        TxHistoryFilter filter;
+        filter.m_MinCreateTime = 1002;
+        filter.m_MaxCreateTime = 1004;
+        auto res = walletDB->getTxHistory(filter, 1, N);
+        WALLET_CHECK(res.size() == 5);
+        WALLET_CHECK(res.front().m_txId[0] == 9);
+        WALLET_CHECK(res.back().m_txId[0] == 5);
+    }
+
+    // status updates and deletion are reflected by the index
+    {
+        TxID id = {};
+        id[0] = 1;
+        storage::setTxParameter(*walletDB, id, TxParameterID::Status, TxStatus::Failed, true);
+        walletDB->deleteTx(all.front().m_txId);
+
+        TxHistoryFilter filter;
+        filter.m_Status = TxStatus::Failed;
+        auto res = walletDB->getTxHistory(filter, 0, N);
+        WALLET_CHECK(res.size() == 7);
+        WALLET_CHECK(res.back().m_txId == id);
+        WALLET_CHECK(walletDB->getTxHistory(TxType::ALL).size() == N - 1);
+    }
+}
+
 int main() 
 {
     int logLevel = LOG_LEVEL_DEBUG;
@@ -1389,6 +1526,7 @@ int main()
     TestWalletDataBase();
     TestStoreCoins();
     TestStoreTxRecord();
+    TestTxHistoryPaging();
     TestTxRollback();
     TestUTXORollback();
     TestSelect();
@@ -1397,6 +1535,7 @@ int main()
     TestSelect4();
     TestSelect5();
     TestSelect6();
+    TestSelectBenchmark();
     TestAddresses();
     TestExportImportTx();
     TestTxParameters();
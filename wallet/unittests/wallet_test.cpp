@@ -706,6 +706,71 @@ namespace
         cout << "\nFinish of testing split Tx...\n";
     }
 
+    void TestConsolidation()
+    {
+        cout << "\nTesting UTXO consolidation...\n";
+
+        io::Reactor::Ptr mainReactor{ io::Reactor::create() };
+        io::Reactor::Scope scope(*mainReactor);
+
+        auto senderWalletDB = createSqliteWalletDB("sender_wallet.db", false, false);
+
+        for (Amount v = 1; v <= 30; v++)
+        {
+            Coin coin = CreateAvailCoin(v * 10, 0);
+            senderWalletDB->storeCoin(coin);
+        }
+
+        TestNode node;
+        TestWalletRig sender("sender", senderWalletDB, [](auto) { io::Reactor::get_Current().stop(); });
+
+        UtxoConsolidator::Policy policy;
+        policy.m_Enabled = true;
+        policy.m_MinInputs = 10;
+        policy.m_MaxInputs = 20;
+        policy.m_MaxCoinValue = 250;
+        policy.m_Fee = 30;
+        sender.m_Wallet.GetConsolidator().set_Policy(policy);
+
+        mainReactor->run();
+
+        auto txHistory = senderWalletDB->getTxHistory();
+        WALLET_CHECK(txHistory.size() == 1);
+        WALLET_CHECK(txHistory[0].m_status == wallet::TxStatus::Completed);
+        WALLET_CHECK(txHistory[0].m_fee == 30);
+        WALLET_CHECK(txHistory[0].m_amount == 2100 - 30); // 20 smallest coins
+
+        size_t nSpent = 0, nAvail = 0;
+        senderWalletDB->visitCoins([&](const Coin& c)->bool
+        {
+            if (Coin::Spent == c.m_status)
+            {
+                WALLET_CHECK(c.m_ID.m_Value <= 200);
+                nSpent++;
+            }
+            if (Coin::Available == c.m_status)
+                nAvail++;
+            return true;
+        });
+
+        WALLET_CHECK(nSpent == 20);
+        WALLET_CHECK(nAvail == 11);
+
+        // the policy is persistent, the fee is accounted
+        UtxoConsolidator c2(sender.m_Wallet, senderWalletDB);
+        WALLET_CHECK(c2.get_Policy().m_Enabled);
+        WALLET_CHECK(c2.get_Policy().m_MinInputs == 10);
+        WALLET_CHECK(c2.get_Policy().m_MaxInputs == 20);
+        WALLET_CHECK(c2.get_Policy().m_MaxCoinValue == 250);
+        WALLET_CHECK(c2.get_Policy().m_Fee == 30);
+        WALLET_CHECK(c2.get_Policy().m_Interval == 1);
+        sender.m_Wallet.GetConsolidator().OnSynced(); // too few coins left
+        WALLET_CHECK(sender.m_Wallet.GetConsolidator().get_FeeSpent() == 30);
+        WALLET_CHECK(senderWalletDB->getTxHistory().size() == 1);
+
+        cout << "\nFinish of testing UTXO consolidation...\n";
+    }
+
     void TestMinimalFeeTransaction()
     {
         struct ForkHolder
@@ -2304,6 +2369,65 @@ void TestKeyKeeper()
     Transaction::Context ctx(pars);
     ctx.m_Height.m_Min = hScheme;
     WALLET_CHECK(tx.IsValid(ctx));
+
+    // batch of outputs, must match the ones created one-by-one (bulletproofs are randomized, commitments aren't)
+    {
+        io::Reactor::Ptr mainReactor{ io::Reactor::create() };
+        io::Reactor::Scope scope(*mainReactor);
+
+        IPrivateKeyKeeper2::Method::CreateOutputs mB;
+        mB.m_hScheme = hScheme;
+        for (uint32_t i = 0; i < 9; i++)
+            mB.m_vCids.push_back(CoinID(100 + i, 3000 + i, Key::Type::Regular));
+
+        auto fnCheck = [&]()
+        {
+            WALLET_CHECK(mB.m_vResults.size() == mB.m_vCids.size());
+            for (size_t i = 0; i < mB.m_vCids.size(); i++)
+            {
+                IPrivateKeyKeeper2::Method::CreateOutput m;
+                m.m_Cid = mB.m_vCids[i];
+                m.m_hScheme = hScheme;
+                WALLET_CHECK(IPrivateKeyKeeper2::Status::Success == s.m_pKk->InvokeSync(m));
+
+                WALLET_CHECK(mB.m_vResults[i]);
+                WALLET_CHECK(mB.m_vResults[i]->m_Commitment == m.m_pResult->m_Commitment);
+
+                Point::Native comm;
+                WALLET_CHECK(mB.m_vResults[i]->IsValid(hScheme, comm));
+            }
+        };
+
+        WALLET_CHECK(IPrivateKeyKeeper2::Status::Success == s.m_pKk->InvokeSync(mB));
+        fnCheck();
+
+        struct MyHandler
+            :public IPrivateKeyKeeper2::Handler
+        {
+            IPrivateKeyKeeper2::Status::Type m_Status = IPrivateKeyKeeper2::Status::InProgress;
+
+            void OnDone(IPrivateKeyKeeper2::Status::Type n) override
+            {
+                m_Status = n;
+                io::Reactor::get_Current().stop();
+            }
+        };
+
+        mB.m_vResults.clear();
+        auto pHandler = std::make_shared<MyHandler>();
+        s.m_pKk->InvokeAsync(mB, pHandler);
+        mainReactor->run();
+
+        WALLET_CHECK(IPrivateKeyKeeper2::Status::Success == pHandler->m_Status);
+        fnCheck();
+
+        // weak scheme is rejected in trustless mode
+        if (Rules::get().pForks[1].m_Height)
+        {
+            mB.m_hScheme = Rules::get().pForks[1].m_Height - 1;
+            WALLET_CHECK(IPrivateKeyKeeper2::Status::Success != s.m_pKk->InvokeSync(mB));
+        }
+    }
 }
 
 
@@ -2598,6 +2722,7 @@ int main()
     }
     
     TestSplitTransaction();
+    TestConsolidation();
    
     TestMinimalFeeTransaction();
    
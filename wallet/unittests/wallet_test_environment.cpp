@@ -85,6 +85,8 @@ public:
         return res;
     }
 
+    std::vector<Coin> selectSmallestCoins(uint32_t, ECC::Amount, Asset::ID) override { return {}; }
+
     uint64_t AllocateKidRange(uint64_t nCount) override
     {
         uint64_t ret = m_KeyIndex;
@@ -112,6 +114,7 @@ public:
     void Unsubscribe(IWalletDbObserver* observer) override {}
 
     std::vector<TxDescription> getTxHistory(wallet::TxType, uint64_t, int) const override { return {}; };
+    std::vector<TxDescription> getTxHistory(const TxHistoryFilter&, uint64_t, int) const override { return {}; };
     boost::optional<TxDescription> getTx(const TxID&) const override { return boost::optional<TxDescription>{}; };
     void saveTx(const TxDescription& p) override
     {